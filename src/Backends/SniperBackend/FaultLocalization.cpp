@@ -27,7 +27,21 @@
 
 #include "FaultLocalization.h"
 
+#include <cerrno>
+#include <cstdio>
+#include <iomanip>
+#include <set>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "Logic/YicesSolver.h"
+#include "Logic/SATSolver.h"
+
 unsigned nbCallsToSolver = 0;
+unsigned nbReuseCandidates = 0;
+unsigned nbReuseHits = 0;
 
 void FaultLocalization::run(Formula *TF, Formula *preCond, Formula *postCond,
                              ProgramProfile *prof,
@@ -43,6 +57,11 @@ void FaultLocalization::run(Formula *TF, Formula *preCond, Formula *postCond,
     }
     std::vector<ProgramTrace*>
     failingTraces = prof->getFailingProgramTraces();
+    // Suspiciousness of the blocks, for the weights of the soft constraints
+    suspiciousness.clear();
+    if (options->getNbWeightLevels()>0) {
+        suspiciousness = prof->getBlockSuspiciousness();
+    }
     
     // Add the pre-conditions to the context (as hard)
     for (ExprPtr e : preCond->getExprs()) {
@@ -54,6 +73,32 @@ void FaultLocalization::run(Formula *TF, Formula *preCond, Formula *postCond,
         e->setHard();
         TF->add(e);
     }
+    // Cone-of-influence reduction: the variables of the 
+    // constraints of the traces are kept
+    unsigned nbHardCOI = 0, nbSoftCOI = 0;
+    if (options->reduceConeOfInfluence()) {
+        std::set<unsigned> vars = getTraceVariables(TF, failingTraces);
+        ConeOfInfluence::reduce(TF, vars, nbHardCOI, nbSoftCOI);
+    }
+    // Preprocessing: the shared context is used by all the traces,
+    // so only the input values common to all of them are propagated
+    unsigned nbHardPP = 0, nbSoftPP = 0;
+    if (options->preprocessFormula()) {
+        std::set<unsigned> frozen = getTraceVariables(TF, failingTraces);
+        std::map<unsigned, int> constants;
+        for (unsigned i=0; i<failingTraces.size(); i++) {
+            std::map<unsigned, int> values;
+            VariablesPtr inputs = failingTraces[i]->getInputVariables();
+            for (InputVarTracePtr v : inputs->getVector()) {
+                unsigned x = Expression::internName(v->getName());
+                if (i==0 || (constants.count(x) && constants[x]==v->getInt32())) {
+                    values[x] = v->getInt32();
+                }
+            }
+            constants = values;
+        }
+        Preprocessor::run(TF, frozen, constants, nbHardPP, nbSoftPP);
+    }
     
     if (options->verbose()) {
         std::cout << "=================================================\n";
@@ -72,16 +117,44 @@ void FaultLocalization::run(Formula *TF, Formula *preCond, Formula *postCond,
         std::cout << TF->getNbHardExpr() << std::endl;
         std::cout << "   number of soft constraints  ";
         std::cout << TF->getNbSoftExpr() << std::endl;
+        if (options->reduceConeOfInfluence()) {
+            std::cout << "   removed by the COI          ";
+            std::cout << nbHardCOI << " hard, " << nbSoftCOI << " soft\n";
+        }
+        if (options->preprocessFormula()) {
+            std::cout << "   removed by preprocessing    ";
+            std::cout << nbHardPP << " hard, " << nbSoftPP << " soft\n";
+        }
         std::cout << "   number of error-in. inputs  ";
         std::cout << failingTraces.size() << std::endl;
         std::cout << "\n\n";
     }
     // Compute the root causes (MCSes)
-    YicesSolver *yices = (YicesSolver*) solver;
-    std::vector<SetOfFormulasPtr> MCSes = allDiagnosis(TF, failingTraces, yices);
+    SolverStats::setPhase(SolverStats::MCS);
+    std::vector<SetOfFormulasPtr> MCSes = 
+        allDiagnosis(TF, failingTraces, solver);
     
     if (options->dbgMsg()) {
         std::cout << "Nb calls solver  : " << nbCallsToSolver << std::endl;
+        std::cout << "Trans. cache hits: " << solver->getNbCacheHits();
+        std::cout << " (misses: " << solver->getNbCacheMisses() << ")\n";
+        if (portfolio) {
+            portfolio->printStats(std::cout);
+        }
+    }
+    if (options->verbose() && options->reuseMCSes()) {
+        std::cout << "MCS reuse hits   : " << nbReuseHits << "/";
+        std::cout << nbReuseCandidates << " candidates";
+        if (nbReuseCandidates>0) {
+            std::cout << " (" << (100*nbReuseHits/nbReuseCandidates) << "%)";
+        }
+        std::cout << std::endl;
+    }
+    unsigned nbPartial = std::count(completeMCSes.begin(), 
+                                    completeMCSes.end(), false);
+    if (nbPartial>0) {
+        std::cout << "warning: budget exhausted, the MCSes of " << nbPartial;
+        std::cout << " failing trace(s) are partial.\n";
     }
     
     // Combination methods: PWU, MHS, FLA
@@ -93,7 +166,7 @@ void FaultLocalization::run(Formula *TF, Formula *preCond, Formula *postCond,
             break;
         case Combine::PWU:
             // Pair-wise union
-            combMCSes = Combine::combineByPWU(MCSes);
+            combMCSes = Combine::combineByPWU(MCSes, options->getNbJobs());
             break;
         case Combine::FLA:
             // Just flatten the MCSes
@@ -122,7 +195,11 @@ void FaultLocalization::run(Formula *TF, Formula *preCond, Formula *postCond,
                 std::vector<SetOfFormulasPtr>::iterator it;
                 for (it=MCSes.begin(); it!=MCSes.end(); ++it) {
                     SetOfFormulasPtr sof = *it;
-                    std::cout << sof << std::endl;
+                    std::cout << sof;
+                    if (!isComplete(std::distance(MCSes.begin(), it))) {
+                        std::cout << " (partial)";
+                    }
+                    std::cout << std::endl;
                     if (std::distance(it, MCSes.end())>1) {
                         std::cout << ", ";
                     }
@@ -133,6 +210,19 @@ void FaultLocalization::run(Formula *TF, Formula *preCond, Formula *postCond,
             std::cout << "SNIPER was unable to localize any root causes.\n";
         }
     }
+    if (DiagnosisReporter::isEnabled()) {
+        std::string method = "NONE";
+        if (combineMethod==Combine::MHS)      method = "MHS";
+        else if (combineMethod==Combine::PWU) method = "PWU";
+        else if (combineMethod==Combine::FLA) method = "FLA";
+        DiagnosisReporter::reportDiagnoses(method, combMCSes);
+        unsigned nbMCSes = 0;
+        for (SetOfFormulasPtr M : MCSes) {
+            nbMCSes += M->size();
+        }
+        DiagnosisReporter::reportDone(failingTraces.size(), nbMCSes,
+                                      combMCSes ? combMCSes->size() : 0);
+    }
     if (options->printDuration()) {
         timer.stop("\nRun AllDiagnosis Time");
     }
@@ -144,8 +234,9 @@ void FaultLocalization::run(Formula *TF, Formula *preCond, Formula *postCond,
 std::vector<SetOfFormulasPtr>
 FaultLocalization::allDiagnosis(Formula *TF,
                                  std::vector<ProgramTrace*> traces,
-                                 YicesSolver *yices) {
+                                 SolverBackend *solver) {
     std::vector<SetOfFormulasPtr> MCSes;
+    completeMCSes.clear();
     int progress = 0;
     int total = traces.size();
     // Working formula
@@ -153,6 +244,7 @@ FaultLocalization::allDiagnosis(Formula *TF,
     // For each E in WF, E tagged as soft do
     unsigned z = 0;
     std::vector<BoolVarExprPtr> AV;
+    std::vector<ExprPtr> notAV;
     std::map<BoolVarExprPtr, ExprPtr> AVMap;
     std::vector<ExprPtr> clauses = WF->getExprs();
     for(ExprPtr e : clauses) {
@@ -166,9 +258,13 @@ FaultLocalization::allDiagnosis(Formula *TF,
             AV.push_back(ai);
             AVMap[ai] = e;
             ExprPtr notai = Expression::mkNot(ai);
-            //notai->setWeight(e->getWeight());
-            notai->setLine(e->getLine());
+            if (options->getNbWeightLevels()>0) {
+                notai->setWeight(getSuspiciousnessWeight(e));
+            }
+            // setSoft takes the line of the instruction (none here)
             notai->setSoft();
+            notai->setLine(e->getLine());
+            notAV.push_back(notai);
             WF->add(notai);
             // Remove E and add EA as hard
             ExprPtr ea = Expression::mkOr(e, ai);
@@ -185,65 +281,174 @@ FaultLocalization::allDiagnosis(Formula *TF,
         }
         return MCSes;
     }
-    yices->init();
-    yices->addToContext(WF);
+    solver->init();
+    if (options->useCLD()) {
+        // The soft expressions (not ai) are only 
+        // asserted as assumptions (see allMCSByLinearSearch)
+        for (ExprPtr e : WF->getExprs()) {
+            if (e->isHard()) {
+                solver->addToContext(e);
+            }
+        }
+    } else {
+        solver->addToContext(WF);
+    }
+    // The MUSes are extracted, and the reused MCSes validated, in a 
+    // separate context without the soft expressions (see extractMUS)
+    hardSolver = NULL;
+    reusableMCSes.clear();
+    reusableKeys.clear();
+    if (options->printMUS() || options->reuseMCSes()) {
+        hardSolver = new YicesSolver();
+        hardSolver->init();
+        for (ExprPtr e : WF->getExprs()) {
+            if (e->isHard()) {
+                hardSolver->addToContext(e);
+            }
+        }
+    }
+    // The traces that executed the same path share their MCSes:
+    // only the first traces of each path class are diagnosed
+    std::vector<unsigned> ids;
+    std::vector<int> classOf(traces.size(), -1);
+    std::vector<std::vector<unsigned> > classReps;
+    const unsigned nbReps = options->getNbTraceRepresentatives();
+    bool hasPaths = false;
+    for (ProgramTrace *E : traces) {
+        hasPaths = hasPaths || E->hasPathSignature();
+    }
+    if (nbReps>0 && !hasPaths) {
+        std::cerr << "warning: -trace-reps ignored, the executed blocks ";
+        std::cerr << "were not collected (HFTF only).\n";
+    }
+    if (nbReps>0 && hasPaths) {
+        std::map<ProgramTrace*, unsigned> traceIndex;
+        for (unsigned i=0; i<traces.size(); i++) {
+            traceIndex[traces[i]] = i;
+        }
+        std::vector<std::vector<ProgramTrace*> > classes
+        = ProgramProfile::groupByPathSignature(traces);
+        classReps.resize(classes.size());
+        for (unsigned c=0; c<classes.size(); c++) {
+            for (unsigned k=0; k<classes[c].size(); k++) {
+                unsigned i = traceIndex[classes[c][k]];
+                if (k<nbReps) {
+                    classReps[c].push_back(i);
+                } else {
+                    classOf[i] = c;
+                }
+            }
+        }
+        if (options->verbose()) {
+            std::cout << "   number of path classes      ";
+            std::cout << classes.size() << std::endl;
+            std::cout << "   path class sizes            ";
+            for (std::vector<ProgramTrace*> &cl : classes) {
+                std::cout << cl.size() << " ";
+            }
+            std::cout << "\n\n";
+        }
+    }
+    for (unsigned i=0; i<traces.size(); i++) {
+        if (classOf[i]<0) {
+            ids.push_back(i);
+        }
+    }
+    // Diagnose the traces in worker processes (if any)
+    std::vector<TraceResult> results;
+    if (options->getNbJobs()>1 && ids.size()>1) {
+        results = diagnoseInWorkers(TF, traces, ids, solver, AV, notAV, AVMap);
+    }
+    std::vector<SetOfFormulasPtr> traceMCSes(traces.size());
+    std::vector<bool> traceComplete(traces.size(), true);
     for(ProgramTrace *E : traces) {
         if (options->verbose()) {
             displayProgressBar(progress, total);
         }
-        // At this point there is only WF in the context
-        yices->push();
-        // Assert as hard the error-inducing input formula
-        ExprPtr eiExpr = E->getProgramInputsFormula(TF);
-        eiExpr->setHard();
-        yices->addToContext(eiExpr);
-        if (options->dbgMsg()) {
-            std::cout << "-- Error-inducing Input: ";
-            eiExpr->dump();
-            std::cout << std::endl;
-        }
-        // Assert as hard the golden output (if any)
-        // (= return_var golden_output)
-        Value *goldenOutput = E->getExpectedOutput();
-        if (goldenOutput) {
-            BasicBlock *lastBB = &targetFun->back();
-            Instruction *lastInst = &lastBB->back();
-            if (ReturnInst *ret= dyn_cast<ReturnInst>(lastInst)) {
-                Value *retVal = ret->getReturnValue();
-                if (retVal) {
-                    ExprPtr retExpr = Expression::getExprFromValue(retVal);
-                    ExprPtr goExpr = Expression::getExprFromValue(goldenOutput);
-                    ExprPtr eqExpr = Expression::mkEq(retExpr, goExpr);
-                    eqExpr->setHard();
-                    yices->addToContext(eqExpr);
-                    if (options->dbgMsg()) {
-                        std::cout << "-- Golden ouput: ";
-                        eqExpr->dump();
-                        std::cout << std::endl;
-                    }
+        SetOfFormulasPtr M;
+        bool complete = true;
+        if (classOf[progress]>=0) {
+            // Same path as the representatives of the class:
+            // union of their MCSes, without the non-minimal ones
+            M = SetOfFormulas::make();
+            for (unsigned r : classReps[classOf[progress]]) {
+                for (FormulaPtr m : traceMCSes[r]->getFormulas()) {
+                    M->addMinimal(m);
+                }
+                complete = complete && traceComplete[r];
+            }
+            if (options->reuseMCSes() || options->getNbJobs()>1) {
+                M->sort(notAV);
+            }
+        } else if (progress<(int) results.size() && results[progress].done) {
+            // Replay the output of the worker
+            std::cout << results[progress].output;
+            nbCallsToSolver += results[progress].nbCalls;
+            nbReuseCandidates += results[progress].nbReuseCandidates;
+            nbReuseHits += results[progress].nbReuseHits;
+            size_t pos = 0;
+            SolverStats::merge(results[progress].stats, pos);
+            if (portfolio) {
+                portfolio->mergeStats(results[progress].stats, pos);
+            }
+            complete = results[progress].complete;
+            M = SetOfFormulas::make();
+            for (std::vector<unsigned> &indices : results[progress].MCSes) {
+                std::vector<ExprPtr> U;
+                for (unsigned i : indices) {
+                    U.push_back(notAV[i]);
                 }
+                M->add(std::make_shared<Formula>(U));
             }
+        } else {
+            M = diagnoseTrace(E, progress, TF, solver, AV, notAV, AVMap, 
+                              complete);
         }
-        // Compute a MCS
-        SetOfFormulasPtr M = allMinMCS(yices, AV, AVMap);
+        traceMCSes[progress] = M;
+        traceComplete[progress] = complete;
+        DiagnosisReporter::reportTrace(progress, M->size(), complete, 
+                                       classOf[progress]>=0);
         if (!M->empty()) {
             SetOfFormulasPtr M2 = avToClauses(M, AVMap);
             MCSes.push_back(M2);
+            completeMCSes.push_back(complete);
             if (options->printMCS()) {
-                std::cout << "\n" << M2 << "\n" << std::endl;
+                std::cout << "\n" << M2 << (complete ? "" : " (partial)");
+                std::cout << "\n" << std::endl;
             }
         } else {
             //if (options->verbose() || options->dbgMsg()) {
                 std::cout << "Empty MCS!\n";
             //}
         }
-        // Backtrack to the point where there
-        // was no Pre/Post-conditions in the formula
-        yices->pop();
+        if (options->printMUS()) {
+            hardSolver->push();
+            for (ExprPtr e : getTraceConstraints(E, TF)) {
+                hardSolver->addToContext(e);
+            }
+            bool minimal = true;
+            std::vector<ExprPtr> mus = extractMUS(hardSolver, notAV, &minimal);
+            hardSolver->pop();
+            if (!mus.empty()) {
+                SetOfFormulasPtr S = SetOfFormulas::make();
+                S->add(std::make_shared<Formula>(mus));
+                std::cout << "\nMUS: " << avToClauses(S, AVMap);
+                std::cout << (minimal ? "" : " (not minimal)") << "\n";
+                std::cout << std::endl;
+                DiagnosisReporter::reportMUS(progress, mus, minimal);
+            }
+        }
         // Progress bar
         progress++;
     }
-    yices->clean();
+    QueryRecorder::setTraceID(-1);
+    DiagnosisReporter::setTraceID(-1);
+    solver->clean();
+    if (hardSolver) {
+        hardSolver->clean();
+        delete hardSolver;
+        hardSolver = NULL;
+    }
     delete WF;
     if (options->verbose()) {
         displayProgressBar(progress, total);
@@ -252,23 +457,538 @@ FaultLocalization::allDiagnosis(Formula *TF,
     return MCSes;
 }
 
+SetOfFormulasPtr
+FaultLocalization::diagnoseTrace(ProgramTrace *E, unsigned id, Formula *TF,
+                                 SolverBackend *solver,
+                                 std::vector<BoolVarExprPtr> &AV,
+                                 std::vector<ExprPtr> &notAV,
+                                 std::map<BoolVarExprPtr, ExprPtr> &AVMap,
+                                 bool &complete) {
+    const bool incremental = options->incremental();
+    QueryRecorder::setTraceID(id);
+    DiagnosisReporter::setTraceID(id);
+    // In incremental mode, the constraints of the trace are 
+    // guarded by a selector that is only enabled for this trace,
+    // so that the solver state is kept from one trace to another
+    BoolVarExprPtr sel = NULL;
+    if (incremental) {
+        std::ostringstream oss;
+        oss << id;
+        sel = Expression::mkBoolVar("sel_"+oss.str());
+    } else {
+        // At this point there is only WF in the context
+        solver->push();
+    }
+    // Assert as hard the error-inducing input formula
+    // and the golden output (if any)
+    for (ExprPtr e : getTraceConstraints(E, TF)) {
+        solver->addToContext(guardBySelector(e, sel));
+    }
+    // Restrict the formula to the executed path (if known)
+    std::vector<BoolVarExprPtr> pathAV = AV;
+    std::vector<ExprPtr> pathNotAV = notAV;
+    std::vector<ExprPtr> offPath;
+    std::set<BasicBlock*> executed = E->getExecutedBB();
+    if (options->slicePaths() && !executed.empty()) {
+        pathAV.clear();
+        pathNotAV.clear();
+        offPath = getOffPathConstraints(executed, AV, notAV, pathAV, pathNotAV);
+        for (ExprPtr e : offPath) {
+            solver->addToContext(guardBySelector(e, sel));
+        }
+        if (options->dbgMsg()) {
+            std::cout << "-- Path slice: " << pathAV.size() << "/";
+            std::cout << AV.size() << " soft constraints\n";
+        }
+    }
+    // Enable the trace selector
+    SolverBackend::AssertionID selID = 0;
+    if (incremental) {
+        selID = solver->addRetractable(sel);
+    }
+    // Reuse the MCSes of the previous traces: the validated ones
+    // are blocked, only the other ones are enumerated
+    SetOfFormulasPtr M = SetOfFormulas::make();
+    if (options->reuseMCSes() && options->getMaxNbDiagnoses()==0) {
+        std::vector<std::vector<ExprPtr> > reused;
+        reused = reuseMCSes(E, TF, notAV, pathNotAV, offPath);
+        for (std::vector<ExprPtr> &U : reused) {
+            ExprPtr blockFormula = Expression::mkOr(U);
+            blockFormula->setHard();
+            solver->addToContext(guardBySelector(blockFormula, sel));
+            M->add(std::make_shared<Formula>(U));
+            DiagnosisReporter::reportMCS(U);
+        }
+    }
+    // Compute the other MCSes
+    SetOfFormulasPtr M2 = boundedMCS(solver, pathAV, AVMap, pathNotAV, sel,
+                                     &complete);
+    for (FormulaPtr m : M2->getFormulas()) {
+        M->add(m);
+    }
+    // Canonical order, so that the reused MCSes and the 
+    // worker processes do not change the output (otherwise, 
+    // the order of the enumeration is kept)
+    if (options->reuseMCSes() || options->getNbJobs()>1) {
+        M->sort(notAV);
+    }
+    // Candidates for the next traces
+    if (options->reuseMCSes()) {
+        for (FormulaPtr m : M->getFormulas()) {
+            std::vector<ExprPtr> U = m->getExprs();
+            std::sort(U.begin(), U.end());
+            if (reusableKeys.insert(U).second) {
+                reusableMCSes.push_back(m->getExprs());
+            }
+        }
+    }
+    if (incremental) {
+        // Disable the trace selector for good: the constraints
+        // and blocking clauses of the trace are now satisfied
+        solver->retract(selID);
+        ExprPtr notSel = Expression::mkNot(sel);
+        notSel->setHard();
+        solver->addToContext(notSel);
+    } else {
+        // Backtrack to the point where there
+        // was no Pre/Post-conditions in the formula
+        solver->pop();
+    }
+    return M;
+}
+
+std::vector<ExprPtr>
+FaultLocalization::getTraceConstraints(ProgramTrace *E, Formula *TF) {
+    std::vector<ExprPtr> exprs;
+    // Error-inducing input formula
+    ExprPtr eiExpr = E->getProgramInputsFormula(TF);
+    eiExpr->setHard();
+    exprs.push_back(eiExpr);
+    if (options->dbgMsg()) {
+        std::cout << "-- Error-inducing Input: ";
+        eiExpr->dump();
+        std::cout << std::endl;
+    }
+    // Golden output (if any)
+    // (= return_var golden_output)
+    Value *goldenOutput = E->getExpectedOutput();
+    if (goldenOutput) {
+        BasicBlock *lastBB = &targetFun->back();
+        Instruction *lastInst = &lastBB->back();
+        if (ReturnInst *ret= dyn_cast<ReturnInst>(lastInst)) {
+            Value *retVal = ret->getReturnValue();
+            if (retVal) {
+                ExprPtr retExpr = Expression::getExprFromValue(retVal);
+                ExprPtr goExpr = Expression::getExprFromValue(goldenOutput);
+                ExprPtr eqExpr = Expression::mkEq(retExpr, goExpr);
+                eqExpr->setHard();
+                exprs.push_back(eqExpr);
+                if (options->dbgMsg()) {
+                    std::cout << "-- Golden ouput: ";
+                    eqExpr->dump();
+                    std::cout << std::endl;
+                }
+            }
+        }
+    }
+    return exprs;
+}
+
+std::vector<std::vector<ExprPtr> >
+FaultLocalization::reuseMCSes(ProgramTrace *E, Formula *TF,
+                              std::vector<ExprPtr> &notAV,
+                              std::vector<ExprPtr> &softs,
+                              std::vector<ExprPtr> &offPath) {
+    std::vector<std::vector<ExprPtr> > hits;
+    if (reusableMCSes.empty()) {
+        return hits;
+    }
+    std::set<Expression*> inSofts;
+    for (ExprPtr e : softs) {
+        inSofts.insert(e.get());
+    }
+    hardSolver->push();
+    for (ExprPtr e : getTraceConstraints(E, TF)) {
+        hardSolver->addToContext(e);
+    }
+    for (ExprPtr e : offPath) {
+        hardSolver->addToContext(e);
+    }
+    for (std::vector<ExprPtr> &U : reusableMCSes) {
+        // The candidate has to be in the bounds of the enumeration
+        bool valid = U.size()<=options->mcsMaxSize();
+        for (unsigned i=0; valid && i<U.size(); i++) {
+            valid = inSofts.count(U[i].get())>0;
+        }
+        if (!valid) {
+            continue;
+        }
+        nbReuseCandidates++;
+        if (isMCS(hardSolver, U, notAV)) {
+            nbReuseHits++;
+            hits.push_back(U);
+        }
+    }
+    hardSolver->pop();
+    return hits;
+}
+
+bool FaultLocalization::isMCS(SolverBackend *solver, std::vector<ExprPtr> &U,
+                              std::vector<ExprPtr> &notAV) {
+    std::set<Expression*> inU;
+    for (ExprPtr e : U) {
+        inU.insert(e.get());
+    }
+    // The complement of U is satisfiable
+    std::vector<SolverBackend::AssertionID> ids;
+    for (ExprPtr e : notAV) {
+        if (!inU.count(e.get())) {
+            ids.push_back(solver->addRetractable(e));
+        }
+    }
+    nbCallsToSolver++;
+    bool res = solver->check()==SolverBackend::True;
+    // Minimality: the complement with any expression of U is unsatisfiable
+    for (unsigned i=0; res && i<U.size(); i++) {
+        SolverBackend::AssertionID id = solver->addRetractable(U[i]);
+        nbCallsToSolver++;
+        res = solver->check()==SolverBackend::False;
+        solver->retract(id);
+    }
+    for (SolverBackend::AssertionID id : ids) {
+        solver->retract(id);
+    }
+    return res;
+}
+
+std::set<unsigned> 
+FaultLocalization::getTraceVariables(Formula *TF, 
+                                     std::vector<ProgramTrace*> &traces) {
+    std::set<unsigned> vars;
+    // Error-inducing inputs and golden outputs
+    for (ProgramTrace *E : traces) {
+        ExprPtr eiExpr = E->getProgramInputsFormula(TF);
+        if (eiExpr) {
+            ConeOfInfluence::getVariables(eiExpr, vars);
+        }
+        if (E->getExpectedOutput()) {
+            Instruction *lastInst = &targetFun->back().back();
+            if (ReturnInst *ret = dyn_cast<ReturnInst>(lastInst)) {
+                if (Value *retVal = ret->getReturnValue()) {
+                    ExprPtr retExpr = Expression::getExprFromValue(retVal);
+                    ConeOfInfluence::getVariables(retExpr, vars);
+                }
+            }
+        }
+    }
+    // Transitions (see getOffPathConstraints)
+    if (options->slicePaths()) {
+        for (Function::iterator i=targetFun->begin(), e=targetFun->end(); i!=e; ++i) {
+            BasicBlock *bb = i;
+            for (pred_iterator PI = pred_begin(bb), E = pred_end(bb); PI != E; ++PI) {
+                BasicBlock *predbb = *PI;
+                std::string name = predbb->getName().str()+"_"+bb->getName().str();
+                vars.insert(Expression::internName(name));
+            }
+        }
+    }
+    return vars;
+}
+
+std::vector<ExprPtr>
+FaultLocalization::getOffPathConstraints(std::set<BasicBlock*> &executed,
+                                         std::vector<BoolVarExprPtr> &AV,
+                                         std::vector<ExprPtr> &notAV,
+                                         std::vector<BoolVarExprPtr> &pathAV,
+                                         std::vector<ExprPtr> &pathNotAV) {
+    std::vector<ExprPtr> exprs;
+    // The transitions from or to a block that was not
+    // executed are disabled: (not t(b',b))
+    for (Function::iterator i=targetFun->begin(), e=targetFun->end(); i!=e; ++i) {
+        BasicBlock *bb = i;
+        for (pred_iterator PI = pred_begin(bb), E = pred_end(bb); PI != E; ++PI) {
+            BasicBlock *predbb = *PI;
+            if (executed.count(predbb) && executed.count(bb)) {
+                continue;
+            }
+            std::string name = predbb->getName().str()+"_"+bb->getName().str();
+            ExprPtr notTrans = Expression::mkNot(Expression::mkBoolVar(name));
+            notTrans->setHard();
+            exprs.push_back(notTrans);
+        }
+    }
+    // The soft expressions of the blocks that were not executed
+    // are assumed (not ai), the other ones are kept
+    for (unsigned i=0; i<AV.size(); i++) {
+        Instruction *I = AV[i]->getInstruction();
+        if (!I || executed.count(I->getParent())) {
+            pathAV.push_back(AV[i]);
+            pathNotAV.push_back(notAV[i]);
+        } else {
+            ExprPtr notai = Expression::mkNot(AV[i]);
+            notai->setHard();
+            exprs.push_back(notai);
+        }
+    }
+    return exprs;
+}
+
+// Write the whole buffer in fd
+static bool writeAll(int fd, const char *buf, size_t size) {
+    while (size>0) {
+        ssize_t n = write(fd, buf, size);
+        if (n<0 && errno==EINTR) {
+            continue;
+        }
+        if (n<=0) {
+            return false;
+        }
+        buf  += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Append an unsigned to msg
+static void appendUnsigned(std::string &msg, unsigned v) {
+    msg.append((const char*) &v, sizeof(v));
+}
+
+// Read an unsigned from msg at pos (false if out of bound)
+static bool readUnsigned(const std::string &msg, size_t &pos, unsigned &v) {
+    if (pos+sizeof(v)>msg.size()) {
+        return false;
+    }
+    msg.copy((char*) &v, sizeof(v), pos);
+    pos += sizeof(v);
+    return true;
+}
+
+std::vector<FaultLocalization::TraceResult>
+FaultLocalization::diagnoseInWorkers(Formula *TF,
+                                     std::vector<ProgramTrace*> &traces,
+                                     std::vector<unsigned> &ids,
+                                     SolverBackend *solver,
+                                     std::vector<BoolVarExprPtr> &AV,
+                                     std::vector<ExprPtr> &notAV,
+                                     std::map<BoolVarExprPtr, ExprPtr> &AVMap) {
+    std::vector<TraceResult> results(traces.size());
+    unsigned nbJobs = std::min<size_t>(options->getNbJobs(), ids.size());
+    // The buffered output would be duplicated in the workers
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(NULL);
+    // Launch the workers, the worker k diagnoses 
+    // the traces ids[k], ids[k+nbJobs], ids[k+2*nbJobs]...
+    std::vector<pid_t> pids;
+    std::vector<int> fds;
+    for (unsigned k=0; k<nbJobs; k++) {
+        int p[2];
+        if (pipe(p)!=0) {
+            break;
+        }
+        pid_t pid = fork();
+        if (pid<0) {
+            close(p[0]);
+            close(p[1]);
+            break;
+        }
+        if (pid==0) {
+            // Worker
+            close(p[0]);
+            for (int fd : fds) {
+                close(fd);
+            }
+            std::map<Expression*, unsigned> index;
+            for (unsigned i=0; i<notAV.size(); i++) {
+                index[notAV[i].get()] = i;
+            }
+            for (unsigned j=k; j<ids.size(); j+=nbJobs) {
+                const unsigned id = ids[j];
+                // Capture the output of the trace
+                std::ostringstream out;
+                out.copyfmt(std::cout);
+                if (options->verbose()) {
+                    // As after displayProgressBar
+                    out << std::setprecision(2) << std::fixed;
+                }
+                std::streambuf *old = std::cout.rdbuf(out.rdbuf());
+                unsigned nbCalls = nbCallsToSolver;
+                unsigned nbCandidates = nbReuseCandidates;
+                unsigned nbHits = nbReuseHits;
+                // Only the statistics of this trace are sent back
+                const unsigned phase = SolverStats::getPhase();
+                SolverStats::reset();
+                SolverStats::setPhase(phase);
+                if (portfolio) {
+                    portfolio->resetStats();
+                }
+                bool complete = true;
+                SetOfFormulasPtr M = diagnoseTrace(traces[id], id, TF, solver, 
+                                                   AV, notAV, AVMap, complete);
+                std::cout.rdbuf(old);
+                std::string stats;
+                SolverStats::save(stats);
+                if (portfolio) {
+                    portfolio->saveStats(stats);
+                }
+                // Answer: trace, completeness, number of solver calls,
+                // reuse statistics, solver and portfolio statistics,
+                // output, and the indices of the MCSes
+                std::string msg;
+                appendUnsigned(msg, id);
+                appendUnsigned(msg, complete);
+                appendUnsigned(msg, nbCallsToSolver-nbCalls);
+                appendUnsigned(msg, nbReuseCandidates-nbCandidates);
+                appendUnsigned(msg, nbReuseHits-nbHits);
+                appendUnsigned(msg, stats.size());
+                msg.append(stats);
+                appendUnsigned(msg, out.str().size());
+                msg.append(out.str());
+                std::vector<FormulaPtr> formulas = M->getFormulas();
+                appendUnsigned(msg, formulas.size());
+                for (FormulaPtr f : formulas) {
+                    std::vector<ExprPtr> U = f->getExprs();
+                    appendUnsigned(msg, U.size());
+                    for (ExprPtr e : U) {
+                        assert(index.count(e.get()) && "Unknown soft expression!");
+                        appendUnsigned(msg, index[e.get()]);
+                    }
+                }
+                if (!writeAll(p[1], msg.data(), msg.size())) {
+                    break;
+                }
+            }
+            close(p[1]);
+            _exit(0);
+        }
+        close(p[1]);
+        pids.push_back(pid);
+        fds.push_back(p[0]);
+    }
+    // Read the answers of all the workers
+    std::vector<std::string> buffers(fds.size());
+    std::vector<bool> running(fds.size(), true);
+    unsigned nbRunning = fds.size();
+    while (nbRunning>0) {
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        int maxfd = -1;
+        for (unsigned i=0; i<fds.size(); i++) {
+            if (running[i]) {
+                FD_SET(fds[i], &rfds);
+                if (fds[i]>maxfd) maxfd = fds[i];
+            }
+        }
+        if (select(maxfd+1, &rfds, NULL, NULL, NULL)<0) {
+            if (errno==EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (unsigned i=0; i<fds.size(); i++) {
+            if (!running[i] || !FD_ISSET(fds[i], &rfds)) {
+                continue;
+            }
+            char buf[4096];
+            ssize_t n = read(fds[i], buf, sizeof(buf));
+            if (n>0) {
+                buffers[i].append(buf, n);
+            } else if (n==0 || errno!=EINTR) {
+                running[i] = false;
+                nbRunning--;
+            }
+        }
+    }
+    for (unsigned i=0; i<pids.size(); i++) {
+        close(fds[i]);
+        waitpid(pids[i], NULL, 0);
+    }
+    // Decode the answers, the traces of a failed 
+    // worker are left to the current process
+    for (const std::string &msg : buffers) {
+        size_t pos = 0;
+        while (pos<msg.size()) {
+            unsigned id, complete, nbCalls, nbCandidates, nbHits;
+            unsigned statsSize, outSize, nbMCSes;
+            if (!readUnsigned(msg, pos, id) || id>=traces.size()
+                || !readUnsigned(msg, pos, complete)
+                || !readUnsigned(msg, pos, nbCalls)
+                || !readUnsigned(msg, pos, nbCandidates)
+                || !readUnsigned(msg, pos, nbHits)
+                || !readUnsigned(msg, pos, statsSize)
+                || pos+statsSize>msg.size()) {
+                break;
+            }
+            TraceResult r;
+            r.stats = msg.substr(pos, statsSize);
+            pos += statsSize;
+            if (!readUnsigned(msg, pos, outSize) || pos+outSize>msg.size()) {
+                break;
+            }
+            r.output = msg.substr(pos, outSize);
+            pos += outSize;
+            r.complete = complete;
+            r.nbCalls = nbCalls;
+            r.nbReuseCandidates = nbCandidates;
+            r.nbReuseHits = nbHits;
+            bool ok = readUnsigned(msg, pos, nbMCSes);
+            for (unsigned j=0; j<nbMCSes && ok; j++) {
+                unsigned size;
+                ok = readUnsigned(msg, pos, size);
+                std::vector<unsigned> indices;
+                for (unsigned k=0; k<size && ok; k++) {
+                    unsigned i;
+                    ok = readUnsigned(msg, pos, i) && i<notAV.size();
+                    indices.push_back(i);
+                }
+                r.MCSes.push_back(indices);
+            }
+            if (!ok) {
+                break;
+            }
+            r.done = true;
+            results[id] = r;
+        }
+    }
+    return results;
+}
+
 SetOfFormulasPtr 
-FaultLocalization::allMinMCS(YicesSolver *yices,
+FaultLocalization::allMinMCS(SolverBackend *solver,
                               std::vector<BoolVarExprPtr> &AV,
-                              std::map<BoolVarExprPtr, ExprPtr> &AVMap) {
+                              std::map<BoolVarExprPtr, ExprPtr> &AVMap,
+                              BoolVarExprPtr sel,
+                              bool *complete,
+                              unsigned maxNb) {
     SetOfFormulasPtr MCSes = SetOfFormulas::make();
+    const double startTime = SolverStats::getTime();
     bool done = false;
-    while (!done) {
+    if (complete) {
+        *complete = true;
+    }
+    while (!done && (maxNb==0 || MCSes->size()<maxNb)) {
+        if (!setQueryBudget(startTime)) {
+            if (complete) {
+                *complete = false;
+            }
+            break;
+        }
         nbCallsToSolver++;
-        switch(yices->maxSat()) {
-            case l_true: {
-                // Debug
-                if (options->checkCFGModel()) {
-                    checkControlFlow(yices);
+        // Race the portfolio workers (if any)
+        const int res = portfolio 
+            ? portfolio->maxSat(solver) : solver->maxSat();
+        switch(res) {
+            case SolverBackend::True: {
+                // Debug (the model of a portfolio worker is not available)
+                if (options->checkCFGModel() && !portfolio) {
+                    checkControlFlow(solver);
                 }
                 // U is a Minimal Correction Subset
                 // (MCS) if st is true
-                std::vector<ExprPtr> U = solver->getUnsatExpressions();
+                std::vector<ExprPtr> U = portfolio
+                ? portfolio->getUnsatExpressions()
+                : solver->getUnsatExpressions();
                 if (U.empty()) { // SAT
                     done = true;
                     break;
@@ -276,37 +996,20 @@ FaultLocalization::allMinMCS(YicesSolver *yices,
                 // Add the blocking constraint to block the last solution
                 ExprPtr blockFormula = Expression::mkOr(U);
                 blockFormula->setHard();
-                yices->addToContext(blockFormula);
+                solver->addToContext(guardBySelector(blockFormula, sel));
                 
                 // Save the MCSes
                 FormulaPtr m = std::make_shared<Formula>(U);
                 MCSes->add(m);
-                
-                // Save the line numbers
-                /*MCSPtr M;
-                for (ExprPtr notAi : U) {
-                    //M.insert(AVMap[ai]->getLine());
-                    //M.insert(ai->getLine());
-                    if (options->getTestSuiteFileName().empty()) {
-                        M.insert(notAi->getLine());
-                    } else {
-                        // FOR TCAS
-                        if (notAi->getLine()<160) {
-                            M.insert(notAi->getLine());
-                        }
-                    }
-                }
-                if (!M.empty()) {
-                    // Bound MCS size
-                    if (M.size()<=options->mcsMaxSize()) {
-                         MCSes->add(M);
-                    }
-                }*/
+                DiagnosisReporter::reportMCS(U);
             } break;
-            case l_false: // unsatisfiable
+            case SolverBackend::False: // unsatisfiable
                 done = true;
                 break;
-            case l_undef: // unknown
+            case SolverBackend::Undef: // unknown or budget exhausted
+                if (complete) {
+                    *complete = false;
+                }
                 done = true;
                 break;
         }
@@ -314,6 +1017,334 @@ FaultLocalization::allMinMCS(YicesSolver *yices,
     return MCSes;
 }
 
+bool FaultLocalization::setQueryBudget(double startTime) {
+    if (!portfolio) {
+        return true;
+    }
+    // Budget of the query: the per-query budget, 
+    // bounded by what is left of the trace budget
+    double budget = options->getSolverTimeout();
+    if (options->getTraceTimeout()>0) {
+        double left = startTime+options->getTraceTimeout()
+        -SolverStats::getTime();
+        if (left<=0) {
+            return false;
+        }
+        if (budget==0 || left<budget) {
+            budget = left;
+        }
+    }
+    portfolio->setTimeout(budget);
+    return true;
+}
+
+int FaultLocalization::budgetedCheck(SolverBackend *solver, 
+                                double startTime,
+                                std::vector<ExprPtr> &exprs,
+                                std::vector<ExprPtr> &falsified,
+                                std::vector<SolverBackend::AssertionID> &core) {
+    falsified.clear();
+    core.clear();
+    if (!setQueryBudget(startTime)) {
+        return SolverBackend::Undef;
+    }
+    nbCallsToSolver++;
+    if (portfolio && portfolio->hasBudget()) {
+        return portfolio->check(solver, exprs, falsified, core);
+    }
+    int res = solver->check();
+    if (res==SolverBackend::True) {
+        for (ExprPtr e : exprs) {
+            if (solver->evaluate(e)==SolverBackend::False) {
+                falsified.push_back(e);
+            }
+        }
+    } else if (res==SolverBackend::False) {
+        core = solver->getUnsatCore();
+    }
+    return res;
+}
+
+SetOfFormulasPtr 
+FaultLocalization::allMCSByLinearSearch(SolverBackend *solver,
+                                        std::vector<ExprPtr> &softs,
+                                        BoolVarExprPtr sel,
+                                        bool *complete,
+                                        unsigned maxNb) {
+    SetOfFormulasPtr MCSes = SetOfFormulas::make();
+    const double startTime = SolverStats::getTime();
+    if (complete) {
+        *complete = true;
+    }
+    std::vector<SolverBackend::AssertionID> core;
+    int res = SolverBackend::True;
+    while (res==SolverBackend::True && (maxNb==0 || MCSes->size()<maxNb)) {
+        // Find an assignment of the hard constraints 
+        // (with the blocking clauses)
+        std::vector<ExprPtr> U;
+        res = budgetedCheck(solver, startTime, softs, U, core);
+        if (res!=SolverBackend::True) {
+            break;
+        }
+        // Split the soft expressions into satisfied (S) 
+        // and falsified (U) ones
+        std::set<ExprPtr> inU(U.begin(), U.end());
+        std::vector<ExprPtr> S;
+        for (ExprPtr e : softs) {
+            if (!inU.count(e)) {
+                S.push_back(e);
+            }
+        }
+        // Grow S: while a model of (S and D) exists, with D the 
+        // clause (or U), move the satisfied expressions of U to S
+        std::vector<SolverBackend::AssertionID> ids;
+        for (ExprPtr e : S) {
+            ids.push_back(solver->addRetractable(e));
+        }
+        while (!U.empty()) {
+            ExprPtr D = Expression::mkOr(U);
+            D->setHard();
+            SolverBackend::AssertionID dID = solver->addRetractable(D);
+            std::vector<ExprPtr> U2;
+            res = budgetedCheck(solver, startTime, U, U2, core);
+            if (res!=SolverBackend::True) {
+                solver->retract(dID);
+                break;
+            }
+            std::set<ExprPtr> inU2(U2.begin(), U2.end());
+            for (ExprPtr e : U) {
+                if (!inU2.count(e)) {
+                    ids.push_back(solver->addRetractable(e));
+                }
+            }
+            solver->retract(dID);
+            U = U2;
+        }
+        for (SolverBackend::AssertionID i : ids) {
+            solver->retract(i);
+        }
+        if (U.empty()) { // SAT
+            res = SolverBackend::False;
+            break;
+        }
+        if (res==SolverBackend::Undef) {
+            break;
+        }
+        // U is a MCS (its complement S is a maximal satisfiable 
+        // subset), block it
+        res = SolverBackend::True;
+        ExprPtr blockFormula = Expression::mkOr(U);
+        blockFormula->setHard();
+        solver->addToContext(guardBySelector(blockFormula, sel));
+        FormulaPtr m = std::make_shared<Formula>(U);
+        MCSes->add(m);
+        DiagnosisReporter::reportMCS(U);
+    }
+    if (res==SolverBackend::Undef && complete) {
+        *complete = false;
+    }
+    return MCSes;
+}
+
+std::vector<ExprPtr> 
+FaultLocalization::extractMUS(SolverBackend *solver,
+                              std::vector<ExprPtr> &softs,
+                              bool *complete) {
+    const double startTime = SolverStats::getTime();
+    if (complete) {
+        *complete = true;
+    }
+    // Candidates (unknown status) and critical expressions: 
+    // every MUS of candidates+critical contains critical
+    std::vector<ExprPtr> candidates = softs;
+    std::vector<ExprPtr> critical;
+    bool first = true;
+    while (!candidates.empty()) {
+        // Remove the last candidate (except for the first check)
+        ExprPtr c = NULL;
+        if (!first) {
+            c = candidates.back();
+            candidates.pop_back();
+        }
+        // Assume the remaining expressions
+        std::map<SolverBackend::AssertionID, ExprPtr> assumed;
+        for (ExprPtr e : critical) {
+            assumed[solver->addRetractable(e)] = e;
+        }
+        for (ExprPtr e : candidates) {
+            assumed[solver->addRetractable(e)] = e;
+        }
+        std::vector<ExprPtr> none, falsified;
+        std::vector<SolverBackend::AssertionID> core;
+        const int res = budgetedCheck(solver, startTime, none, falsified, core);
+        std::map<SolverBackend::AssertionID, ExprPtr>::iterator it;
+        for (it=assumed.begin(); it!=assumed.end(); ++it) {
+            solver->retract(it->first);
+        }
+        if (res==SolverBackend::Undef) {
+            if (c) {
+                candidates.push_back(c);
+            }
+            break;
+        }
+        if (first && res==SolverBackend::True) { // not a failing trace
+            return std::vector<ExprPtr>();
+        }
+        first = false;
+        if (res==SolverBackend::True) {
+            // Every subset without c is satisfiable
+            critical.push_back(c);
+            continue;
+        }
+        // Clause-set refinement: the candidates 
+        // outside of the core are not needed
+        std::set<ExprPtr> inCore;
+        for (SolverBackend::AssertionID id : core) {
+            it = assumed.find(id);
+            if (it!=assumed.end()) {
+                inCore.insert(it->second);
+            }
+        }
+        std::vector<ExprPtr> refined;
+        for (ExprPtr e : candidates) {
+            if (inCore.count(e)) {
+                refined.push_back(e);
+            }
+        }
+        candidates = refined;
+    }
+    if (!candidates.empty()) {
+        // Stopped: an unsatisfiable, but maybe not minimal, subset
+        if (complete) {
+            *complete = false;
+        }
+        critical.insert(critical.end(), candidates.begin(), candidates.end());
+    }
+    return critical;
+}
+
+SetOfFormulasPtr 
+FaultLocalization::boundedMCS(SolverBackend *solver,
+                              std::vector<BoolVarExprPtr> &AV,
+                              std::map<BoolVarExprPtr, ExprPtr> &AVMap,
+                              std::vector<ExprPtr> &notAV,
+                              BoolVarExprPtr sel,
+                              bool *complete) {
+    const unsigned maxSize = options->mcsMaxSize();
+    const unsigned maxNb = options->getMaxNbDiagnoses();
+    const unsigned nbStrata = std::max(options->getNbWeightLevels(), 1u);
+    if (maxSize>=AV.size() && maxNb==0 && nbStrata==1) { // no bound
+        return options->useCLD()
+        ? allMCSByLinearSearch(solver, notAV, sel, complete)
+        : allMinMCS(solver, AV, AVMap, sel, complete);
+    }
+    SetOfFormulasPtr MCSes = SetOfFormulas::make();
+    if (complete) {
+        *complete = true;
+    }
+    bool done = false;
+    // Stratification: at the stratum s, only the soft expressions 
+    // of weight at most s (the most suspicious ones) can be falsified, 
+    // the other ones are assumed. The last stratum has no assumption,
+    // so that all the MCSes are eventually found.
+    for (unsigned s=1; s<=nbStrata && !done; s++) {
+        bool relaxable = false;
+        for (ExprPtr e : notAV) {
+            relaxable = relaxable || e->getWeight()==s;
+        }
+        if (!relaxable && s<nbStrata) { // same as the previous stratum
+            continue;
+        }
+        std::vector<SolverBackend::AssertionID> assumed;
+        for (ExprPtr e : notAV) {
+            if (e->getWeight()>s) {
+                assumed.push_back(solver->addRetractable(e));
+            }
+        }
+        // The max-sat engine already finds the MCSes by increasing size
+        // with unit weights, so a single bound is enough. With weights,
+        // it finds them by increasing weight, and the linear search 
+        // finds them in any order: for the first diagnoses of each 
+        // stratum to be the smallest, the bound is increased one 
+        // size at a time.
+        const unsigned last = std::min<unsigned>(maxSize, AV.size());
+        const bool bySize = options->useCLD() || nbStrata>1;
+        unsigned k = (bySize && maxNb>0) ? 1 : last;
+        for (; k<=last; k++) {
+            SolverBackend::AssertionID boundID = 0;
+            if (k<AV.size()) {
+                boundID = solver->addRetractable(mkCardinalityBound(AV, k));
+            }
+            const unsigned left = maxNb==0 ? 0 : maxNb-MCSes->size();
+            bool levelComplete = true;
+            SetOfFormulasPtr M = options->useCLD()
+            ? allMCSByLinearSearch(solver, notAV, sel, &levelComplete, left)
+            : allMinMCS(solver, AV, AVMap, sel, &levelComplete, left);
+            if (k<AV.size()) {
+                solver->retract(boundID);
+            }
+            for (FormulaPtr m : M->getFormulas()) {
+                MCSes->add(m);
+            }
+            if (!levelComplete) {
+                if (complete) {
+                    *complete = false;
+                }
+                done = true;
+                break;
+            }
+            if (maxNb>0 && MCSes->size()>=maxNb) {
+                done = true;
+                break;
+            }
+        }
+        for (SolverBackend::AssertionID id : assumed) {
+            solver->retract(id);
+        }
+    }
+    return MCSes;
+}
+
+unsigned FaultLocalization::getSuspiciousnessWeight(ExprPtr e) {
+    const unsigned nbLevels = options->getNbWeightLevels();
+    double susp = 0;
+    Instruction *I = e->getInstruction();
+    if (I) {
+        std::map<BasicBlock*, double>::iterator it;
+        it = suspiciousness.find(I->getParent());
+        if (it!=suspiciousness.end()) {
+            susp = it->second;
+        }
+    }
+    // From 1 (suspiciousness 1) to nbLevels (suspiciousness 0)
+    unsigned w = 1 + (unsigned) (nbLevels*(1-susp));
+    return std::min(w, nbLevels);
+}
+
+ExprPtr FaultLocalization::mkCardinalityBound(std::vector<BoolVarExprPtr> &AV,
+                                              unsigned k) {
+    // (<= (+ (ite a_1 1 0) ... (ite a_n 1 0)) k)
+    ExprPtr one = Expression::mkSInt32Num(1);
+    ExprPtr zero = Expression::mkSInt32Num(0);
+    std::vector<ExprPtr> terms;
+    for (BoolVarExprPtr ai : AV) {
+        terms.push_back(Expression::mkIte(ai, one, zero));
+    }
+    ExprPtr bound = Expression::mkLe(Expression::mkSum(terms),
+                                     Expression::mkSInt32Num(k));
+    bound->setHard();
+    return bound;
+}
+
+ExprPtr FaultLocalization::guardBySelector(ExprPtr e, BoolVarExprPtr sel) {
+    if (!sel) {
+        return e;
+    }
+    ExprPtr guarded = Expression::mkOr(Expression::mkNot(sel), e);
+    guarded->setHard();
+    return guarded;
+}
+
 SetOfFormulasPtr
 FaultLocalization::avToClauses(SetOfFormulasPtr M,
                                 std::map<BoolVarExprPtr, ExprPtr> AVMap) {
@@ -340,85 +1371,100 @@ FaultLocalization::avToClauses(SetOfFormulasPtr M,
     return M2;
 }
 
-void FaultLocalization::checkControlFlow(YicesSolver *solver) {
+void FaultLocalization::checkControlFlow(SolverBackend *solver) {
     std::cout << "Checking control flow...";
     assert(solver && "Solver is null!");
-    // Iterate over basic blocks of the main function
+    // Propositional skeleton of the CFG over the block transitions,
+    // constrained by the values of the transitions in the model
+    SATSolver *skeleton = new SATSolver();
+    skeleton->init();
+    std::vector<ExprPtr> exprs;
     for (Function::iterator i=targetFun->begin(), e=targetFun->end(); i!=e; ++i) {
         BasicBlock *bb = i;
-        // Get the values of the predecessor transitions
-        unsigned nbPredTrans      = 0;
-        unsigned nbTruePredTrans  = 0;
-        unsigned nbUndefPredTrans = 0;
+        // The block is executed if one of its predecessor transitions
+        // is taken (the entry block doesn't have any predecessors), 
+        // and at most one of them is taken
+        std::vector<ExprPtr> predTrans;
         for (pred_iterator PI = pred_begin(bb), E = pred_end(bb); PI != E; ++PI) {
-            BasicBlock *predbb = *PI;
-            int val = getBlockTransVal(solver, predbb, bb);
-            if (val==l_true) {
-                nbTruePredTrans++;
-            }
-            else if (val==l_undef) {
-                nbUndefPredTrans++;
-            }
-            nbPredTrans++;
+            predTrans.push_back(getBlockTransVar(*PI, bb));
         }
-        assert((nbTruePredTrans==0 || nbTruePredTrans==1) 
-                && "Invalid control flow value!");
-        if (nbPredTrans==0) { // Entry block doesn't have any predecessors
-            nbTruePredTrans = 1;
+        ExprPtr executed = Expression::mkTrue();
+        if (!predTrans.empty()) {
+            executed = Expression::mkOr(predTrans);
+        }
+        for (unsigned k1=0; k1<predTrans.size(); k1++) {
+            for (unsigned k2=k1+1; k2<predTrans.size(); k2++) {
+                exprs.push_back(Expression::mkNot(
+                    Expression::mkAnd(predTrans[k1], predTrans[k2])));
+            }
         }
         const TerminatorInst *t = bb->getTerminator();
         if (isa<ReturnInst>(t)) {
-            return; // End of recursion
+            continue; // End of the path
         }
         const BranchInst *br = dyn_cast<BranchInst>(t);
         assert(br && "Unsupported terminal instruction!");
-        if (br->isUnconditional()) {
-            BasicBlock *nextbb = br->getSuccessor(0);
-            int val = getBlockTransVal(solver, bb, nextbb);
-            if (nbTruePredTrans==1 && val==l_false) {
-                dumpTransValues(solver);
-                assert("invalid control flow value (1)");
-            }
-            if (nbTruePredTrans==0 && nbUndefPredTrans==0 && val==l_true) {
-                std::cout << bb->getName().str() << std::endl;
-                dumpTransValues(solver);
-                assert("invalid control flow value (2)");
-            }
-        } else {
-            BasicBlock *nextbb1 = br->getSuccessor(0);
-            BasicBlock *nextbb2 = br->getSuccessor(1);
-            int val1 = getBlockTransVal(solver, bb, nextbb1);
-            int val2 = getBlockTransVal(solver, bb, nextbb2);
-            if (nbTruePredTrans==1 && val1==l_false && val2==l_false) {
-                dumpTransValues(solver);
-                assert("invalid control flow value (3)");
-            }
-            if (nbTruePredTrans==0 && nbUndefPredTrans ==0
-                && (val1==l_true || val2==l_true)) {
-                dumpTransValues(solver);
-                assert("invalid control flow value (4)");
-            }
-            if (val1==l_true && val2==l_true) {
-                dumpTransValues(solver);
-                assert("invalid control flow value (5)");
+        // An executed block takes exactly one of its successor 
+        // transitions, a block that is not executed takes none
+        std::vector<ExprPtr> succTrans;
+        succTrans.push_back(getBlockTransVar(bb, br->getSuccessor(0)));
+        if (br->isConditional() && br->getSuccessor(1)!=br->getSuccessor(0)) {
+            succTrans.push_back(getBlockTransVar(bb, br->getSuccessor(1)));
+            exprs.push_back(Expression::mkNot(
+                Expression::mkAnd(succTrans[0], succTrans[1])));
+        }
+        exprs.push_back(Expression::mkEq(executed, 
+                                         Expression::mkOr(succTrans)));
+        // Values of the transitions in the model
+        for (ExprPtr trans : succTrans) {
+            BoolVarExprPtr v = 
+            std::static_pointer_cast<BoolVarExpression>(trans);
+            int val = solver->getBoolValue(v->getNameID());
+            if (val==SolverBackend::True) {
+                exprs.push_back(trans);
+            } else if (val==SolverBackend::False) {
+                exprs.push_back(Expression::mkNot(trans));
             }
         }
     }
-    std::cout << "OK\n";
+    for (ExprPtr e : exprs) {
+        e->setHard();
+        skeleton->addToContext(e);
+    }
+    if (skeleton->check()==SolverBackend::False) {
+        std::cout << "invalid control flow values\n";
+        dumpTransValues(solver);
+    } else {
+        std::cout << "OK\n";
+    }
+    skeleton->clean();
+    delete skeleton;
 }
 
-int FaultLocalization::getBlockTransVal(YicesSolver *s,
+BoolVarExprPtr FaultLocalization::getBlockTransVar(BasicBlock *bb1, 
+                                                   BasicBlock *bb2) {
+    assert((bb1 && bb2) && "Basic block is null!");
+    std::pair<BasicBlock*, BasicBlock*> key(bb1, bb2);
+    std::map<std::pair<BasicBlock*, BasicBlock*>, unsigned>::iterator it = 
+    transNameIDs.find(key);
+    if (it==transNameIDs.end()) {
+        std::string bbname1 = bb1->getName().str();
+        std::string bbname2 = bb2->getName().str();
+        unsigned id = Expression::internName(bbname1 + "_" + bbname2);
+        it = transNameIDs.insert(std::make_pair(key, id)).first;
+    }
+    return Expression::mkBoolVar(Expression::getInternedName(it->second));
+}
+
+int FaultLocalization::getBlockTransVal(SolverBackend *s,
                                          BasicBlock *bb1, BasicBlock *bb2) {
     assert(s && "Solver is null!");
-    assert((bb1 && bb2) && "Basic block is null!");
-    std::string bbname1 = bb1->getName().str();
-    std::string bbname2 = bb2->getName().str();
-    std::string t = bbname1 + "_" + bbname2;
-    int val = solver->getBoolValue(t);
+    BoolVarExprPtr v = getBlockTransVar(bb1, bb2);
+    int val = s->getBoolValue(v->getNameID());
     return val;
 }
 
-void FaultLocalization::dumpTransValues(YicesSolver *solver) {
+void FaultLocalization::dumpTransValues(SolverBackend *solver) {
     std::cout <<  "\n---------------------" << std::endl;
     for (Function::iterator i=targetFun->begin(), e=targetFun->end(); i!=e; ++i) {
         BasicBlock *bb = i;
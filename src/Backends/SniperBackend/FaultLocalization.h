@@ -40,8 +40,12 @@
 #include "Profile/ProgramTrace.h"
 #include "Profile/ProgramProfile.h"
 #include "Logic/Formula.h"
-#include "Logic/YicesSolver.h"
+#include "Logic/SolverBackend.h"
+#include "Logic/PortfolioSolver.h"
 #include "Logic/Combine.h"
+#include "Logic/ConeOfInfluence.h"
+#include "Logic/Preprocessor.h"
+#include "Logic/DiagnosisReporter.h"
 
 using namespace llvm;
 
@@ -55,22 +59,106 @@ class FaultLocalization {
     
 private:
     Function *targetFun;
-    YicesSolver *solver;
+    SolverBackend *solver;
     bool hasArgv;
     Options *options;
+    /**
+     * Name IDs of the block transition variables, 
+     * interned on first use (see getBlockTransVal).
+     */
+    std::map<std::pair<BasicBlock*, BasicBlock*>, unsigned> transNameIDs;
+    /**
+     * Max-sat portfolio used by allMinMCS (NULL if disabled).
+     */
+    PortfolioSolver *portfolio;
+    /**
+     * For each set of MCSes returned by allDiagnosis, true if 
+     * the enumeration completed, false if the budget ran out.
+     */
+    std::vector<bool> completeMCSes;
+    /**
+     * Suspiciousness of the basic blocks, computed from the coverage 
+     * of the program traces (see Options::getNbWeightLevels).
+     */
+    std::map<BasicBlock*, double> suspiciousness;
+    /**
+     * Context with the hard part of the working formula, used to 
+     * extract the MUSes and to validate the reused MCSes (NULL if
+     * not needed).
+     */
+    SolverBackend *hardSolver;
+    /**
+     * MCSes of the previous traces, candidates for the next 
+     * traces (see Options::reuseMCSes), and their sorted 
+     * expressions (to avoid duplicates).
+     */
+    std::vector<std::vector<ExprPtr> > reusableMCSes;
+    std::set<std::vector<ExprPtr> > reusableKeys;
+    /**
+     * Result of the diagnosis of a trace by a worker process
+     * (see diagnoseInWorkers).
+     */
+    struct TraceResult {
+        /**
+         * True if the worker diagnosed the trace.
+         */
+        bool done;
+        /**
+         * True if the MCS enumeration completed.
+         */
+        bool complete;
+        /**
+         * Number of calls to the solver.
+         */
+        unsigned nbCalls;
+        /**
+         * Number of reused MCSes validated and number of hits.
+         */
+        unsigned nbReuseCandidates, nbReuseHits;
+        /**
+         * Solver statistics of the diagnosis, followed by the
+         * portfolio counters if any (see SolverStats::save and
+         * PortfolioSolver::saveStats).
+         */
+        std::string stats;
+        /**
+         * Output printed by the worker during the diagnosis.
+         */
+        std::string output;
+        /**
+         * MCSes, as indices of the (not ai) soft expressions.
+         */
+        std::vector<std::vector<unsigned> > MCSes;
+        TraceResult() : done(false), complete(true), nbCalls(0), 
+                        nbReuseCandidates(0), nbReuseHits(0) { }
+    };
     
 public:
     /**
      * Default constructor.
      */
-    FaultLocalization(Function *_targetFun, YicesSolver *_solver,
+    FaultLocalization(Function *_targetFun, SolverBackend *_solver,
                        Options *_options) :
                        targetFun(_targetFun), solver(_solver),
-                       options(_options) { }
+                       options(_options), portfolio(NULL), 
+                       hardSolver(NULL) {
+        // The budgets are enforced by running 
+        // the solver in a worker process
+        if (options->getNbPortfolioWorkers()>1 
+            || options->getSolverTimeout()>0 
+            || options->getTraceTimeout()>0
+            || options->getSolverMemoryLimit()>0) {
+            portfolio = new PortfolioSolver(options->getNbPortfolioWorkers());
+            portfolio->setMemoryLimit(options->getSolverMemoryLimit());
+            portfolio->setWeighted(options->getNbWeightLevels()>0);
+        }
+    }
     /**
      * Destructor.
      */
-    ~FaultLocalization() { }
+    ~FaultLocalization() {
+        delete portfolio;
+    }
     
     /**
      * Run the diagnosis enumeration algorithm, 
@@ -89,13 +177,23 @@ public:
      * Enumerate diagnoses for the given trace formula and 
      * for each error-inducing input. 
      *
+     * With several jobs (see Options::getNbJobs), the traces 
+     * are diagnosed in parallel by worker processes, and the 
+     * results are merged in the order of the traces so that
+     * the output is the same as the sequential one.
+     *
+     * The failing traces that executed the same path can share their 
+     * MCSes (see Options::getNbTraceRepresentatives).
+     *
      * \param TF A trace formula (partial formula in CNF).
      * \param traces A set of program traces that contain error-inducing inputs.
-     * \param yices A partial max-sat solver.
+     * \param solver A partial max-sat solver.
+     * \return The non-empty sets of MCSes, some of them may be 
+     *         partial (see isComplete).
      */
     std::vector<SetOfFormulasPtr> allDiagnosis(Formula *TF,
                                                std::vector<ProgramTrace*> traces,
-                                               YicesSolver *yices);
+                                               SolverBackend *solver);
     /**
      * Enumerate ALL diagnoses (MCSes) for the given formula.
      * The diagnoses enumeration consists of enumerating all the 
@@ -106,14 +204,233 @@ public:
      * consists of finding all the minimum size MCSes of C. The AllMCS 
      * problem consists of finding all MCSes of C (independent of their size).
      *
-     * \param yices A partial max-sat solver.
+     * \param solver A partial max-sat solver.
      * \param AV A set of auxiliary variables.
      * \param AVMap A map between auxiliary variables and their associated expressions.
-     * \return a set of minimal MCSes.
+     * \param sel A trace selector (or NULL), blocking clauses 
+     *        are guarded by this selector.
+     * \param complete If not NULL, receives false if the enumeration 
+     *        was stopped (budget exhausted or unknown result), 
+     *        true otherwise.
+     * \param maxNb Stop after \p maxNb MCSes (no limit if 0).
+     * \return a set of minimal MCSes (the ones found so far if the 
+     *         enumeration was stopped).
      */
-    SetOfFormulasPtr allMinMCS(YicesSolver *yices,
+    SetOfFormulasPtr allMinMCS(SolverBackend *solver,
                                std::vector<BoolVarExprPtr> &AV,
-                               std::map<BoolVarExprPtr, ExprPtr> &AVMap);
+                               std::map<BoolVarExprPtr, ExprPtr> &AVMap,
+                               BoolVarExprPtr sel = NULL,
+                               bool *complete = NULL,
+                               unsigned maxNb = 0);
+    
+    /**
+     * Set the budget of the next query of the portfolio (if any):
+     * the per-query budget, bounded by what is left of the trace 
+     * budget started at \p startTime.
+     *
+     * \return false if the trace budget is exhausted.
+     */
+    bool setQueryBudget(double startTime);
+    
+    /**
+     * Check the context of \p solver within the budgets (see 
+     * setQueryBudget), in a worker process of the portfolio 
+     * if there is a budget.
+     *
+     * \param solver A solver.
+     * \param startTime The start time of the trace budget.
+     * \param exprs Expressions evaluated in the model.
+     * \param falsified Receives the expressions of \p exprs 
+     *        falsified by the model (if True).
+     * \param core Receives the unsat core (if False).
+     * \return True, False or Undef (unknown or budget exhausted).
+     */
+    int budgetedCheck(SolverBackend *solver, double startTime,
+                      std::vector<ExprPtr> &exprs,
+                      std::vector<ExprPtr> &falsified,
+                      std::vector<SolverBackend::AssertionID> &core);
+    
+    /**
+     * Enumerate ALL the MCSes of the context of \p solver with a 
+     * linear search with clause D (CLD), as an alternative to 
+     * allMinMCS (see Options::useCLD).
+     *
+     * Each MCS is extracted with check calls only: the soft expressions 
+     * satisfied by a model (S) are assumed, and the clause D (the 
+     * disjunction of the falsified ones) is checked until it becomes 
+     * unsatisfiable. The falsified expressions are then an MCS, which 
+     * is blocked before looking for the next one. The soft expressions
+     * must not be asserted in the context. The checks have the budget 
+     * of the max-sat queries (see budgetedCheck).
+     *
+     * \param solver A solver whose context contains the hard constraints.
+     * \param softs The soft expressions (not ai).
+     * \param sel A trace selector (or NULL), blocking clauses 
+     *        are guarded by this selector.
+     * \param complete If not NULL, receives false if the enumeration 
+     *        was stopped, true otherwise.
+     * \param maxNb Stop after \p maxNb MCSes (no limit if 0).
+     * \return the set of all MCSes (the ones found so far if the 
+     *         enumeration was stopped).
+     */
+    SetOfFormulasPtr allMCSByLinearSearch(SolverBackend *solver,
+                                          std::vector<ExprPtr> &softs,
+                                          BoolVarExprPtr sel = NULL,
+                                          bool *complete = NULL,
+                                          unsigned maxNb = 0);
+    
+    /**
+     * Extract a MUS (minimal unsatisfiable subset) of the soft 
+     * expressions, without enumerating the MCSes.
+     *
+     * Deletion-based extraction over assumption literals: the soft
+     * expressions are asserted as retractable assertions and are 
+     * removed one at a time. If the remaining ones are satisfiable,
+     * the removed expression is in the MUS. Otherwise, the 
+     * candidates are restricted to the unsat core of the check 
+     * (clause-set refinement), which usually removes many of them 
+     * at once. The number of checks is at most linear in the number
+     * of soft expressions. The checks have the budget of the max-sat
+     * queries (see budgetedCheck).
+     *
+     * \param solver A solver whose context contains the hard 
+     *        constraints of a failing trace, but not \p softs.
+     * \param softs The soft expressions (not ai).
+     * \param complete If not NULL, receives false if the extraction 
+     *        was stopped (the result is then unsatisfiable, but 
+     *        maybe not minimal), true otherwise.
+     * \return a MUS of \p softs, or an empty vector if the 
+     *         constraints are satisfiable.
+     */
+    std::vector<ExprPtr> extractMUS(SolverBackend *solver,
+                                    std::vector<ExprPtr> &softs,
+                                    bool *complete = NULL);
+    
+    /**
+     * Return the MCSes of the previous traces that are also MCSes of 
+     * the trace \p E (see Options::reuseMCSes). A candidate is 
+     * validated in the context without soft expressions, with the 
+     * constraints of \p E (see isMCS).
+     *
+     * \param E A program trace that contains an error-inducing input.
+     * \param TF The trace formula.
+     * \param notAV The soft expressions (not ai).
+     * \param softs The soft expressions that can be falsified 
+     *        for \p E (see getOffPathConstraints).
+     * \param offPath The off-path constraints of \p E (if any).
+     * \return the validated MCSes.
+     */
+    std::vector<std::vector<ExprPtr> > reuseMCSes(ProgramTrace *E, Formula *TF,
+                                                  std::vector<ExprPtr> &notAV,
+                                                  std::vector<ExprPtr> &softs,
+                                                  std::vector<ExprPtr> &offPath);
+    
+    /**
+     * Return \a true if \p U is a MCS of the context of \p solver 
+     * (without soft expressions): the complement of \p U in \p notAV 
+     * is satisfiable (a single check), and adding back any expression 
+     * of \p U makes it unsatisfiable (one check per expression).
+     *
+     * \param solver A solver.
+     * \param U A candidate MCS (subset of \p notAV).
+     * \param notAV The soft expressions (not ai).
+     */
+    bool isMCS(SolverBackend *solver, std::vector<ExprPtr> &U,
+               std::vector<ExprPtr> &notAV);
+    
+    /**
+     * Return the name IDs of the variables of the constraints that are 
+     * asserted for each trace on top of the trace formula: error-inducing 
+     * inputs, golden outputs and transitions (path slicing). These 
+     * variables have to be kept by the reductions of the trace formula.
+     *
+     * \param TF The trace formula.
+     * \param traces The failing traces.
+     */
+    std::set<unsigned> getTraceVariables(Formula *TF, 
+                                         std::vector<ProgramTrace*> &traces);
+    
+    /**
+     * Return the hard constraints restricting the trace formula to the
+     * executed path of a failing trace (see Options::slicePaths): the
+     * transitions from or to a block that was not executed are disabled,
+     * which fixes the off-path branch conditions, and the soft expressions
+     * of these blocks are assumed (their auxiliary variable is false).
+     *
+     * \param executed The blocks executed by the trace.
+     * \param AV A set of auxiliary variables.
+     * \param notAV The soft expressions (not ai), indexed as \p AV.
+     * \param pathAV Receives the auxiliary variables of the
+     *        executed blocks (or without block).
+     * \param pathNotAV Receives the soft expressions of \p pathAV.
+     * \return the off-path constraints.
+     */
+    std::vector<ExprPtr> getOffPathConstraints(std::set<BasicBlock*> &executed,
+                                               std::vector<BoolVarExprPtr> &AV,
+                                               std::vector<ExprPtr> &notAV,
+                                               std::vector<BoolVarExprPtr> &pathAV,
+                                               std::vector<ExprPtr> &pathNotAV);
+    
+    /**
+     * Return the hard constraints of the trace \p E: the error-inducing 
+     * input formula and the golden output (if any).
+     */
+    std::vector<ExprPtr> getTraceConstraints(ProgramTrace *E, Formula *TF);
+    
+    /**
+     * Enumerate the MCSes with the engine selected by the options 
+     * (allMinMCS or allMCSByLinearSearch), smallest first, up to 
+     * the size and number bounds (see Options::mcsMaxSize and 
+     * Options::getMaxNbDiagnoses).
+     *
+     * The size bound is a retractable cardinality constraint over
+     * the auxiliary variables (see mkCardinalityBound). With weighted
+     * soft expressions (see Options::getNbWeightLevels), the 
+     * enumeration is stratified: the MCSes made of the soft 
+     * expressions of weight 1 are enumerated first, then the ones of 
+     * weight at most 2, etc. The MCSes are then the smallest first 
+     * within each stratum. Without bounds and weights, the engine 
+     * is called directly.
+     *
+     * \param solver A partial max-sat solver.
+     * \param AV A set of auxiliary variables.
+     * \param AVMap A map between auxiliary variables and their associated expressions.
+     * \param notAV The soft expressions (not ai).
+     * \param sel A trace selector (or NULL).
+     * \param complete If not NULL, receives false if the enumeration 
+     *        was stopped before reaching the bounds, true otherwise.
+     * \return the MCSes found within the bounds.
+     */
+    SetOfFormulasPtr boundedMCS(SolverBackend *solver,
+                                std::vector<BoolVarExprPtr> &AV,
+                                std::map<BoolVarExprPtr, ExprPtr> &AVMap,
+                                std::vector<ExprPtr> &notAV,
+                                BoolVarExprPtr sel = NULL,
+                                bool *complete = NULL);
+    
+    /**
+     * Return the weight of the soft expression \p e, from 1 if the 
+     * block of \p e is the most suspicious (see suspiciousness) to 
+     * Options::getNbWeightLevels if it was not executed by a failing
+     * trace. A low weight makes \p e cheap to falsify.
+     */
+    unsigned getSuspiciousnessWeight(ExprPtr e);
+    
+    /**
+     * Return the hard expression (<= (+ (ite a_1 1 0) ...) k),
+     * i.e. at most \p k auxiliary variables of \p AV are true.
+     */
+    ExprPtr mkCardinalityBound(std::vector<BoolVarExprPtr> &AV, unsigned k);
+    
+    /**
+     * Return \a true if the enumeration of the \p i-th set of MCSes 
+     * returned by allDiagnosis completed, false if it was stopped
+     * because the budget ran out (see Options::getTraceTimeout).
+     */
+    bool isComplete(unsigned i) {
+        assert(i<completeMCSes.size() && "Out of bound!");
+        return completeMCSes[i];
+    }
 
 private:
     /**
@@ -126,15 +443,72 @@ private:
      */
     SetOfFormulasPtr avToClauses(SetOfFormulasPtr M,
                                  std::map<BoolVarExprPtr, ExprPtr> AVMap);
+    /**
+     * Return \p e guarded by the trace selector \p sel, 
+     * that is (not sel or e), or \p e if there is no selector.
+     *
+     * \param e An expression.
+     * \param sel A trace selector (or NULL).
+     * \return A hard expression.
+     */
+    ExprPtr guardBySelector(ExprPtr e, BoolVarExprPtr sel);
+    
+    /**
+     * Enumerate the MCSes of the trace \p E, the working formula 
+     * being in the context of \p solver.
+     *
+     * \param E A program trace that contains an error-inducing input.
+     * \param id The index of the trace.
+     * \param TF A trace formula.
+     * \param solver A partial max-sat solver.
+     * \param AV A set of auxiliary variables.
+     * \param notAV The soft expressions (not ai), indexed as \p AV.
+     * \param AVMap A map between auxiliary variables and their associated expressions.
+     * \param complete Receives false if the enumeration was stopped.
+     * \return a set of minimal MCSes, in the order of the enumeration,
+     *         or sorted by SetOfFormulas::sort on \p notAV with MCS 
+     *         reuse or worker processes.
+     */
+    SetOfFormulasPtr diagnoseTrace(ProgramTrace *E, unsigned id, Formula *TF,
+                                   SolverBackend *solver,
+                                   std::vector<BoolVarExprPtr> &AV,
+                                   std::vector<ExprPtr> &notAV,
+                                   std::map<BoolVarExprPtr, ExprPtr> &AVMap,
+                                   bool &complete);
+    /**
+     * Diagnose the traces in worker processes forked from the current
+     * process (the backends are not thread-safe). Each worker inherits the
+     * context of \p solver and diagnoses a share of the traces.
+     *
+     * \param ids The indices of the traces to be diagnosed.
+     * \param notAV The soft expressions (not ai), indexed as \p AV.
+     * \return The results indexed by trace, a trace whose worker
+     *         failed is not done.
+     */
+    std::vector<TraceResult> diagnoseInWorkers(Formula *TF,
+                                    std::vector<ProgramTrace*> &traces,
+                                    std::vector<unsigned> &ids,
+                                    SolverBackend *solver,
+                                    std::vector<BoolVarExprPtr> &AV,
+                                    std::vector<ExprPtr> &notAV,
+                                    std::map<BoolVarExprPtr, ExprPtr> &AVMap);
     
     // === For debugging ===
 
     /**
      * Check the given model for control flow conflicts.
      *
+     * The values of the block transitions in the model are asserted
+     * in a propositional skeleton of the CFG (one path from the entry 
+     * block), which is checked by a SATSolver.
+     *
      * \param solver A max-sat solver that contains a model.
      */
-    void checkControlFlow(YicesSolver *solver);
+    void checkControlFlow(SolverBackend *solver);
+    /**
+     * Return the variable of the transition <\p bb1,\p bb2>.
+     */
+    BoolVarExprPtr getBlockTransVar(BasicBlock *bb1, BasicBlock *bb2);
     /**
      * Return the value of the transition variable <\p bb1,\p bb2> in 
      * the given model.
@@ -144,13 +518,13 @@ private:
      * \param bb2 An LLVM basic block.
      * \return The value of the <\p bb1,\p bb2> in the model of \p s.
      */
-    int  getBlockTransVal(YicesSolver *s, BasicBlock *bb1, BasicBlock *bb2);
+    int  getBlockTransVal(SolverBackend *s, BasicBlock *bb1, BasicBlock *bb2);
     /**
      * Given a model, print all basic block transitions values.
      *
      * \param s A max-sat solver that contains a model.
      */
-    void dumpTransValues(YicesSolver *solver);
+    void dumpTransValues(SolverBackend *solver);
     
 };
 
@@ -30,6 +30,22 @@
 
 void SniperBackend::run() {
     
+    // Record the solver queries
+    std::string recordDir = options->getRecordQueriesDir();
+    if (!QueryRecorder::setDirectory(recordDir)) {
+        std::cerr << "error: could not create the directory ";
+        std::cerr << recordDir << std::endl;
+        exit(1);
+    }
+    
+    // Stream the diagnoses
+    std::string streamFilename = options->getJSONStreamFileName();
+    if (!DiagnosisReporter::open(streamFilename)) {
+        std::cerr << "error: could not open the file ";
+        std::cerr << streamFilename << std::endl;
+        exit(1);
+    }
+    
     // Get the target module
     Module *llvmMod = frontend->getLLVMModule();
     
@@ -87,6 +103,7 @@ void SniperBackend::run() {
     if (options->methodConcolic()) {
         if (PP->getFailingProgramTraces().size()==0) {
             std::cout << "VERIFICATION SUCCESSFUL\n";
+            reportSolverStats();
             exit(0);
         }
         // Update program profile
@@ -116,7 +133,8 @@ void SniperBackend::run() {
     }
     
     // Create a partial weighted MaxSMT solver
-    YicesSolver *solver = new YicesSolver();
+    SolverBackend *solver = new YicesSolver();
+    solver->setMaxSatAlgorithm(options->getMaxSatAlgorithm());
     
     // Generate program executions
     if (options->methodConcolic()) {
@@ -135,6 +153,7 @@ void SniperBackend::run() {
                 }
             } else {
                 std::cout << "VERIFICATION SUCCESSFUL\n";
+                reportSolverStats();
                 exit(0);
             }
         }
@@ -144,4 +163,18 @@ void SniperBackend::run() {
     FaultLocalization *FL = new FaultLocalization(targetFun, solver, options);
     Combine::Method CM = (Combine::Method) options->getCombineMethod();
     FL->run(TF, preCond, postCond, PP, CM);
+    DiagnosisReporter::close();
+    
+    reportSolverStats();
+}
+
+void SniperBackend::reportSolverStats() {
+    if (options->printSolverStats()) {
+        SolverStats::printReport(std::cout);
+    }
+    std::string filename = options->getSolverStatsFileName();
+    if (!filename.empty() && !SolverStats::exportJSON(filename)) {
+        std::cerr << "error: could not write the solver statistics in ";
+        std::cerr << filename << std::endl;
+    }
 }
@@ -85,6 +85,13 @@ public:
      */
     void run();
     
+private:
+    /**
+     * Print and/or export the solver statistics 
+     * (see SolverStats), as requested by the user.
+     */
+    void reportSolverStats();
+    
 };
 
 #endif // _SNIPERBACKEND_H
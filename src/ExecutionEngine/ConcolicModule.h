@@ -65,6 +65,7 @@
 #include "Profile/ProgramProfile.h"
 #include "Logic/Expression.h"
 #include "Logic/Formula.h"
+#include "Logic/SolverBackend.h"
 #include "Logic/YicesSolver.h"
 #include "ExecutionEngine/IRInstrumentor.h"
 #include "ExecutionEngine/Symbol.h"
@@ -118,7 +119,7 @@ protected:
     Function    *targetFun;
     Options     *options;
     IRBuilder<> *IRB; 
-    YicesSolver *solver;
+    SolverBackend *solver;
     unsigned    roundID;
     bool        terminated;
     VariablesPtr lastInputs;
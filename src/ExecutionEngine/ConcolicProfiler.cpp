@@ -26,6 +26,7 @@
  */
 
 #include "ConcolicProfiler.h"
+#include "Logic/QueryRecorder.h"
 
 /**
  * Maximum number of time the target function 
@@ -57,7 +58,7 @@ void ConcolicProfiler::run(ProgramProfile *profile, LocalVariables *locVars,
     roundID    = 1;
     Executor::init(loopInfo, profile,
     /*collectBlocks*/ options->htfUsed());
-
+    
     while (roundID<=MAX_RUN) 
     {
         // Generate the inputs for the target function
@@ -131,9 +132,20 @@ void ConcolicProfiler::run(ProgramProfile *profile, LocalVariables *locVars,
     if (options->dbgMsg()) {
         std::cout << "\n=== [Concolic Profiler] terminated ===\n";
         profile->dump();
+    }
+    if (options->dbgMsg() || options->printSolverStats()) {
+        std::cout << "Concolic path constraints: " << nbPathConstraints;
+        std::cout << " (solved: " << nbSlicedConstraints << ")\n";
+        if (cexCache) {
+            cexCache->printStats(std::cout);
+        }
     }
        // Cleaning
     Executor::clean();    
+    solver->clean();
+    solverReady = false;
+    assertedExprs.clear();
+    assertedTerms.clear();
 }
 
 
@@ -245,8 +257,8 @@ VariablesPtr ConcolicProfiler::generateInputValues() {
 bool ConcolicProfiler::solve(std::vector<ExprCellPtr> path,
                              std::vector<ExprCellPtr> asserts,
                              bool genFailing, VariablesPtr inputs) {
-    // Create a formula to hold the path constraints
-    Formula *formula = new Formula();
+    // Collect the path constraints
+    std::vector<ExprPtr> prefix;
     for (unsigned i=0; i<path.size()-1; i++) {
         ExprCellPtr n = path[i];
         assert((n->isBranch() || n->isFunCall()) &&
@@ -267,12 +279,13 @@ bool ConcolicProfiler::solve(std::vector<ExprCellPtr> path,
             e = n->getExpr();
         }
         e->setHard();
-        formula->add(e);
+        prefix.push_back(e);
     }
     // Create and add the constraint in the formula:
     // If the branch taken in the last
     // execution was the true branch
     // we negate the selected constraint
+    std::vector<ExprPtr> suffix;
     ExprPtr e;
     BranchExprCellPtr selectedNode
     = std::static_pointer_cast<BranchExprCell>(path.back());
@@ -283,7 +296,7 @@ bool ConcolicProfiler::solve(std::vector<ExprCellPtr> path,
         e = selectedNode->getExpr();
     }
     e->setHard();
-    formula->add(e);
+    suffix.push_back(e);
     
     // Add the asserts to the formula
     for (unsigned i=0; i<asserts.size(); i++) {
@@ -295,26 +308,95 @@ bool ConcolicProfiler::solve(std::vector<ExprCellPtr> path,
             e = n->getExpr();
         }
         e->setHard();
-        formula->add(e);
+        suffix.push_back(e);
+    }
+    nbPathConstraints += prefix.size();
+    if (options->useIndependence()) {
+        sliceIndependent(prefix, suffix);
+    }
+    nbSlicedConstraints += prefix.size();
+    std::vector<ExprPtr> es(prefix);
+    es.insert(es.end(), suffix.begin(), suffix.end());
+    
+    std::set<unsigned> boolVars, intVars;
+    for (ExprPtr e : es) {
+        CexCache::collectVars(e, boolVars, intVars);
     }
     
+    // Look for the result of the query in the cache
+    CexCache::Model model;
+    std::vector<unsigned> key;
+    int status = SolverBackend::Undef;
+    if (cexCache) {
+        key = cexCache->makeKey(es);
+        status = cexCache->lookup(key, model);
+        // Only keep the values of the variables of the query, the 
+        // other ones may not satisfy the sliced constraints
+        CexCache::Model::iterator it = model.begin();
+        while (it!=model.end()) {
+            if (!boolVars.count(it->first) && !intVars.count(it->first)) {
+                model.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (status==SolverBackend::Undef) {
+        // Solve the query: the path prefix is kept in the 
+        // solver context, only the suffix is pushed and popped
+        SolverStats::setPhase(SolverStats::CONCOLIC);
+        assertPrefix(prefix);
+        solver->push();
+        for (ExprPtr e : suffix) {
+            solver->addToContext(e);
+        }
+        status = solver->check();
+        if (status==SolverBackend::True) {
+            // Save the values of all the variables of the query
+            for (unsigned v : boolVars) {
+                int val = solver->getBoolValue(v);
+                if (val==SolverBackend::True || val==SolverBackend::False) {
+                    model[v] = (val==SolverBackend::True);
+                }
+            }
+            for (unsigned v : intVars) {
+                bool error = false;
+                int val = solver->getValue(v, error);
+                if (!error) {
+                    model[v] = val;
+                }
+            }
+        }
+        solver->pop();
+        if (status==SolverBackend::True && cexCache) {
+            cexCache->insertSat(key, model);
+        } else if (status==SolverBackend::False && cexCache) {
+            cexCache->insertUnsat(key);
+        }
+    }
     // The formula is satisfiable
-    solver->init();
-    int status = solver->check(formula);
-    if(status==l_true) {
+    if(status==SolverBackend::True) {
         // Retrieve all main function arguments ,
         // retrieve their value from the model (of Yices)
         //std::cout << "Input values:\n";
         std::vector<InputVarTracePtr> lastInputsVec = lastInputs->getVector();
         unsigned i = 0;
-        std::string fname("_"+targetFun->getName().str());
+        // Intern the argument names once for all queries
+        if (argNameIDs.empty()) {
+            std::string fname("_"+targetFun->getName().str());
+            Function::arg_iterator ait;
+            for (ait = targetFun->arg_begin(); ait != targetFun->arg_end(); ++ait) {
+                std::string argName = ait->getName().str()+fname;
+                argNameIDs.push_back(Expression::internName(argName));
+            }
+        }
         Function::arg_iterator ait;
         for (ait = targetFun->arg_begin(); ait != targetFun->arg_end(); ++ait) {
-            std::string argName = ait->getName().str()+fname;
-            bool error = false;
-            int val = solver->getValue(argName, error);
+            CexCache::Model::iterator it = model.find(argNameIDs[i]);
             // Arg not involved in the solution: take the last value
-            if (error) {
+            if (it==model.end()) {
+                const std::string &argName = 
+                Expression::getInternedName(argNameIDs[i]);
                 int val = RND_MIN + rand() % (RND_MAX - RND_MIN);
                 if (argName=="arg7") {
                     val = 0 + rand() % (4 - 0);
@@ -325,24 +407,121 @@ bool ConcolicProfiler::solve(std::vector<ExprCellPtr> path,
                 //inputs->add(ait, 0));
                 inputs->add(lastInputsVec[i]);
             } else {
-                //std::cout << argName << " = " << val << std::endl;
-                inputs->add(ait, val);
+                //std::cout << argName << " = " << it->second << std::endl;
+                inputs->add(ait, (int) it->second);
             }
             i++;
         }
-        solver->clean();
-        delete formula;
         return true; // found a solution
-    } else if (status==l_false) {
+    } else if (status==SolverBackend::False) {
         // The formula is unsatisfiable
-        solver->clean();
-        delete formula;
         return false; // no solution
     } else {
         // The formula is undef
-        solver->clean();
-        delete formula;
         std::cout << "error: solver (status " << status << ")\n";
         exit(1);
     }
 }
+
+
+// =============================================================================
+// assertPrefix
+//
+// =============================================================================
+void ConcolicProfiler::assertPrefix(std::vector<ExprPtr> &prefix) {
+    if (!solverReady) {
+        solver->init();
+        solverReady = true;
+    }
+    // Keep the longest common prefix (the expressions of
+    // a new execution are compared by their SMT-LIB2 term)
+    unsigned k = 0;
+    while (k<prefix.size() && k<assertedExprs.size()) {
+        if (prefix[k]!=assertedExprs[k]) {
+            std::string term = QueryRecorder::toSMTLIB2(prefix[k]);
+            if (term!=assertedTerms[k]) {
+                break;
+            }
+            assertedExprs[k] = prefix[k];
+        }
+        k++;
+    }
+    // Backtrack to the common prefix
+    while (assertedExprs.size()>k) {
+        solver->pop();
+        assertedExprs.pop_back();
+        assertedTerms.pop_back();
+    }
+    // Assert the remaining constraints, one backtracking point each
+    for (unsigned i=k; i<prefix.size(); i++) {
+        solver->push();
+        solver->addToContext(prefix[i]);
+        assertedExprs.push_back(prefix[i]);
+        assertedTerms.push_back(QueryRecorder::toSMTLIB2(prefix[i]));
+    }
+}
+
+
+// =============================================================================
+// sliceIndependent
+//
+// =============================================================================
+
+/**
+ * Return the representative of the variable \p v (union-find).
+ */
+static unsigned findRoot(std::map<unsigned, unsigned> &parent, unsigned v) {
+    std::map<unsigned, unsigned>::iterator it = parent.find(v);
+    if (it==parent.end()) {
+        parent[v] = v;
+        return v;
+    }
+    if (it->second==v) {
+        return v;
+    }
+    unsigned r = findRoot(parent, it->second);
+    parent[v] = r;
+    return r;
+}
+
+void ConcolicProfiler::sliceIndependent(std::vector<ExprPtr> &prefix, 
+                                        std::vector<ExprPtr> &suffix) {
+    // Variables of each constraint
+    std::vector<std::set<unsigned> > prefixVars(prefix.size());
+    for (unsigned i=0; i<prefix.size(); i++) {
+        CexCache::collectVars(prefix[i], prefixVars[i], prefixVars[i]);
+    }
+    std::set<unsigned> suffixVars;
+    for (ExprPtr e : suffix) {
+        CexCache::collectVars(e, suffixVars, suffixVars);
+    }
+    // Group the variables that appear in the same constraint
+    std::map<unsigned, unsigned> parent;
+    for (unsigned i=0; i<prefix.size(); i++) {
+        if (prefixVars[i].empty()) {
+            continue;
+        }
+        unsigned r = findRoot(parent, *prefixVars[i].begin());
+        for (unsigned v : prefixVars[i]) {
+            parent[findRoot(parent, v)] = r;
+        }
+    }
+    if (!suffixVars.empty()) {
+        unsigned r = findRoot(parent, *suffixVars.begin());
+        for (unsigned v : suffixVars) {
+            parent[findRoot(parent, v)] = r;
+        }
+    }
+    // Keep the constraints of the group of the suffix
+    std::vector<ExprPtr> sliced;
+    if (!suffixVars.empty()) {
+        unsigned r = findRoot(parent, *suffixVars.begin());
+        for (unsigned i=0; i<prefix.size(); i++) {
+            if (!prefixVars[i].empty() 
+                && findRoot(parent, *prefixVars[i].begin())==r) {
+                sliced.push_back(prefix[i]);
+            }
+        }
+    }
+    prefix = sliced;
+}
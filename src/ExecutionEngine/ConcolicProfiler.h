@@ -36,6 +36,7 @@
 
 #include "ConcolicModule.h"
 #include "Executor.h"
+#include "Logic/CexCache.h"
 
 using namespace llvm;
 
@@ -46,11 +47,37 @@ using namespace llvm;
  * See ConcolicModule for details.
  */
 class ConcolicProfiler : public ConcolicModule {
-       
+
 private:
     Function *targetFun;
     ExecutionEngine *EE;
-    
+    /**
+     * Name IDs of the solver variables that encode the arguments 
+     * of the target function (see Expression::internName).
+     */
+    std::vector<unsigned> argNameIDs;
+    /**
+     * Results of the solved path constraints 
+     * (NULL if disabled, see Options::useCexCache).
+     */
+    CexCache *cexCache;
+    /**
+     * True if the solver context was initialized.
+     */
+    bool solverReady;
+    /**
+     * Path constraints asserted in the solver context, 
+     * one backtracking point each (see assertPrefix),
+     * and their SMT-LIB2 terms.
+     */
+    std::vector<ExprPtr> assertedExprs;
+    std::vector<std::string> assertedTerms;
+    /**
+     * Number of path constraints before and 
+     * after the independence slicing.
+     */
+    unsigned long nbPathConstraints, nbSlicedConstraints;
+
 public:
     /**
      * Default constructor.
@@ -62,6 +89,10 @@ public:
     ConcolicProfiler(Module *_llvmMod, Function *_targetFun, Options *_options) 
 					: ConcolicModule(_llvmMod, _targetFun, _options) {
     	this->targetFun = _targetFun;
+    	this->cexCache = _options->useCexCache() ? new CexCache() : NULL;
+    	this->solverReady = false;
+    	this->nbPathConstraints = 0;
+    	this->nbSlicedConstraints = 0;
     	srand(time(NULL));
 	}
     /**
@@ -69,8 +100,9 @@ public:
      */
 	~ConcolicProfiler() {
 		//delete EE;
+		delete cexCache;
 	}
-
+    
     void run(ProgramProfile *profile, LocalVariables *locVars, 
              LoopInfoPass *loopInfo);
 
@@ -94,6 +126,8 @@ private:
      *
      * Solve the formula (\p path ^ \p asserts) when \p genFailing is true, 
      * otherwise solve the formula (\p path ^ not \p asserts).
+     * The solver is not called if the result can be deduced
+     * from the previous queries (see CexCache).
      *
      * \param path A set of expressions representing a symbolic path.
      * \param asserts A set of expression representing a post-condition.
@@ -104,7 +138,28 @@ private:
      */
     bool solve(std::vector<ExprCellPtr> path, std::vector<ExprCellPtr> asserts, 
                bool genFailing, VariablesPtr inputs);
-    
+    /**
+     * Assert the path constraints \p prefix in the solver context.
+     *
+     * The context is initialized once and kept between the queries.
+     * Only the constraints that differ from the ones already asserted
+     * are popped and pushed, which follows the depth-first order in
+     * which generateInputValues flips the branches.
+     */
+    void assertPrefix(std::vector<ExprPtr> &prefix);
+    /**
+     * Remove from \p prefix the constraints that are independent
+     * of the constraints in \p suffix.
+     *
+     * The constraints are partitioned into groups that do not share
+     * any variable, and only the groups of the \p suffix constraints
+     * (negated branch and post-conditions) are kept. The removed
+     * constraints are satisfied by the inputs of the last execution,
+     * which are kept for the arguments that are not in the solution.
+     */
+    void sliceIndependent(std::vector<ExprPtr> &prefix, 
+                          std::vector<ExprPtr> &suffix);
+
 };
 
 #endif // _CONCOLICPROFILER_H
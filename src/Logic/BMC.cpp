@@ -35,9 +35,11 @@
 // F = pre^TF^notPost
 //
 // =============================================================================
-void BMC::run(ProgramProfile *profile, Function *targetFun, YicesSolver *solver,
-              Formula *TF, Formula *preCond, Formula *postCond,
-              LoopInfoPass *loopInfo, Options *options) {
+void BMC::run(ProgramProfile *profile, Function *targetFun, 
+              SolverBackend *solver, Formula *TF, Formula *preCond, 
+              Formula *postCond, LoopInfoPass *loopInfo, Options *options) {
+    
+    SolverStats::setPhase(SolverStats::BMC);
     
     // Add the trace formula to the context
     solver->init();
@@ -63,12 +65,12 @@ void BMC::run(ProgramProfile *profile, Function *targetFun, YicesSolver *solver,
         
     switch(solver->check()) {
         // Negated claim is satisfiable, i.e., does not hold
-        case l_true: {
+        case SolverBackend::True: {
         } break;  
         // Negated claim is unsatisfiable: verification successful
-        case l_false:
+        case SolverBackend::False:
             return;
-        case l_undef:
+        case SolverBackend::Undef:
             std::cout << "unknown: it was not possible"; 
             std::cout << " to decide due to an incompleteness.\n";
             return;
@@ -85,8 +87,8 @@ void BMC::run(ProgramProfile *profile, Function *targetFun, YicesSolver *solver,
         BasicBlock *headerBB = loopInfo->getLoopLatch(I);
         BasicBlock *nextBB1 = I->getSuccessor(0);
         BasicBlock *nextBB2 = I->getSuccessor(1);
-        if ((headerBB && headerBB==nextBB1 && val==l_true) 
-            || (headerBB && headerBB==nextBB2 && val==l_false)) {
+        if ((headerBB && headerBB==nextBB1 && val==SolverBackend::True) 
+            || (headerBB && headerBB==nextBB2 && val==SolverBackend::False)) {
             unsigned line = 0;
             if (MDNode *N = I->getMetadata("dbg")) { 
                 DILocation Loc(N); 
@@ -113,7 +115,8 @@ void BMC::run(ProgramProfile *profile, Function *targetFun, YicesSolver *solver,
         const Type *argTy = FTy->getParamType(argNo);
         if (argTy->isIntegerTy() && !argTy->isIntegerTy(1)) {
             std::string argName = ait->getName().str();
-            long value = solver->getValueOrZero(argName);
+            bool error;
+            long value = solver->getValue(argName, error);
             Value *origin = ait;
             E->addProgramInput(origin, value);
         }
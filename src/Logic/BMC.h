@@ -40,7 +40,8 @@
 #include "Profile/ProgramTrace.h"
 #include "Logic/Expression.h"
 #include "Logic/Formula.h"
-#include "Logic/YicesSolver.h"
+#include "Logic/SolverBackend.h"
+#include "Logic/SolverStats.h"
 
 using namespace llvm;
 
@@ -74,7 +75,7 @@ public:
      * if bounded model checking was successful.
      * \param targetFun An LLVM function on which we want to perform bounded
      * model checking.
-     * \param solver An SMT solver to check the unsatisfiability of the 
+     * \param solver A solver to check the unsatisfiability of the 
      * formula (\a TF ^ not(\a AS)).
      * \param TF A trace formula that encodes \a targetFun.
      * \param preCond A formula that encodes the pre-condtion of \a targetFun.
@@ -83,7 +84,7 @@ public:
      * \param options User defined SNIPER options.
      */
     static void run(ProgramProfile *profile, Function *targetFun,
-                    YicesSolver *solver, Formula *TF, Formula *preCond,
+                    SolverBackend *solver, Formula *TF, Formula *preCond,
                     Formula *postCond, LoopInfoPass *loopInfo, Options *options);
     
 };
@@ -0,0 +1,282 @@
+/**
+ * \file CexCache.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#include "CexCache.h"
+#include "QueryRecorder.h"
+
+#include <algorithm>
+#include <iomanip>
+
+std::vector<unsigned> CexCache::makeKey(std::vector<ExprPtr> &es) {
+    std::vector<unsigned> key;
+    for (ExprPtr e : es) {
+        std::string s = QueryRecorder::toSMTLIB2(e);
+        std::unordered_map<std::string, unsigned>::iterator it;
+        it = constraintIDs.find(s);
+        if (it==constraintIDs.end()) {
+            it = constraintIDs.insert(std::make_pair(s, constraints.size())).first;
+            constraints.push_back(e);
+        }
+        key.push_back(it->second);
+    }
+    std::sort(key.begin(), key.end());
+    key.erase(std::unique(key.begin(), key.end()), key.end());
+    return key;
+}
+
+bool CexCache::isSubset(const std::vector<unsigned> &a,
+                        const std::vector<unsigned> &b) {
+    return a.size()<=b.size()
+    && std::includes(b.begin(), b.end(), a.begin(), a.end());
+}
+
+int CexCache::lookup(const std::vector<unsigned> &key, Model &model) {
+    nbLookups++;
+    // Same set, unsatisfiable subset or satisfiable superset
+    for (const Entry &entry : entries) {
+        if (entry.key==key) {
+            nbExactHits++;
+            model = entry.model;
+            return entry.sat ? SolverBackend::True : SolverBackend::False;
+        }
+    }
+    for (const Entry &entry : entries) {
+        if (!entry.sat && isSubset(entry.key, key)) {
+            nbUnsatHits++;
+            return SolverBackend::False;
+        }
+        if (entry.sat && isSubset(key, entry.key)) {
+            nbSatHits++;
+            model = entry.model;
+            return SolverBackend::True;
+        }
+    }
+    // Try the models of the satisfiable subsets 
+    // on the remaining constraints
+    for (const Entry &entry : entries) {
+        if (!entry.sat || !isSubset(entry.key, key)) {
+            continue;
+        }
+        std::vector<unsigned> rest;
+        std::set_difference(key.begin(), key.end(),
+                            entry.key.begin(), entry.key.end(),
+                            std::back_inserter(rest));
+        bool sat = true;
+        for (unsigned i=0; i<rest.size() && sat; i++) {
+            long val;
+            sat = evaluate(constraints[rest[i]], entry.model, val) && val;
+        }
+        if (sat) {
+            nbModelHits++;
+            model = entry.model;
+            return SolverBackend::True;
+        }
+    }
+    return SolverBackend::Undef;
+}
+
+void CexCache::insertSat(const std::vector<unsigned> &key, const Model &model) {
+    Entry entry;
+    entry.key = key;
+    entry.sat = true;
+    entry.model = model;
+    entries.push_back(entry);
+}
+
+void CexCache::insertUnsat(const std::vector<unsigned> &key) {
+    Entry entry;
+    entry.key = key;
+    entry.sat = false;
+    entries.push_back(entry);
+}
+
+void CexCache::collectVars(ExprPtr e, std::set<unsigned> &boolVars,
+                           std::set<unsigned> &intVars) {
+    switch (e->getOpCode()) {
+        case Expression::BoolVar: {
+            SingleExprPtr v = std::static_pointer_cast<SingleExpression>(e);
+            boolVars.insert(v->getNameID());
+        } break;
+        case Expression::IntVar: {
+            SingleExprPtr v = std::static_pointer_cast<SingleExpression>(e);
+            intVars.insert(v->getNameID());
+        } break;
+        case Expression::Not: {
+            NotExprPtr ne = std::static_pointer_cast<NotExpression>(e);
+            collectVars(ne->get(), boolVars, intVars);
+        } break;
+        case Expression::Gt:
+        case Expression::Ge:
+        case Expression::Le:
+        case Expression::Lt:
+        case Expression::Diseq:
+        case Expression::Eq:
+        case Expression::Div:
+        case Expression::Mod:
+        case Expression::App: {
+            BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(e);
+            collectVars(be->getExpr1(), boolVars, intVars);
+            collectVars(be->getExpr2(), boolVars, intVars);
+        } break;
+        case Expression::And:
+        case Expression::Or:
+        case Expression::Xor:
+        case Expression::Sum:
+        case Expression::Sub:
+        case Expression::Mul: {
+            UnaryExprPtr ue = std::static_pointer_cast<UnaryExpression>(e);
+            for (ExprPtr a : ue->getExprs()) {
+                collectVars(a, boolVars, intVars);
+            }
+        } break;
+        case Expression::Ite:
+        case Expression::Update: {
+            TrinaryExprPtr te = std::static_pointer_cast<TrinaryExpression>(e);
+            collectVars(te->getExpr1(), boolVars, intVars);
+            collectVars(te->getExpr2(), boolVars, intVars);
+            collectVars(te->getExpr3(), boolVars, intVars);
+        } break;
+        default:
+            break;
+    }
+}
+
+bool CexCache::evaluate(ExprPtr e, const Model &model, long &val) {
+    switch (e->getOpCode()) {
+        case Expression::True:
+            val = 1;
+            return true;
+        case Expression::False:
+            val = 0;
+            return true;
+        case Expression::UInt32Num: {
+            UInt32NumExprPtr ne = std::static_pointer_cast<UInt32NumExpression>(e);
+            val = (int) ne->getValue(); // as yices_mk_num
+            return true;
+        }
+        case Expression::SInt32Num: {
+            SInt32NumExprPtr ne = std::static_pointer_cast<SInt32NumExpression>(e);
+            val = ne->getValue();
+            return true;
+        }
+        case Expression::BoolVar:
+        case Expression::IntVar: {
+            SingleExprPtr v = std::static_pointer_cast<SingleExpression>(e);
+            Model::const_iterator it = model.find(v->getNameID());
+            if (it==model.end()) {
+                return false;
+            }
+            val = it->second;
+            return true;
+        }
+        case Expression::Not: {
+            NotExprPtr ne = std::static_pointer_cast<NotExpression>(e);
+            if (!evaluate(ne->get(), model, val)) {
+                return false;
+            }
+            val = !val;
+            return true;
+        }
+        case Expression::Gt:
+        case Expression::Ge:
+        case Expression::Le:
+        case Expression::Lt:
+        case Expression::Diseq:
+        case Expression::Eq: {
+            BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(e);
+            long v1, v2;
+            if (!evaluate(be->getExpr1(), model, v1)
+                || !evaluate(be->getExpr2(), model, v2)) {
+                return false;
+            }
+            switch (e->getOpCode()) {
+                case Expression::Gt:    val = v1>v2;  break;
+                case Expression::Ge:    val = v1>=v2; break;
+                case Expression::Le:    val = v1<=v2; break;
+                case Expression::Lt:    val = v1<v2;  break;
+                case Expression::Diseq: val = v1!=v2; break;
+                default:                val = v1==v2; break;
+            }
+            return true;
+        }
+        case Expression::And:
+        case Expression::Or:
+        case Expression::Xor:
+        case Expression::Sum:
+        case Expression::Sub:
+        case Expression::Mul: {
+            UnaryExprPtr ue = std::static_pointer_cast<UnaryExpression>(e);
+            std::vector<ExprPtr> es = ue->getExprs();
+            if (es.empty()) {
+                return false;
+            }
+            if (!evaluate(es[0], model, val)) {
+                return false;
+            }
+            for (unsigned i=1; i<es.size(); i++) {
+                long v;
+                if (!evaluate(es[i], model, v)) {
+                    return false;
+                }
+                switch (e->getOpCode()) {
+                    case Expression::And: val = val && v; break;
+                    case Expression::Or:  val = val || v; break;
+                    case Expression::Xor: val = (val!=0) != (v!=0); break;
+                    case Expression::Sum: val = val + v;  break;
+                    case Expression::Sub: val = val - v;  break;
+                    default:              val = val * v;  break;
+                }
+            }
+            return true;
+        }
+        case Expression::Ite: {
+            IteExprPtr ie = std::static_pointer_cast<IteExpression>(e);
+            long c;
+            if (!evaluate(ie->getExpr1(), model, c)) {
+                return false;
+            }
+            return evaluate(c ? ie->getExpr2() : ie->getExpr3(), model, val);
+        }
+        default:
+            // Division, modulo, functions, parsed expressions
+            return false;
+    }
+}
+
+void CexCache::printStats(std::ostream &out) {
+    out << "Cex cache lookups: " << nbLookups;
+    out << " (hits: " << getNbHits();
+    if (nbLookups>0) {
+        out << ", " << std::fixed << std::setprecision(1);
+        out << (100.0*getNbHits())/nbLookups << "%";
+    }
+    out << "; exact " << nbExactHits;
+    out << ", unsat subset " << nbUnsatHits;
+    out << ", sat superset " << nbSatHits;
+    out << ", model reuse " << nbModelHits << ")\n";
+}
@@ -0,0 +1,177 @@
+/**
+ * \file CexCache.h
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#ifndef _CEXCACHE_H
+#define _CEXCACHE_H
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "Expression.h"
+#include "SolverBackend.h"
+
+/**
+ * \class CexCache
+ *
+ * \brief A counterexample cache for sets of hard constraints
+ *        (as in KLEE).
+ *
+ * Each constraint is canonicalized by its SMT-LIB2 term (see 
+ * QueryRecorder::toSMTLIB2) and identified by a number, so that
+ * a query is the sorted set of the numbers of its constraints. 
+ * The cache stores the result of the solved queries: a model 
+ * (values of the variables) if the query is satisfiable, and
+ * nothing otherwise. A query is then answered without the solver
+ * if:
+ * - the same set of constraints is in the cache,
+ * - a subset of the constraints is unsatisfiable,
+ * - a superset of the constraints is satisfiable (its model 
+ *   satisfies the query),
+ * - the model of a satisfiable subset also satisfies the 
+ *   remaining constraints of the query (see evaluate).
+ */
+class CexCache {
+
+public:
+    /**
+     * Values of the variables, indexed by name ID
+     * (booleans are 0 or 1).
+     */
+    typedef std::map<unsigned, long> Model;
+
+private:
+    /**
+     * A solved query.
+     */
+    struct Entry {
+        std::vector<unsigned> key;
+        bool sat;
+        Model model;
+    };
+    std::vector<Entry> entries;
+    /**
+     * Numbers of the canonicalized constraints.
+     */
+    std::unordered_map<std::string, unsigned> constraintIDs;
+    /**
+     * Constraints, indexed by their number.
+     */
+    std::vector<ExprPtr> constraints;
+    /**
+     * Statistics.
+     */
+    unsigned long nbLookups, nbExactHits, nbUnsatHits, nbSatHits, nbModelHits;
+
+public:
+    /**
+     * Default constructor.
+     */
+    CexCache() : nbLookups(0), nbExactHits(0), nbUnsatHits(0),
+                 nbSatHits(0), nbModelHits(0) { }
+    /**
+     * Destructor.
+     */
+    ~CexCache() { }
+    
+    /**
+     * \brief Return the key (sorted constraint numbers) of
+     *        the set of constraints \p es.
+     */
+    std::vector<unsigned> makeKey(std::vector<ExprPtr> &es);
+    
+    /**
+     * \brief Look for the result of a query in the cache.
+     *
+     * \param key The key of the query (see makeKey).
+     * \param model Receives a model of the query if it is satisfiable.
+     * \return True (satisfiable), False (unsatisfiable), or
+     *         Undef if the query can not be answered by the cache.
+     */
+    int lookup(const std::vector<unsigned> &key, Model &model);
+    
+    /**
+     * \brief Cache a satisfiable query and its model.
+     */
+    void insertSat(const std::vector<unsigned> &key, const Model &model);
+    
+    /**
+     * \brief Cache an unsatisfiable query.
+     */
+    void insertUnsat(const std::vector<unsigned> &key);
+    
+    /**
+     * \brief Collect the name IDs of the boolean (\p boolVars) and 
+     *        integer (\p intVars) variables of \p e.
+     */
+    static void collectVars(ExprPtr e, std::set<unsigned> &boolVars,
+                            std::set<unsigned> &intVars);
+    
+    /**
+     * \brief Evaluate \p e with the values of \p model.
+     *
+     * Only the boolean and linear integer expressions are 
+     * supported (no division, modulo or function).
+     *
+     * \param val Receives the value of \p e (0 or 1 for a boolean).
+     * \return false if \p e can not be evaluated.
+     */
+    static bool evaluate(ExprPtr e, const Model &model, long &val);
+    
+    /**
+     * \brief Return the number of lookups.
+     */
+    unsigned long getNbLookups() {
+        return nbLookups;
+    }
+    
+    /**
+     * \brief Return the number of lookups answered by the cache.
+     */
+    unsigned long getNbHits() {
+        return nbExactHits+nbUnsatHits+nbSatHits+nbModelHits;
+    }
+    
+    /**
+     * \brief Print the hit rate of the cache.
+     */
+    void printStats(std::ostream &out);
+
+private:
+    /**
+     * \brief Return true if the sorted set \p a is included in \p b.
+     */
+    static bool isSubset(const std::vector<unsigned> &a,
+                         const std::vector<unsigned> &b);
+
+};
+
+#endif // _CEXCACHE_H
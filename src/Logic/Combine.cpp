@@ -27,9 +27,13 @@
 
 #include "Combine.h"
 
+#include <bitset>
+#include <thread>
+
 
 // Pair-wise union based combination
-SetOfFormulasPtr Combine::combineByPWU(std::vector<SetOfFormulasPtr> D) {
+SetOfFormulasPtr Combine::combineByPWU(std::vector<SetOfFormulasPtr> D,
+                                       unsigned nbThreads) {
     // TODO: remove subsets in D
     /*std::vector<SetOfFormulasPtr> MCSesNoDoublons;
     for (SetOfFormulasPtr M : D) {
@@ -40,7 +44,7 @@ SetOfFormulasPtr Combine::combineByPWU(std::vector<SetOfFormulasPtr> D) {
     SetOfFormulasPtr combMCSes = SetOfFormulas::make();
     if (!D.empty()) {
         // Pair-wise union of MCSes to obtain the complete diagnosis
-        pairwiseUnion(D, combMCSes);
+        pairwiseUnion(D, combMCSes, nbThreads);
     }
     return combMCSes;
 }
@@ -49,40 +53,184 @@ SetOfFormulasPtr Combine::combineByPWU(std::vector<SetOfFormulasPtr> D) {
 // [[[int]]] -> [[int]]
 // [[mcs]]   -> [[mcs]]
 void Combine::pairwiseUnion(std::vector<SetOfFormulasPtr> MCSes,
-                            SetOfFormulasPtr Diag) {
-    // Init
-    int size = MCSes.size();
-    unsigned a[size];
-    for (int i=0; i<size; ++i) {
-        a[i] = 0;
-    }
-    bool done = false;
-    while (!done) {
-        // Unions
+                            SetOfFormulasPtr Diag, unsigned nbThreads) {
+    // Dense indices of the expressions, equal expressions
+    // share their index (as in Formula::contains)
+    std::map<ExprPtr, unsigned> expr2id;
+    std::vector<ExprPtr> exprs;
+    for (SetOfFormulasPtr M : MCSes) {
+        for (FormulaPtr f : M->getFormulas()) {
+            for (ExprPtr e : f->getExprs()) {
+                if (expr2id.count(e)) {
+                    continue;
+                }
+                unsigned id = std::find(exprs.begin(), exprs.end(), e)
+                              - exprs.begin();
+                if (id==exprs.size()) {
+                    exprs.push_back(e);
+                }
+                expr2id[e] = id;
+            }
+        }
+    }
+    const unsigned nbWords = (exprs.size()+63)/64;
+    // MCSes as bitsets
+    std::vector<std::vector<Bits> > B(MCSes.size());
+    for (unsigned i=0; i<MCSes.size(); i++) {
+        for (FormulaPtr f : MCSes[i]->getFormulas()) {
+            Bits b(nbWords, 0);
+            for (ExprPtr e : f->getExprs()) {
+                unsigned id = expr2id[e];
+                b[id/64] |= ((uint64_t) 1)<<(id%64);
+            }
+            B[i].push_back(b);
+        }
+    }
+    // Fold the traces in one at a time, only keeping the maximal
+    // partial unions, as SetOfFormulas::add does with the complete
+    // ones: the unions of a subset with the MCSes of the next traces 
+    // are subsets of the unions of the superset with the same MCSes
+    std::vector<std::vector<Bits> > F(B.size());
+    std::vector<Bits> P(1, Bits(nbWords, 0));
+    for (unsigned i=0; i<B.size(); i++) {
+        const unsigned nbMCSes = B[i].size();
+        std::vector<Bits> U(P.size()*nbMCSes);
+        parallelFor(P.size(), nbThreads, [&](unsigned begin, unsigned end) {
+            for (unsigned p=begin; p<end; p++) {
+                for (unsigned j=0; j<nbMCSes; j++) {
+                    Bits &u = U[p*nbMCSes+j];
+                    u.resize(nbWords);
+                    for (unsigned w=0; w<nbWords; w++) {
+                        u[w] = P[p][w] | B[i][j][w];
+                    }
+                }
+            }
+        });
+        P = getMaximalSets(U, nbThreads);
+        F[i] = P;
+    }
+    // Order the unions by their first tuple of MCSes in the 
+    // enumeration of the cartesian product (the index of the 
+    // last trace being the most significant)
+    std::vector<std::pair<std::vector<unsigned>, unsigned> > order;
+    for (unsigned k=0; k<P.size(); k++) {
+        std::vector<unsigned> a(B.size());
+        getFirstTuple(B, F, P[k], a);
+        order.push_back(std::make_pair(a, k));
+    }
+    std::sort(order.begin(), order.end());
+    // Unions, in the order of the pair-wise enumeration
+    for (unsigned k=0; k<order.size(); k++) {
+        const std::vector<unsigned> &a = order[k].first;
         FormulaPtr S = Formula::make();
-        for (int i=0; i<size; ++i) {
-            SetOfFormulasPtr A = MCSes[i];
-            int j = a[i];
-            FormulaPtr B = A->getAt(j);
-            S->add(B->getExprs());
+        for (unsigned i=0; i<MCSes.size(); i++) {
+            FormulaPtr f = MCSes[i]->getAt(a[MCSes.size()-1-i]);
+            S->add(f->getExprs());
         }
         Diag->add(S);
-        // Update indexes
-        a[0]++;
-        for (int i=0; i<size-1; ++i) {
-            SetOfFormulasPtr A = MCSes[i];
-            if(a[i]>=A->size()) {
-                a[i] = 0;
-                a[i+1]++;
+    }
+}
+
+void Combine::getFirstTuple(const std::vector<std::vector<Bits> > &B,
+                            const std::vector<std::vector<Bits> > &F,
+                            const Bits &target, std::vector<unsigned> &a) {
+    // From the last trace (the most significant index) to the first 
+    // one, take the first MCS included in the target such that a 
+    // partial union of the previous traces covers the rest of the 
+    // target. Such a union is the target, which is maximal, so the
+    // choice is never undone.
+    Bits cover(target.size(), 0);
+    for (unsigned i=B.size(); i-->0; ) {
+        bool found = false;
+        for (unsigned j=0; j<B[i].size() && !found; j++) {
+            if (!isSubset(B[i][j], target)) {
+                continue;
+            }
+            Bits next = cover;
+            for (unsigned w=0; w<next.size(); w++) {
+                next[w] |= B[i][j][w];
+            }
+            if (i==0) {
+                found = isSubset(target, next);
+            }
+            for (unsigned k=0; i>0 && k<F[i-1].size() && !found; k++) {
+                found = true;
+                for (unsigned w=0; w<next.size() && found; w++) {
+                    found = !(target[w] & ~(next[w] | F[i-1][k][w]));
+                }
+            }
+            if (found) {
+                cover = next;
+                a[B.size()-1-i] = j;
             }
         }
-        // Finished?
-        SetOfFormulasPtr A = MCSes[size-1];
-        if (a[size-1]>=A->size()) {
-            done = true;
-            break;
+        assert(found && "No tuple of MCSes for this union!");
+    }
+}
+
+std::vector<Combine::Bits> Combine::getMaximalSets(std::vector<Bits> &U,
+                                                   unsigned nbThreads) {
+    // A set can only include a set with fewer elements
+    std::vector<unsigned> card(U.size(), 0);
+    for (unsigned k=0; k<U.size(); k++) {
+        for (uint64_t w : U[k]) {
+            card[k] += std::bitset<64>(w).count();
         }
     }
+    std::vector<unsigned> ids(U.size());
+    for (unsigned k=0; k<U.size(); k++) {
+        ids[k] = k;
+    }
+    std::stable_sort(ids.begin(), ids.end(), [&](unsigned x, unsigned y) {
+        return card[x]>card[y];
+    });
+    // Keep the sets with no strict superset and no equal set before them
+    std::vector<char> keep(U.size(), 0);
+    parallelFor(ids.size(), nbThreads, [&](unsigned begin, unsigned end) {
+        for (unsigned k=begin; k<end; k++) {
+            const Bits &u = U[ids[k]];
+            bool maximal = true;
+            for (unsigned l=0; l<k && maximal; l++) {
+                maximal = !isSubset(u, U[ids[l]]);
+            }
+            keep[k] = maximal;
+        }
+    });
+    std::vector<Bits> M;
+    for (unsigned k=0; k<ids.size(); k++) {
+        if (keep[k]) {
+            M.push_back(U[ids[k]]);
+        }
+    }
+    return M;
+}
+
+bool Combine::isSubset(const Bits &a, const Bits &b) {
+    for (unsigned w=0; w<a.size(); w++) {
+        if (a[w] & ~b[w]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Combine::parallelFor(unsigned n, unsigned nbThreads,
+                          std::function<void(unsigned, unsigned)> f) {
+    nbThreads = std::max(1u, std::min(nbThreads, n/64));
+    if (nbThreads<2) {
+        f(0, n);
+        return;
+    }
+    std::vector<std::thread> threads;
+    unsigned chunk = (n+nbThreads-1)/nbThreads;
+    for (unsigned t=0; t<nbThreads; t++) {
+        unsigned begin = std::min(n, t*chunk);
+        unsigned end = std::min(n, begin+chunk);
+        threads.push_back(std::thread(f, begin, end));
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
 }
 
 // Minimal-hitting set based combination
@@ -100,7 +248,7 @@ SetOfFormulasPtr Combine::combineByMHS(std::vector<SetOfFormulasPtr> D,
             std::set<ExprPtr> Eset(E.begin(), E.end());
             InMCS.push_back(Eset);
         }
-        HittingSet<ExprPtr>::getMinimalHittingSets_LP(InMCS, OutMUS);
+        HittingSet<ExprPtr>::getMinimalHittingSets_MMCS(InMCS, OutMUS);
         SetOfFormulasPtr MUS = SetOfFormulas::make();
         for (std::set<ExprPtr> s : OutMUS) {
             FormulaPtr f = Formula::make();
@@ -124,7 +272,7 @@ SetOfFormulasPtr Combine::combineByMHS(std::vector<SetOfFormulasPtr> D,
     if (totalNbLine>0) {
         std::cout << "ACSR: " << getCodeSizeReduction(InMUSes, totalNbLine) << "%\n";;
     }
-    HittingSet<ExprPtr>::getMinimalHittingSets_LP(InMUSes, OutCombMCSes);
+    HittingSet<ExprPtr>::getMinimalHittingSets_MMCS(InMUSes, OutCombMCSes);
     SetOfFormulasPtr combMCSes = SetOfFormulas::make();
     for (std::set<ExprPtr> s : OutCombMCSes) {
         FormulaPtr f = Formula::make();
@@ -29,6 +29,9 @@
 #define _COMBINE_H
 
 #include <vector>
+#include <map>
+#include <functional>
+#include <stdint.h>
 
 #include "Utils/HittingSet.h"
 #include "Logic/Formula.h"
@@ -93,9 +96,11 @@ public:
      * combination.
      *
      * \param M A vector of MCSes.
+     * \param nbThreads The number of threads computing the unions.
      * \return a set of complete diagnosis.
      */
-    static SetOfFormulasPtr combineByPWU(std::vector<SetOfFormulasPtr> M);
+    static SetOfFormulasPtr combineByPWU(std::vector<SetOfFormulasPtr> M,
+                                         unsigned nbThreads = 1);
     
     /**
      * \brief Flattening-based combination method.
@@ -116,14 +121,54 @@ public:
     
 private:
     /**
-     * \brief No combination method.
+     * Packed bitset of expressions.
+     */
+    typedef std::vector<uint64_t> Bits;
+    
+    /**
+     * \brief Maximal unions of one MCS of each trace.
      *
+     * The traces are folded in one at a time and the partial unions 
+     * included in other partial unions are dropped at each step, 
+     * instead of enumerating the whole cartesian product of \p M.
+     * The unions are added to \p Diag in the order of this 
+     * enumeration.
      *
      * \param M A vector of MCSes
      * \param Diag An MCSes (output).
+     * \param nbThreads The number of threads computing the unions.
      */
     static void pairwiseUnion(std::vector<SetOfFormulasPtr> M,
-                            SetOfFormulasPtr Diag);
+                            SetOfFormulasPtr Diag, unsigned nbThreads);
+    
+    /**
+     * Return the maximal sets of \p U (one set per group 
+     * of equal sets), by decreasing size.
+     */
+    static std::vector<Bits> getMaximalSets(std::vector<Bits> &U,
+                                            unsigned nbThreads);
+    
+    /**
+     * Compute in \p a the first tuple of MCSes of \p B in the 
+     * enumeration of the cartesian product whose union is the 
+     * maximal union \p target. \p F contains the maximal partial
+     * unions of the traces 0..i kept by the fold, for each i.
+     */
+    static void getFirstTuple(const std::vector<std::vector<Bits> > &B,
+                              const std::vector<std::vector<Bits> > &F,
+                              const Bits &target, std::vector<unsigned> &a);
+    
+    /**
+     * Return true if \p a is a subset (or equal) of \p b.
+     */
+    static bool isSubset(const Bits &a, const Bits &b);
+    
+    /**
+     * Call \p f on \p nbThreads chunks [begin,end) of [0,n) in
+     * parallel (sequentially for small \p n).
+     */
+    static void parallelFor(unsigned n, unsigned nbThreads,
+                            std::function<void(unsigned, unsigned)> f);
 
     /**
      * \brief Calculate the average code size reduction (ACSR).
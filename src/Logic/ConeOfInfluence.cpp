@@ -0,0 +1,199 @@
+/**
+ * \file ConeOfInfluence.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#include "ConeOfInfluence.h"
+
+#include <deque>
+
+bool ConeOfInfluence::getVariables(ExprPtr e, std::set<unsigned> &vars) {
+    switch (e->getOpCode()) {
+        case Expression::True:
+        case Expression::False:
+        case Expression::UInt32Num:
+        case Expression::SInt32Num:
+            return true;
+        case Expression::BoolVar:
+        case Expression::IntVar:
+        case Expression::IntToIntVar: {
+            SingleExprPtr se = std::static_pointer_cast<SingleExpression>(e);
+            vars.insert(se->getNameID());
+            return true;
+        }
+        case Expression::Not: {
+            NotExprPtr ne = std::static_pointer_cast<NotExpression>(e);
+            return getVariables(ne->get(), vars);
+        }
+        case Expression::And:
+        case Expression::Or:
+        case Expression::Xor:
+        case Expression::Sum:
+        case Expression::Sub:
+        case Expression::Mul: {
+            UnaryExprPtr ue = std::static_pointer_cast<UnaryExpression>(e);
+            for (ExprPtr e2 : ue->getExprs()) {
+                if (!getVariables(e2, vars)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case Expression::Gt:
+        case Expression::Ge:
+        case Expression::Le:
+        case Expression::Lt:
+        case Expression::Diseq:
+        case Expression::Eq:
+        case Expression::Div:
+        case Expression::Mod:
+        case Expression::App: {
+            BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(e);
+            return getVariables(be->getExpr1(), vars)
+                && getVariables(be->getExpr2(), vars);
+        }
+        case Expression::Ite:
+        case Expression::Update: {
+            TrinaryExprPtr te = std::static_pointer_cast<TrinaryExpression>(e);
+            return getVariables(te->getExpr1(), vars)
+                && getVariables(te->getExpr2(), vars)
+                && getVariables(te->getExpr3(), vars);
+        }
+        default:
+            // Expression to parse
+            return false;
+    }
+}
+
+bool ConeOfInfluence::getDefinitions(ExprPtr e, 
+                                     std::vector<BinaryExprPtr> &defs) {
+    if (e->getOpCode()==Expression::And) {
+        UnaryExprPtr ue = std::static_pointer_cast<UnaryExpression>(e);
+        for (ExprPtr e2 : ue->getExprs()) {
+            if (!getDefinitions(e2, defs)) {
+                return false;
+            }
+        }
+        return !defs.empty();
+    }
+    if (e->getOpCode()!=Expression::Eq) {
+        return false;
+    }
+    BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(e);
+    switch (be->getExpr1()->getOpCode()) {
+        case Expression::BoolVar:
+        case Expression::IntVar:
+        case Expression::IntToIntVar:
+            defs.push_back(be);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void ConeOfInfluence::reduce(Formula *f, std::set<unsigned> &vars,
+                             unsigned &nbHard, unsigned &nbSoft) {
+    nbHard = 0;
+    nbSoft = 0;
+    std::vector<ExprPtr> exprs = f->getExprs();
+    // Variables of each expression, and expressions
+    // defining each variable
+    std::vector<std::set<unsigned> > exprVars(exprs.size());
+    std::map<unsigned, std::vector<unsigned> > definedBy;
+    std::vector<bool> keep(exprs.size(), false);
+    std::set<unsigned> roots = vars;
+    for (unsigned i=0; i<exprs.size(); i++) {
+        if (!getVariables(exprs[i], exprVars[i])) {
+            return;
+        }
+        std::vector<BinaryExprPtr> defs;
+        bool isDef = getDefinitions(exprs[i], defs);
+        std::set<unsigned> defVars;
+        for (unsigned j=0; isDef && j<defs.size(); j++) {
+            SingleExprPtr x = 
+            std::static_pointer_cast<SingleExpression>(defs[j]->getExpr1());
+            std::set<unsigned> used;
+            getVariables(defs[j]->getExpr2(), used);
+            if (used.count(x->getNameID()) || 
+                !defVars.insert(x->getNameID()).second) {
+                isDef = false;
+            }
+        }
+        if (!isDef) {
+            // Root expression
+            keep[i] = true;
+            roots.insert(exprVars[i].begin(), exprVars[i].end());
+            continue;
+        }
+        for (unsigned x : defVars) {
+            definedBy[x].push_back(i);
+        }
+    }
+    // Variables defined more than once are roots
+    std::map<unsigned, std::vector<unsigned> >::iterator it;
+    for (it=definedBy.begin(); it!=definedBy.end(); ++it) {
+        if (it->second.size()>1) {
+            roots.insert(it->first);
+        }
+    }
+    // Follow the definitions backwards from the roots
+    std::set<unsigned> cone;
+    std::deque<unsigned> worklist(roots.begin(), roots.end());
+    while (!worklist.empty()) {
+        unsigned x = worklist.front();
+        worklist.pop_front();
+        if (!cone.insert(x).second) {
+            continue;
+        }
+        it = definedBy.find(x);
+        if (it==definedBy.end()) {
+            continue;
+        }
+        for (unsigned i : it->second) {
+            if (keep[i]) {
+                continue;
+            }
+            keep[i] = true;
+            for (unsigned y : exprVars[i]) {
+                if (!cone.count(y)) {
+                    worklist.push_back(y);
+                }
+            }
+        }
+    }
+    // Remove the expressions out of the cone
+    std::vector<ExprPtr> kept;
+    for (unsigned i=0; i<exprs.size(); i++) {
+        if (keep[i]) {
+            kept.push_back(exprs[i]);
+        } else if (exprs[i]->isSoft()) {
+            nbSoft++;
+        } else {
+            nbHard++;
+        }
+    }
+    *f = Formula(kept);
+}
@@ -0,0 +1,99 @@
+/**
+ * \file ConeOfInfluence.h
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#ifndef _CONEOFINFLUENCE_H
+#define _CONEOFINFLUENCE_H
+
+#include <vector>
+#include <set>
+#include <map>
+
+#include "Expression.h"
+#include "Formula.h"
+
+/**
+ * \class ConeOfInfluence
+ *
+ * \brief Cone-of-influence reduction of a trace formula.
+ *
+ * An expression of the form (= x e), or a conjunction of such 
+ * equalities, defines the variables x from the variables of e
+ * (the encoder produces one definition per SSA value). Every 
+ * other expression (post-conditions, control-flow constraints 
+ * of the return block, ...) is a root and is always kept.
+ *
+ * The cone of influence is the set of variables reachable from 
+ * the roots and from a given set of variables by following the 
+ * definitions backwards. A definition is kept if it defines a 
+ * variable of the cone, otherwise it is removed: its variables 
+ * can always be evaluated from the ones of the cone, so removing 
+ * it does not change the satisfiability of the formula nor its 
+ * MCSes. A variable defined more than once, or by an expression 
+ * that uses it, is treated as a root.
+ */
+class ConeOfInfluence {
+
+public:
+    /**
+     * \brief Collect the name IDs of the variables of \p e.
+     *
+     * \param e An expression.
+     * \param vars Receives the name IDs of the variables.
+     * \return false if the variables of \p e cannot be known 
+     *         (expression to parse), true otherwise.
+     */
+    static bool getVariables(ExprPtr e, std::set<unsigned> &vars);
+    
+    /**
+     * \brief Remove from \p f the expressions that are not 
+     *        in the cone of influence of its roots and of \p vars.
+     *
+     * The formula is left unchanged if it contains an 
+     * expression to parse.
+     *
+     * \param f A formula.
+     * \param vars Variables of the constraints that will be added 
+     *        to the formula later (e.g. the error-inducing inputs 
+     *        and the golden output).
+     * \param nbHard Receives the number of hard expressions removed.
+     * \param nbSoft Receives the number of soft expressions removed.
+     */
+    static void reduce(Formula *f, std::set<unsigned> &vars,
+                       unsigned &nbHard, unsigned &nbSoft);
+
+private:
+    /**
+     * Collect in \p defs the definitions (= x e) of \p e, that is 
+     * \p e itself or the conjuncts of \p e. Return false if \p e 
+     * is not a definition.
+     */
+    static bool getDefinitions(ExprPtr e, std::vector<BinaryExprPtr> &defs);
+
+};
+
+#endif // _CONEOFINFLUENCE_H
@@ -0,0 +1,177 @@
+/**
+ * \file DiagnosisReporter.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+
+#include "DiagnosisReporter.h"
+#include "SolverStats.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <set>
+#include <sstream>
+#include <unistd.h>
+
+int DiagnosisReporter::fd = -1;
+bool DiagnosisReporter::owned = false;
+double DiagnosisReporter::startTime = 0;
+int DiagnosisReporter::traceID = -1;
+
+bool DiagnosisReporter::open(std::string filename) {
+    close();
+    if (filename.empty()) {
+        return true;
+    }
+    if (filename=="-") {
+        fd = STDOUT_FILENO;
+        owned = false;
+    } else {
+        fd = ::open(filename.c_str(), O_WRONLY|O_CREAT|O_TRUNC|O_APPEND, 0644);
+        if (fd<0) {
+            return false;
+        }
+        owned = true;
+    }
+    startTime = SolverStats::getTime();
+    return true;
+}
+
+void DiagnosisReporter::close() {
+    if (fd>=0 && owned) {
+        ::close(fd);
+    }
+    fd = -1;
+    owned = false;
+}
+
+void DiagnosisReporter::reportMCS(std::vector<ExprPtr> mcs) {
+    if (!isEnabled()) {
+        return;
+    }
+    std::ostringstream oss;
+    oss << "{\"event\": \"mcs\", \"trace\": " << traceID;
+    oss << ", \"lines\": " << linesToJSON(mcs);
+    oss << ", \"elapsed_ms\": " << getElapsedTime() << "}\n";
+    writeLine(oss.str());
+}
+
+void DiagnosisReporter::reportTrace(int id, unsigned nbMCSes, bool complete,
+                                    bool shared) {
+    if (!isEnabled()) {
+        return;
+    }
+    std::ostringstream oss;
+    oss << "{\"event\": \"trace\", \"trace\": " << id;
+    oss << ", \"mcses\": " << nbMCSes;
+    oss << ", \"complete\": " << (complete ? "true" : "false");
+    oss << ", \"shared\": " << (shared ? "true" : "false");
+    oss << ", \"elapsed_ms\": " << getElapsedTime() << "}\n";
+    writeLine(oss.str());
+}
+
+void DiagnosisReporter::reportMUS(int id, std::vector<ExprPtr> mus,
+                                  bool minimal) {
+    if (!isEnabled()) {
+        return;
+    }
+    std::ostringstream oss;
+    oss << "{\"event\": \"mus\", \"trace\": " << id;
+    oss << ", \"lines\": " << linesToJSON(mus);
+    oss << ", \"minimal\": " << (minimal ? "true" : "false");
+    oss << ", \"elapsed_ms\": " << getElapsedTime() << "}\n";
+    writeLine(oss.str());
+}
+
+void DiagnosisReporter::reportDiagnoses(std::string method,
+                                        SetOfFormulasPtr diagnoses) {
+    if (!isEnabled() || !diagnoses) {
+        return;
+    }
+    for (FormulaPtr f : diagnoses->getFormulas()) {
+        std::ostringstream oss;
+        oss << "{\"event\": \"diagnosis\", \"method\": \"" << method << "\"";
+        oss << ", \"lines\": " << linesToJSON(f->getExprs());
+        oss << ", \"elapsed_ms\": " << getElapsedTime() << "}\n";
+        writeLine(oss.str());
+    }
+}
+
+void DiagnosisReporter::reportDone(unsigned nbTraces, unsigned nbMCSes,
+                                   unsigned nbDiagnoses) {
+    if (!isEnabled()) {
+        return;
+    }
+    std::ostringstream oss;
+    oss << "{\"event\": \"done\", \"traces\": " << nbTraces;
+    oss << ", \"mcses\": " << nbMCSes;
+    oss << ", \"diagnoses\": " << nbDiagnoses;
+    oss << ", \"elapsed_ms\": " << getElapsedTime() << "}\n";
+    writeLine(oss.str());
+}
+
+std::string DiagnosisReporter::linesToJSON(std::vector<ExprPtr> es) {
+    std::set<unsigned> lines;
+    for (ExprPtr e : es) {
+        if (e->getLine()>0) {
+            lines.insert(e->getLine());
+        }
+    }
+    std::ostringstream oss;
+    oss << "[";
+    for (std::set<unsigned>::iterator it=lines.begin(); it!=lines.end(); ++it) {
+        oss << (it!=lines.begin() ? ", " : "") << *it;
+    }
+    oss << "]";
+    return oss.str();
+}
+
+void DiagnosisReporter::writeLine(std::string line) {
+    if (fd==STDOUT_FILENO) {
+        // The human-readable output is buffered, write 
+        // it first so that the lines are not mixed
+        std::cout.flush();
+        fflush(stdout);
+    }
+    const char *buf = line.c_str();
+    size_t size = line.size();
+    while (size>0) {
+        ssize_t n = write(fd, buf, size);
+        if (n<0 && errno==EINTR) {
+            continue;
+        }
+        if (n<=0) {
+            return;
+        }
+        buf  += n;
+        size -= n;
+    }
+}
+
+double DiagnosisReporter::getElapsedTime() {
+    return SolverStats::getTime()-startTime;
+}
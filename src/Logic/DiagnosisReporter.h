@@ -0,0 +1,172 @@
+/**
+ * \file DiagnosisReporter.h
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#ifndef _DIAGNOSISREPORTER_H
+#define _DIAGNOSISREPORTER_H
+
+#include <string>
+#include <vector>
+
+#include "Expression.h"
+#include "Formula.h"
+
+/**
+ * \class DiagnosisReporter
+ *
+ * \brief Stream the diagnoses as JSON lines while they are found.
+ *
+ * When a stream is opened, one JSON object is written per line and
+ * per event, as soon as the event happens:
+ *
+ *   {"event": "mcs", "trace": 3, "lines": [21, 34], "elapsed_ms": 12.5}
+ *   {"event": "trace", "trace": 3, "mcses": 2, "complete": true, 
+ *    "shared": false, "elapsed_ms": 13.1}
+ *   {"event": "mus", "trace": 3, "lines": [21, 40], "minimal": true, 
+ *    "elapsed_ms": 15.2}
+ *   {"event": "diagnosis", "method": "PWU", "lines": [21], "elapsed_ms": 20.0}
+ *   {"event": "done", "traces": 4, "mcses": 7, "diagnoses": 3, 
+ *    "elapsed_ms": 20.2}
+ *
+ * An mcs event is written by the enumeration as soon as an MCS
+ * is found (possibly in a worker process, see -jobs), a trace 
+ * event when the MCSes of a failing trace are known (shared if 
+ * they were taken from the traces of the same path), a mus event
+ * if the MUSes are extracted (see Options::printMUS), then the 
+ * combined diagnoses and a final done event. The elapsed time is
+ * measured from the opening of the stream.
+ *
+ * Each line is written with a single write call on a descriptor 
+ * opened in append mode, so that the lines of the worker processes
+ * are not interleaved.
+ */
+class DiagnosisReporter {
+
+private:
+    /**
+     * Descriptor of the stream (-1 if disabled).
+     */
+    static int fd;
+    /**
+     * True if the descriptor has to be closed.
+     */
+    static bool owned;
+    /**
+     * Opening time of the stream (ms).
+     */
+    static double startTime;
+    /**
+     * ID of the trace being diagnosed (-1 if none).
+     */
+    static int traceID;
+
+public:
+    /**
+     * \brief Open the stream in the file \p filename (the standard 
+     *        output if "-"), or disable it if \p filename is empty.
+     *
+     * On the standard output, std::cout and stdout are flushed before 
+     * each line, so that a line never starts within the buffered 
+     * human-readable output.
+     *
+     * \return false if the file can not be opened.
+     */
+    static bool open(std::string filename);
+    
+    /**
+     * \brief Close the stream.
+     */
+    static void close();
+    
+    /**
+     * \brief Return \a true if the diagnoses are streamed.
+     */
+    static bool isEnabled() {
+        return fd>=0;
+    }
+    
+    /**
+     * \brief Set the ID of the trace being diagnosed (-1 if none).
+     */
+    static void setTraceID(int id) {
+        traceID = id;
+    }
+    
+    /**
+     * \brief Report an MCS of the trace being diagnosed.
+     *
+     * \param mcs The expressions of the MCS.
+     */
+    static void reportMCS(std::vector<ExprPtr> mcs);
+    
+    /**
+     * \brief Report that the MCSes of a trace are known.
+     *
+     * \param id The ID of the trace.
+     * \param nbMCSes The number of MCSes.
+     * \param complete False if the enumeration was stopped.
+     * \param shared True if the MCSes are the ones of the
+     *        traces of the same path.
+     */
+    static void reportTrace(int id, unsigned nbMCSes, bool complete,
+                            bool shared);
+    
+    /**
+     * \brief Report the MUS of a trace.
+     *
+     * \param id The ID of the trace.
+     * \param mus The expressions of the MUS.
+     * \param minimal False if the extraction was stopped.
+     */
+    static void reportMUS(int id, std::vector<ExprPtr> mus, bool minimal);
+    
+    /**
+     * \brief Report the combined diagnoses.
+     *
+     * \param method The name of the combination method.
+     * \param diagnoses The combined diagnoses.
+     */
+    static void reportDiagnoses(std::string method, SetOfFormulasPtr diagnoses);
+    
+    /**
+     * \brief Report the end of the fault localization.
+     */
+    static void reportDone(unsigned nbTraces, unsigned nbMCSes,
+                           unsigned nbDiagnoses);
+    
+    /**
+     * \brief Return the sorted line numbers of \p es as a JSON array.
+     */
+    static std::string linesToJSON(std::vector<ExprPtr> es);
+
+private:
+    static void writeLine(std::string line);
+    static double getElapsedTime();
+
+};
+
+#endif // _DIAGNOSISREPORTER_H
@@ -30,6 +30,28 @@
 unsigned Expression::ID = 0;
 unsigned Expression::NbIntVariables = 0;
 unsigned Expression::NbBoolVariables = 0;
+std::vector<std::string> Expression::Names;
+std::unordered_map<std::string, unsigned> Expression::NameIDs;
+
+unsigned Expression::internName(const std::string &name) {
+    auto it = NameIDs.find(name);
+    if (it!=NameIDs.end()) {
+        return it->second;
+    }
+    const unsigned id = Names.size();
+    Names.push_back(name);
+    NameIDs[name] = id;
+    return id;
+}
+
+bool Expression::lookupName(const std::string &name, unsigned &id) {
+    auto it = NameIDs.find(name);
+    if (it==NameIDs.end()) {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
 
 TrueExprPtr Expression::mkTrue() {
     return std::make_shared<TrueExpression>();
@@ -123,6 +145,10 @@ IteExprPtr Expression::mkIte(ExprPtr econd, ExprPtr ethen, ExprPtr eelse) {
 SumExprPtr Expression::mkSum(ExprPtr e1, ExprPtr e2) {
     return std::make_shared<SumExpression>(e1, e2);    
 }
+
+SumExprPtr Expression::mkSum(std::vector<ExprPtr> es) {
+    return std::make_shared<SumExpression>(es);
+}
     
 SubExprPtr Expression::mkSub(ExprPtr e1, ExprPtr e2) {
     return std::make_shared<SubExpression>(e1, e2);
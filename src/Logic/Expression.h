@@ -33,6 +33,8 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/BasicBlock.h"
@@ -169,6 +171,11 @@ private:
      * from which the expression was encoded.
      */
     unsigned line;
+    /**
+     * Weight of the expression when it is soft (cost of 
+     * falsifying it in a max-sat query).
+     */
+    unsigned weight;
 protected:
     /**
      * Number of integer variables created.
@@ -178,12 +185,20 @@ protected:
      * Number of Boolean variables created.
      */
     static unsigned NbBoolVariables;
+    /**
+     * Interned variable names, indexed by their name ID.
+     */
+    static std::vector<std::string> Names;
+    /**
+     * Map of interned variable names to their name ID.
+     */
+    static std::unordered_map<std::string, unsigned> NameIDs;
 protected:
     /**
      * Default constructor.
      */
     Expression()
-    : currentID(ID++), soft(true), instruction(NULL), line(0) { }
+    : currentID(ID++), soft(true), instruction(NULL), line(0), weight(1) { }
     /**
      * Destructor.
      */
@@ -282,6 +297,10 @@ public:
      * Return an expression representing \a e1 + e2.
      */
     static SumExprPtr mkSum(ExprPtr e1, ExprPtr e2);
+    /**
+     * Return an expression representing \a es_0 + es_1 ... + es_n-1.
+     */
+    static SumExprPtr mkSum(std::vector<ExprPtr> es);
     /**
      * Return an expression representing \a e1 + e2 (signed).
      *
@@ -359,6 +378,32 @@ public:
     static unsigned getNbBoolVariables() {
         return NbBoolVariables;
     }
+    /**
+     * Return the name ID of the variable name \a name. 
+     *
+     * Name IDs are dense (0, 1, 2, ...) and two variable expressions 
+     * with the same name share the same name ID. The name is interned 
+     * if it was never seen before.
+     */
+    static unsigned internName(const std::string &name);
+    /**
+     * Return \a true and set \a id to the name ID of \a name if 
+     * \a name was already interned, false otherwise.
+     */
+    static bool lookupName(const std::string &name, unsigned &id);
+    /**
+     * Return the variable name of the name ID \a id.
+     */
+    static const std::string& getInternedName(unsigned id) {
+        assert(id<Names.size() && "Unknown name ID!");
+        return Names[id];
+    }
+    /**
+     * Return the number of interned variable names.
+     */
+    static unsigned getNbInternedNames() {
+        return Names.size();
+    }
     /**
      * Return \a true if the expresseion is soft (retractable), 
      * false otherwise.
@@ -408,6 +453,19 @@ public:
     unsigned getLine() {
         return line;
     }
+    /**
+     * Set the weight of this expression when it is soft (at least 1).
+     */
+    void setWeight(unsigned w) {
+        assert(w>0 && "Null weight!");
+        weight = w;
+    }
+    /**
+     * Return the weight of this expression when it is soft (1 by default).
+     */
+    unsigned getWeight() {
+        return weight;
+    }
     /**
      * Return the LLVM instruction from which the expression was encoded.
      * If no instruction was assigned to this expression,
@@ -463,6 +521,10 @@ public:
 class SingleExpression : public Expression {
 protected:
     std::string name;
+    /**
+     * Name ID of the variable (see Expression::internName).
+     */
+    const unsigned nameID;
     /**
      * Default constructor.
      *
@@ -470,7 +532,7 @@ protected:
      * example the name of a variable).
      */
     SingleExpression(std::string _name) 
-    : name(_name) { }
+    : name(_name), nameID(Expression::internName(_name)) { }
 public:
     /**
      * Return the name of the variable.
@@ -478,6 +540,15 @@ public:
     std::string getName() {
         return name;
     }
+    /**
+     * Return the name ID of the variable.
+     *
+     * All variable expressions with the same name 
+     * have the same name ID.
+     */
+    unsigned getNameID() {
+        return nameID;
+    }
 };
 
 /**
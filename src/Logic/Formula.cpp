@@ -175,25 +175,15 @@ bool Formula::contains(const FormulaPtr other) {
     if (this->size()<other->size()) {
         return false;
     }
-    std::vector<ExprPtr> E1 = this->exprs;
+    // Each expression of other must be in this formula,
+    // in any position
     std::vector<ExprPtr> E2 = other->getExprs();
-    std::vector<ExprPtr>::const_iterator it1;
-    for (it1 = E1.begin(); it1 != E1.end(); ++it1) {
-        bool match = true;
-        std::vector<ExprPtr>::const_iterator it2 = it1;
-        std::vector<ExprPtr>::const_iterator it3;
-        for (it3 = E2.begin(); it3 != E2.end(); ++it3) {
-                if (it2==E1.end() || *it3!=*it2) {
-                    match = false;
-                    break;
-                }
-                it2++;
-        }
-        if (match) {
-            return true;
+    for (ExprPtr e : E2) {
+        if (std::find(exprs.begin(), exprs.end(), e)==exprs.end()) {
+            return false;
         }
     }
-    return false;
+    return true;
 }
 
 // Return true if f1 is equal to f2, false otherwise
@@ -281,6 +271,70 @@ FormulaPtr SetOfFormulas::getAt(unsigned i) {
     return this->formulas[i];
 }
 
+void SetOfFormulas::addMinimal(FormulaPtr f) {
+    std::vector<ExprPtr> E = f->getExprs();
+    std::set<ExprPtr> S(E.begin(), E.end());
+    auto i = std::begin(formulas);
+    while (i != std::end(formulas)) {
+        std::vector<ExprPtr> E2 = (*i)->getExprs();
+        std::set<ExprPtr> S2(E2.begin(), E2.end());
+        // f2 \subseteq f
+        if (std::includes(S.begin(), S.end(), S2.begin(), S2.end())) {
+            return;
+        }
+        // f \subset f2
+        else if (std::includes(S2.begin(), S2.end(), S.begin(), S.end())) {
+            i = formulas.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    this->formulas.push_back(f);
+}
+
+void SetOfFormulas::sort(const std::vector<ExprPtr> &order) {
+    std::map<Expression*, unsigned> pos;
+    for (unsigned i=0; i<order.size(); i++) {
+        pos.insert(std::make_pair(order[i].get(), i));
+    }
+    // Stratum (greatest weight) and positions 
+    // of the expressions of each formula
+    std::vector<unsigned> strata;
+    std::vector<std::pair<std::vector<unsigned>, unsigned> > keys;
+    for (unsigned k=0; k<formulas.size(); k++) {
+        std::vector<unsigned> key;
+        unsigned stratum = 0;
+        for (ExprPtr e : formulas[k]->getExprs()) {
+            assert(pos.count(e.get()) && "Unexpected expression!");
+            key.push_back(pos[e.get()]);
+            stratum = std::max(stratum, e->getWeight());
+        }
+        std::sort(key.begin(), key.end());
+        keys.push_back(std::make_pair(key, k));
+        strata.push_back(stratum);
+    }
+    std::sort(keys.begin(), keys.end(), 
+              [&strata](const std::pair<std::vector<unsigned>, unsigned> &a,
+                        const std::pair<std::vector<unsigned>, unsigned> &b) {
+                  if (strata[a.second]!=strata[b.second]) {
+                      return strata[a.second]<strata[b.second];
+                  }
+                  if (a.first.size()!=b.first.size()) {
+                      return a.first.size()<b.first.size();
+                  }
+                  return a.first<b.first;
+              });
+    std::vector<FormulaPtr> sorted;
+    for (auto &key : keys) {
+        std::vector<ExprPtr> E;
+        for (unsigned i : key.first) {
+            E.push_back(order[i]);
+        }
+        sorted.push_back(std::make_shared<Formula>(E));
+    }
+    this->formulas = sorted;
+}
+
 double SetOfFormulas::getCodeSizeReduction(unsigned totalNbLine) {
     
     std::vector<double> CSR(formulas.size());
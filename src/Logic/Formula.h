@@ -30,6 +30,7 @@
 
 #include <string>
 #include <set>
+#include <map>
 #include <vector>
 #include <iostream>
 #include <iterator>
@@ -340,6 +341,30 @@ public:
      */
     void add(std::vector<FormulaPtr> formulas);
     
+    /**
+     * \brief Add a formula, the formulas being compared as sets.
+     *
+     * The formula \a M is added only if no formula of the set
+     * is a subset of (or equal to) \a M. The formulas that are 
+     * strict supersets of \a M are removed.
+     *
+     * \param M A formula.
+     */
+    void addMinimal(FormulaPtr M);
+    
+    /**
+     * \brief Sort the formulas by stratum (the greatest weight of 
+     *        their expressions), by size, then by the positions 
+     *        of their expressions in \a order.
+     *
+     * The expressions of each formula are sorted by position too, 
+     * so that the order does not depend on the order in which 
+     * the formulas were found.
+     *
+     * \param order The expressions (e.g. the soft constraints).
+     */
+    void sort(const std::vector<ExprPtr> &order);
+    
     /**
      * \brief Return the size (number of formulas)
      *        of the set of formulas.
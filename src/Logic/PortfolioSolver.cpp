@@ -0,0 +1,507 @@
+/**
+ * \file PortfolioSolver.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#include "PortfolioSolver.h"
+#include "QueryRecorder.h"
+
+#include <map>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// Write the whole buffer in fd
+static bool writeAll(int fd, const char *buf, size_t size) {
+    while (size>0) {
+        ssize_t n = write(fd, buf, size);
+        if (n<0 && errno==EINTR) {
+            continue;
+        }
+        if (n<=0) {
+            return false;
+        }
+        buf  += n;
+        size -= n;
+    }
+    return true;
+}
+
+PortfolioSolver::PortfolioSolver(unsigned n) : cost(0), nbFallbacks(0),
+                                               timeout(0), memoryLimit(0),
+                                               nbTimeouts(0), weighted(false) {
+    if (n>NbConfigs) {
+        std::cerr << "warning: only " << NbConfigs;
+        std::cerr << " portfolio configurations, using " << NbConfigs;
+        std::cerr << " workers.\n";
+        n = NbConfigs;
+    }
+    nbWorkers = n>0 ? n : 1;
+    nbWins.resize(NbConfigs, 0);
+}
+
+std::string PortfolioSolver::getConfigName(unsigned c) {
+    switch (c) {
+        case YICES_MAXSAT: return "yices";
+        case CORE_MAXSAT:  return "core";
+        default:           return "unknown";
+    }
+}
+
+void PortfolioSolver::runWorker(SolverBackend *solver, unsigned c,
+                                std::vector<ExprPtr> &softs, int fd) {
+    limitMemory();
+    if (c==CORE_MAXSAT) {
+        solver->convertMaxSatAlgorithm(SolverBackend::CORE);
+    } else {
+        solver->convertMaxSatAlgorithm(SolverBackend::NATIVE);
+    }
+    int res = solver->maxSat();
+    double answerCost = 0;
+    std::vector<unsigned> indices;
+    if (res==SolverBackend::True) {
+        answerCost = solver->getCostAsDouble();
+        std::map<Expression*, unsigned> index;
+        for (unsigned i=0; i<softs.size(); i++) {
+            index[softs[i].get()] = i;
+        }
+        for (ExprPtr e : solver->getUnsatExpressions()) {
+            indices.push_back(index[e.get()]);
+        }
+    }
+    // Answer: result, cost, number of falsified soft 
+    // expressions and their indices
+    unsigned size = indices.size();
+    std::string msg;
+    msg.append((const char*) &res, sizeof(res));
+    msg.append((const char*) &answerCost, sizeof(answerCost));
+    msg.append((const char*) &size, sizeof(size));
+    if (size>0) {
+        msg.append((const char*) &indices[0], size*sizeof(unsigned));
+    }
+    writeAll(fd, msg.data(), msg.size());
+}
+
+void PortfolioSolver::limitMemory() {
+    if (memoryLimit>0) {
+        struct rlimit rl;
+        rl.rlim_cur = rl.rlim_max = (rlim_t) memoryLimit*1024*1024;
+        setrlimit(RLIMIT_AS, &rl);
+    }
+}
+
+int PortfolioSolver::maxSat(SolverBackend *solver) {
+    double startTime = SolverStats::getTime();
+    std::vector<ExprPtr> softs = solver->getSoftExpressions();
+    // The buffered output would be duplicated in the workers
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(NULL);
+    // Launch the workers
+    std::vector<pid_t> pids;
+    std::vector<int> fds;
+    std::vector<unsigned> configs;
+    for (unsigned k=0; k<nbWorkers; k++) {
+        // A single worker keeps the algorithm of the solver
+        unsigned c = k;
+        if (nbWorkers==1 && solver->getMaxSatAlgorithm()==SolverBackend::CORE) {
+            c = CORE_MAXSAT;
+        }
+        // The core-guided configuration ignores the weights
+        if (weighted && nbWorkers>1 && c==CORE_MAXSAT) {
+            continue;
+        }
+        int p[2];
+        if (pipe(p)!=0) {
+            break;
+        }
+        pid_t pid = fork();
+        if (pid<0) {
+            close(p[0]);
+            close(p[1]);
+            break;
+        }
+        if (pid==0) {
+            // Worker
+            close(p[0]);
+            for (int fd : fds) {
+                close(fd);
+            }
+            // The query is recorded by the first worker only
+            if (!pids.empty()) {
+                QueryRecorder::setDirectory("");
+            }
+            runWorker(solver, c, softs, p[1]);
+            close(p[1]);
+            _exit(0);
+        }
+        close(p[1]);
+        pids.push_back(pid);
+        fds.push_back(p[0]);
+        configs.push_back(c);
+    }
+    // Wait for the first complete answer
+    const size_t header = sizeof(int)+sizeof(double)+sizeof(unsigned);
+    std::vector<std::string> buffers(fds.size());
+    std::vector<bool> running(fds.size(), true);
+    std::vector<bool> stopped(fds.size(), false);
+    unsigned nbRunning = fds.size();
+    int winner = -1;
+    bool outOfTime = false;
+    while (winner<0 && nbRunning>0) {
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        int maxfd = -1;
+        for (unsigned i=0; i<fds.size(); i++) {
+            if (running[i]) {
+                FD_SET(fds[i], &rfds);
+                if (fds[i]>maxfd) maxfd = fds[i];
+            }
+        }
+        struct timeval tv;
+        struct timeval *ptv = NULL;
+        if (timeout>0) {
+            double left = startTime+timeout-SolverStats::getTime();
+            if (left<=0) {
+                outOfTime = true;
+                break;
+            }
+            tv.tv_sec  = (long) (left/1000);
+            tv.tv_usec = (long) ((left-tv.tv_sec*1000.0)*1000);
+            ptv = &tv;
+        }
+        int nbReady = select(maxfd+1, &rfds, NULL, NULL, ptv);
+        if (nbReady<0) {
+            if (errno==EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (nbReady==0) {
+            continue; // Timeout (checked above)
+        }
+        for (unsigned i=0; i<fds.size() && winner<0; i++) {
+            if (!running[i] || !FD_ISSET(fds[i], &rfds)) {
+                continue;
+            }
+            char buf[4096];
+            ssize_t n = read(fds[i], buf, sizeof(buf));
+            if (n>0) {
+                buffers[i].append(buf, n);
+                continue;
+            }
+            if (n<0 && errno==EINTR) {
+                continue;
+            }
+            // End of the answer
+            running[i] = false;
+            stopped[i] = n==0;
+            nbRunning--;
+            const std::string &msg = buffers[i];
+            if (msg.size()<header) {
+                continue; // The worker failed
+            }
+            int res;
+            unsigned size;
+            msg.copy((char*) &res, sizeof(res), 0);
+            msg.copy((char*) &size, sizeof(size), sizeof(int)+sizeof(double));
+            if (res==SolverBackend::Undef 
+                || msg.size()!=header+size*sizeof(unsigned)) {
+                continue;
+            }
+            winner = i;
+        }
+    }
+    // Kill the other workers (a worker that already stopped 
+    // without answering may have been killed by the memory limit)
+    bool outOfMemory = false;
+    for (unsigned i=0; i<pids.size(); i++) {
+        if ((int) i!=winner && !stopped[i]) {
+            kill(pids[i], SIGKILL);
+        }
+        close(fds[i]);
+        int status = 0;
+        waitpid(pids[i], &status, 0);
+        if ((int) i!=winner && stopped[i]
+            && WIFSIGNALED(status) && WTERMSIG(status)==SIGKILL) {
+            outOfMemory = true;
+        }
+    }
+    unsatExprs.clear();
+    cost = 0;
+    int res;
+    if (winner<0 && (outOfTime || outOfMemory)) {
+        // The budget ran out
+        nbTimeouts++;
+        SolverStats::record(true, SolverStats::getTime()-startTime,
+                            solver->getNbHardAsserts(),
+                            solver->getNbSoftAsserts(),
+                            solver->getNbVarDecls(), SolverBackend::Undef);
+        return SolverBackend::Undef;
+    }
+    if (winner<0) {
+        // No answer (the workers could not be launched or crashed),
+        // solve the problem in the current process
+        nbFallbacks++;
+        res = solver->maxSat();
+        if (res==SolverBackend::True) {
+            cost = solver->getCostAsDouble();
+            unsatExprs = solver->getUnsatExpressions();
+        }
+        return res;
+    }
+    const std::string &msg = buffers[winner];
+    unsigned size;
+    msg.copy((char*) &res, sizeof(res), 0);
+    msg.copy((char*) &cost, sizeof(cost), sizeof(int));
+    msg.copy((char*) &size, sizeof(size), sizeof(int)+sizeof(double));
+    for (unsigned k=0; k<size; k++) {
+        unsigned i;
+        msg.copy((char*) &i, sizeof(i), header+k*sizeof(unsigned));
+        assert(i<softs.size() && "Unknown soft expression!");
+        unsatExprs.push_back(softs[i]);
+    }
+    nbWins[configs[winner]]++;
+    SolverStats::record(true, SolverStats::getTime()-startTime,
+                        solver->getNbHardAsserts(),
+                        solver->getNbSoftAsserts(),
+                        solver->getNbVarDecls(), res);
+    return res;
+}
+
+int PortfolioSolver::check(SolverBackend *solver, std::vector<ExprPtr> &exprs,
+                           std::vector<ExprPtr> &falsified,
+                           std::vector<SolverBackend::AssertionID> &core) {
+    double startTime = SolverStats::getTime();
+    falsified.clear();
+    core.clear();
+    // The buffered output would be duplicated in the worker
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(NULL);
+    int p[2];
+    pid_t pid = -1;
+    if (pipe(p)==0) {
+        pid = fork();
+        if (pid<0) {
+            close(p[0]);
+            close(p[1]);
+        }
+    }
+    if (pid==0) {
+        // Worker
+        close(p[0]);
+        limitMemory();
+        int res = solver->check();
+        std::vector<unsigned> indices;
+        std::vector<SolverBackend::AssertionID> ids;
+        if (res==SolverBackend::True) {
+            for (unsigned i=0; i<exprs.size(); i++) {
+                if (solver->evaluate(exprs[i])==SolverBackend::False) {
+                    indices.push_back(i);
+                }
+            }
+        } else if (res==SolverBackend::False) {
+            ids = solver->getUnsatCore();
+        }
+        // Answer: result, number of falsified expressions, their 
+        // indices, size of the core and its assertions
+        unsigned size = indices.size();
+        unsigned coreSize = ids.size();
+        std::string msg;
+        msg.append((const char*) &res, sizeof(res));
+        msg.append((const char*) &size, sizeof(size));
+        if (size>0) {
+            msg.append((const char*) &indices[0], size*sizeof(unsigned));
+        }
+        msg.append((const char*) &coreSize, sizeof(coreSize));
+        if (coreSize>0) {
+            msg.append((const char*) &ids[0],
+                       coreSize*sizeof(SolverBackend::AssertionID));
+        }
+        writeAll(p[1], msg.data(), msg.size());
+        close(p[1]);
+        _exit(0);
+    }
+    // Wait for the answer
+    std::string msg;
+    bool answered = false;
+    bool outOfTime = false;
+    bool outOfMemory = false;
+    if (pid>0) {
+        close(p[1]);
+        while (!answered) {
+            fd_set rfds;
+            FD_ZERO(&rfds);
+            FD_SET(p[0], &rfds);
+            struct timeval tv;
+            struct timeval *ptv = NULL;
+            if (timeout>0) {
+                double left = startTime+timeout-SolverStats::getTime();
+                if (left<=0) {
+                    outOfTime = true;
+                    break;
+                }
+                tv.tv_sec  = (long) (left/1000);
+                tv.tv_usec = (long) ((left-tv.tv_sec*1000.0)*1000);
+                ptv = &tv;
+            }
+            int nbReady = select(p[0]+1, &rfds, NULL, NULL, ptv);
+            if (nbReady<0 && errno!=EINTR) {
+                break;
+            }
+            if (nbReady<=0) {
+                continue;
+            }
+            char buf[4096];
+            ssize_t n = read(p[0], buf, sizeof(buf));
+            if (n>0) {
+                msg.append(buf, n);
+            } else if (n==0) {
+                answered = true;
+            } else if (errno!=EINTR) {
+                break;
+            }
+        }
+        // A worker that stopped by itself may have been 
+        // killed by the memory limit
+        if (!answered) {
+            kill(pid, SIGKILL);
+        }
+        close(p[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        outOfMemory = answered && WIFSIGNALED(status) 
+                      && WTERMSIG(status)==SIGKILL;
+    }
+    // Decode the answer
+    int res = SolverBackend::Undef;
+    size_t pos = 0;
+    unsigned size = 0, coreSize = 0;
+    bool valid = answered && msg.size()>=sizeof(res)+sizeof(size);
+    if (valid) {
+        msg.copy((char*) &res, sizeof(res), pos);
+        pos += sizeof(res);
+        msg.copy((char*) &size, sizeof(size), pos);
+        pos += sizeof(size);
+        valid = msg.size()>=pos+size*sizeof(unsigned)+sizeof(coreSize);
+    }
+    for (unsigned k=0; valid && k<size; k++) {
+        unsigned i;
+        msg.copy((char*) &i, sizeof(i), pos);
+        pos += sizeof(i);
+        assert(i<exprs.size() && "Unknown expression!");
+        falsified.push_back(exprs[i]);
+    }
+    if (valid) {
+        msg.copy((char*) &coreSize, sizeof(coreSize), pos);
+        pos += sizeof(coreSize);
+        valid = msg.size()==pos+coreSize*sizeof(SolverBackend::AssertionID);
+    }
+    for (unsigned k=0; valid && k<coreSize; k++) {
+        SolverBackend::AssertionID id;
+        msg.copy((char*) &id, sizeof(id), pos);
+        pos += sizeof(id);
+        core.push_back(id);
+    }
+    if (!valid) {
+        falsified.clear();
+        core.clear();
+        if (outOfTime || outOfMemory) {
+            // The budget ran out
+            nbTimeouts++;
+            SolverStats::record(false, SolverStats::getTime()-startTime,
+                                solver->getNbHardAsserts(), 
+                                solver->getNbSoftAsserts(),
+                                solver->getNbVarDecls(), SolverBackend::Undef);
+            return SolverBackend::Undef;
+        }
+        // No answer (the worker could not be launched or crashed),
+        // solve the problem in the current process
+        nbFallbacks++;
+        res = solver->check();
+        if (res==SolverBackend::True) {
+            for (ExprPtr e : exprs) {
+                if (solver->evaluate(e)==SolverBackend::False) {
+                    falsified.push_back(e);
+                }
+            }
+        } else if (res==SolverBackend::False) {
+            core = solver->getUnsatCore();
+        }
+        return res;
+    }
+    SolverStats::record(false, SolverStats::getTime()-startTime,
+                        solver->getNbHardAsserts(),
+                        solver->getNbSoftAsserts(),
+                        solver->getNbVarDecls(), res);
+    return res;
+}
+
+void PortfolioSolver::printStats(std::ostream &out) {
+    out << "Portfolio wins   :";
+    for (unsigned c=0; c<NbConfigs; c++) {
+        out << " " << getConfigName(c) << "=" << nbWins[c];
+    }
+    out << " (fallbacks: " << nbFallbacks;
+    out << ", out of budget: " << nbTimeouts << ")\n";
+}
+
+void PortfolioSolver::resetStats() {
+    nbWins.assign(NbConfigs, 0);
+    nbFallbacks = 0;
+    nbTimeouts = 0;
+}
+
+void PortfolioSolver::saveStats(std::string &buf) {
+    buf.append((const char*) &nbWins[0], NbConfigs*sizeof(unsigned));
+    buf.append((const char*) &nbFallbacks, sizeof(nbFallbacks));
+    buf.append((const char*) &nbTimeouts, sizeof(nbTimeouts));
+}
+
+bool PortfolioSolver::mergeStats(const std::string &buf, size_t &pos) {
+    if (pos+(NbConfigs+2)*sizeof(unsigned)>buf.size()) {
+        return false;
+    }
+    unsigned v;
+    for (unsigned c=0; c<NbConfigs; c++) {
+        buf.copy((char*) &v, sizeof(v), pos);
+        pos += sizeof(v);
+        nbWins[c] += v;
+    }
+    buf.copy((char*) &v, sizeof(v), pos);
+    pos += sizeof(v);
+    nbFallbacks += v;
+    buf.copy((char*) &v, sizeof(v), pos);
+    pos += sizeof(v);
+    nbTimeouts += v;
+    return true;
+}
@@ -0,0 +1,275 @@
+/**
+ * \file PortfolioSolver.h
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#ifndef _PORTFOLIOSOLVER_H
+#define _PORTFOLIOSOLVER_H
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "Expression.h"
+#include "SolverBackend.h"
+#include "SolverStats.h"
+
+/**
+ * \class PortfolioSolver
+ *
+ * \brief A max-sat portfolio that races differently configured 
+ *        solvers and takes the first answer.
+ *
+ * The backends (e.g. Yices 1) are not thread-safe, so each 
+ * configuration runs in a worker process forked from the current
+ * process: the worker inherits a copy of the logical context, 
+ * solves it with its own configuration and sends back the result
+ * and the indices of the falsified soft expressions through a pipe. The first 
+ * worker to answer wins, the other ones are killed.
+ *
+ * The model stays in the worker, only the result, the cost and 
+ * the falsified soft expressions are available in the parent.
+ *
+ * The workers can be given a budget (wall time and memory). When
+ * the budget runs out, the workers are killed and maxSat returns
+ * Undef, the context of the current process being unchanged.
+ * With a single worker, the worker uses the max-sat algorithm of
+ * the solver, so that the portfolio only enforces the budget.
+ * The satisfiability checks (see check) are budgeted the same way.
+ */
+class PortfolioSolver {
+
+public:
+    /**
+     * Configurations of the workers.
+     */
+    enum Config {
+        YICES_MAXSAT, /*!< Built-in max-sat of the backend (NATIVE) */
+        CORE_MAXSAT,  /*!< Core-guided max-sat (Fu-Malik) */
+        NbConfigs
+    };
+
+private:
+    /**
+     * Number of workers (at most NbConfigs).
+     */
+    unsigned nbWorkers;
+    /**
+     * Soft expressions falsified by the last answer.
+     */
+    std::vector<ExprPtr> unsatExprs;
+    /**
+     * Cost of the last answer.
+     */
+    double cost;
+    /**
+     * Number of races won by each configuration.
+     */
+    std::vector<unsigned> nbWins;
+    /**
+     * Number of queries solved in the current process
+     * because no worker answered.
+     */
+    unsigned nbFallbacks;
+    /**
+     * Wall time budget of a query in ms (0 if none).
+     */
+    double timeout;
+    /**
+     * Memory budget of a worker in MB (0 if none).
+     */
+    unsigned memoryLimit;
+    /**
+     * Number of queries stopped because the budget ran out.
+     */
+    unsigned nbTimeouts;
+    /**
+     * True if the soft expressions have non-unit weights.
+     */
+    bool weighted;
+
+public:
+    /**
+     * Default constructor.
+     *
+     * \param n Number of workers (clamped to [1, NbConfigs]).
+     */
+    PortfolioSolver(unsigned n);
+    /**
+     * Destructor.
+     */
+    ~PortfolioSolver() { }
+    
+    /**
+     * \brief Race the workers on the max-sat problem
+     *        in the context of \p solver.
+     *
+     * If no worker answers (e.g. fork failed), the problem is 
+     * solved by \p solver in the current process, unless there 
+     * is a budget.
+     *
+     * \return True, False or Undef (as SolverBackend::maxSat,
+     *         or if the budget ran out).
+     */
+    int maxSat(SolverBackend *solver);
+    
+    /**
+     * \brief Check the satisfiability of the context of \p solver 
+     *        (as SolverBackend::check) in a worker, within the budget.
+     *
+     * If no worker answers (e.g. fork failed), the problem is 
+     * solved by \p solver in the current process, unless there 
+     * is a budget.
+     *
+     * \param solver A solver.
+     * \param exprs Expressions evaluated in the model.
+     * \param falsified Receives the expressions of \p exprs 
+     *        falsified by the model (if True).
+     * \param core Receives the unsat core (if False).
+     * \return True, False or Undef (unknown, or if the
+     *         budget ran out).
+     */
+    int check(SolverBackend *solver, std::vector<ExprPtr> &exprs,
+              std::vector<ExprPtr> &falsified,
+              std::vector<SolverBackend::AssertionID> &core);
+    
+    /**
+     * \brief Set the wall time budget of the next queries 
+     *        in ms (0 for no budget).
+     */
+    void setTimeout(double ms) {
+        timeout = ms;
+    }
+    
+    /**
+     * \brief Set the memory budget of the workers 
+     *        in MB (0 for no budget).
+     */
+    void setMemoryLimit(unsigned mb) {
+        memoryLimit = mb;
+    }
+    
+    /**
+     * \brief Set whether the soft expressions have non-unit weights.
+     *
+     * The core-guided configuration ignores the weights, so it does 
+     * not race on weighted problems (unless it is the only worker).
+     */
+    void setWeighted(bool w) {
+        weighted = w;
+    }
+    
+    /**
+     * \brief Return true if the queries have a budget.
+     */
+    bool hasBudget() {
+        return timeout>0 || memoryLimit>0;
+    }
+    
+    /**
+     * \brief Return the number of queries stopped 
+     *        because the budget ran out.
+     */
+    unsigned getNbTimeouts() {
+        return nbTimeouts;
+    }
+    
+    /**
+     * \brief Return the soft expressions falsified by the last answer.
+     */
+    std::vector<ExprPtr> getUnsatExpressions() {
+        return unsatExprs;
+    }
+    
+    /**
+     * \brief Return the cost of the last answer.
+     */
+    double getCostAsDouble() {
+        return cost;
+    }
+    
+    /**
+     * \brief Return the number of workers.
+     */
+    unsigned getNbWorkers() {
+        return nbWorkers;
+    }
+    
+    /**
+     * \brief Return the number of races won by configuration \p c.
+     */
+    unsigned getNbWins(unsigned c) {
+        assert(c<NbConfigs && "Unknown configuration!");
+        return nbWins[c];
+    }
+    
+    /**
+     * \brief Print the number of races won by each configuration.
+     */
+    void printStats(std::ostream &out);
+    
+    /**
+     * \brief Reset the race counters (wins, fallbacks and timeouts).
+     */
+    void resetStats();
+    
+    /**
+     * \brief Append the race counters to \p buf, e.g. to send them
+     *        from a worker process to its parent (see mergeStats).
+     */
+    void saveStats(std::string &buf);
+    
+    /**
+     * \brief Add the race counters saved at position \p pos of 
+     *        \p buf to the current ones, and move \p pos after them.
+     *
+     * \return false if \p buf is too short.
+     */
+    bool mergeStats(const std::string &buf, size_t &pos);
+    
+    /**
+     * \brief Return the name of configuration \p c.
+     */
+    static std::string getConfigName(unsigned c);
+
+private:
+    /**
+     * \brief Solve the problem with configuration \p c and write
+     *        the answer in \p fd (worker process), within the 
+     *        memory budget.
+     */
+    void runWorker(SolverBackend *solver, unsigned c,
+                   std::vector<ExprPtr> &softs, int fd);
+
+    /**
+     * \brief Apply the memory budget to the current (worker) process.
+     */
+    void limitMemory();
+
+};
+
+#endif // _PORTFOLIOSOLVER_H
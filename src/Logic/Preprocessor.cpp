@@ -0,0 +1,426 @@
+/**
+ * \file Preprocessor.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#include "Preprocessor.h"
+#include "ConeOfInfluence.h"
+
+#include <climits>
+
+bool Preprocessor::getNum(ExprPtr e, long long &v) {
+    if (e->getOpCode()==Expression::SInt32Num) {
+        v = std::static_pointer_cast<SInt32NumExpression>(e)->getValue();
+        return true;
+    }
+    if (e->getOpCode()==Expression::UInt32Num) {
+        v = std::static_pointer_cast<UInt32NumExpression>(e)->getValue();
+        return true;
+    }
+    return false;
+}
+
+std::vector<ExprPtr> Preprocessor::getArgs(ExprPtr e) {
+    std::vector<ExprPtr> args;
+    switch (e->getOpCode()) {
+        case Expression::Not:
+            args.push_back(std::static_pointer_cast<NotExpression>(e)->get());
+            break;
+        case Expression::And:
+        case Expression::Or:
+        case Expression::Xor:
+        case Expression::Sum:
+        case Expression::Sub:
+        case Expression::Mul:
+            args = std::static_pointer_cast<UnaryExpression>(e)->getExprs();
+            break;
+        case Expression::Gt:
+        case Expression::Ge:
+        case Expression::Le:
+        case Expression::Lt:
+        case Expression::Diseq:
+        case Expression::Eq:
+        case Expression::Div:
+        case Expression::Mod:
+        case Expression::App: {
+            BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(e);
+            args.push_back(be->getExpr1());
+            args.push_back(be->getExpr2());
+            break;
+        }
+        case Expression::Ite:
+        case Expression::Update: {
+            TrinaryExprPtr te = std::static_pointer_cast<TrinaryExpression>(e);
+            args.push_back(te->getExpr1());
+            args.push_back(te->getExpr2());
+            args.push_back(te->getExpr3());
+            break;
+        }
+        default:
+            break;
+    }
+    return args;
+}
+
+ExprPtr Preprocessor::copy(ExprPtr e) {
+    switch (e->getOpCode()) {
+        case Expression::True:
+            return Expression::mkTrue();
+        case Expression::False:
+            return Expression::mkFalse();
+        case Expression::UInt32Num:
+            return Expression::mkUInt32Num(
+                std::static_pointer_cast<UInt32NumExpression>(e)->getValue());
+        case Expression::SInt32Num:
+            return Expression::mkSInt32Num(
+                std::static_pointer_cast<SInt32NumExpression>(e)->getValue());
+        case Expression::BoolVar:
+            return Expression::mkBoolVar(
+                std::static_pointer_cast<SingleExpression>(e)->getName());
+        case Expression::IntVar:
+            return Expression::mkIntVar(
+                std::static_pointer_cast<SingleExpression>(e)->getName());
+        case Expression::IntToIntVar:
+            return Expression::mkIntToIntVar(
+                std::static_pointer_cast<SingleExpression>(e)->getName());
+        default: {
+            std::vector<ExprPtr> args = getArgs(e);
+            return fold(e, args);
+        }
+    }
+}
+
+ExprPtr Preprocessor::fold(ExprPtr e, std::vector<ExprPtr> &args) {
+    const unsigned op = e->getOpCode();
+    long long v1, v2;
+    switch (op) {
+        case Expression::Not: {
+            const unsigned op1 = args[0]->getOpCode();
+            if (op1==Expression::True) {
+                return Expression::mkFalse();
+            }
+            if (op1==Expression::False) {
+                return Expression::mkTrue();
+            }
+            if (op1==Expression::Not) {
+                return std::static_pointer_cast<NotExpression>(args[0])->get();
+            }
+            return Expression::mkNot(args[0]);
+        }
+        case Expression::And:
+        case Expression::Or: {
+            // (and ... false ...) = false, (or ... true ...) = true
+            const unsigned absorbing = 
+            (op==Expression::And ? Expression::False : Expression::True);
+            const unsigned neutral = 
+            (op==Expression::And ? Expression::True : Expression::False);
+            std::vector<ExprPtr> es;
+            for (ExprPtr a : args) {
+                if (a->getOpCode()==absorbing) {
+                    return copy(a);
+                }
+                if (a->getOpCode()!=neutral) {
+                    es.push_back(a);
+                }
+            }
+            if (es.empty()) {
+                return (op==Expression::And ? (ExprPtr) Expression::mkTrue()
+                                            : (ExprPtr) Expression::mkFalse());
+            }
+            if (es.size()==1) {
+                return es[0];
+            }
+            if (op==Expression::And) {
+                return Expression::mkAnd(es);
+            }
+            return Expression::mkOr(es);
+        }
+        case Expression::Xor:
+            return Expression::mkXor(args);
+        case Expression::Sum:
+        case Expression::Sub:
+        case Expression::Mul: {
+            // Evaluate if all the arguments are numerals (and 
+            // the result is a signed 32 bit number)
+            long long r = 0;
+            bool isNum = getNum(args[0], r);
+            for (unsigned i=1; isNum && i<args.size(); i++) {
+                isNum = getNum(args[i], v2);
+                if (op==Expression::Sum)      r += v2;
+                else if (op==Expression::Sub) r -= v2;
+                else                          r *= v2;
+                isNum = isNum && r>=INT_MIN && r<=INT_MAX;
+            }
+            if (isNum) {
+                return Expression::mkSInt32Num((int) r);
+            }
+            if (op==Expression::Sum) {
+                return Expression::mkSum(args);
+            }
+            ExprPtr r2 = args[0];
+            for (unsigned i=1; i<args.size(); i++) {
+                if (op==Expression::Sub) r2 = Expression::mkSub(r2, args[i]);
+                else                     r2 = Expression::mkMul(r2, args[i]);
+            }
+            return r2;
+        }
+        case Expression::Gt:
+        case Expression::Ge:
+        case Expression::Le:
+        case Expression::Lt:
+        case Expression::Diseq:
+        case Expression::Eq: {
+            int res = -1;
+            if (getNum(args[0], v1) && getNum(args[1], v2)) {
+                switch (op) {
+                    case Expression::Gt:    res = (v1>v2);  break;
+                    case Expression::Ge:    res = (v1>=v2); break;
+                    case Expression::Le:    res = (v1<=v2); break;
+                    case Expression::Lt:    res = (v1<v2);  break;
+                    case Expression::Diseq: res = (v1!=v2); break;
+                    default:                res = (v1==v2); break;
+                }
+            } else if (op==Expression::Eq || op==Expression::Diseq) {
+                const unsigned op1 = args[0]->getOpCode();
+                const unsigned op2 = args[1]->getOpCode();
+                const bool isBool1 = (op1==Expression::True || op1==Expression::False);
+                const bool isBool2 = (op2==Expression::True || op2==Expression::False);
+                if (isBool1 && isBool2) {
+                    res = ((op1==op2) == (op==Expression::Eq));
+                } else if (isBool1 || isBool2) {
+                    // (= e true) = e, (= e false) = (not e)
+                    ExprPtr other = (isBool1 ? args[1] : args[0]);
+                    bool positive = ((isBool1 ? op1 : op2)==Expression::True);
+                    if (op==Expression::Diseq) {
+                        positive = !positive;
+                    }
+                    if (positive) {
+                        return other;
+                    }
+                    std::vector<ExprPtr> notArgs(1, other);
+                    return fold(Expression::mkNot(other), notArgs);
+                }
+            }
+            if (res>=0) {
+                return (res ? (ExprPtr) Expression::mkTrue() 
+                            : (ExprPtr) Expression::mkFalse());
+            }
+            switch (op) {
+                case Expression::Gt:    return Expression::mkGt(args[0], args[1]);
+                case Expression::Ge:    return Expression::mkGe(args[0], args[1]);
+                case Expression::Le:    return Expression::mkLe(args[0], args[1]);
+                case Expression::Lt:    return Expression::mkLt(args[0], args[1]);
+                case Expression::Diseq: return Expression::mkDiseq(args[0], args[1]);
+                default:                return Expression::mkEq(args[0], args[1]);
+            }
+        }
+        case Expression::Ite: {
+            const unsigned op1 = args[0]->getOpCode();
+            if (op1==Expression::True) {
+                return args[1];
+            }
+            if (op1==Expression::False) {
+                return args[2];
+            }
+            return Expression::mkIte(args[0], args[1], args[2]);
+        }
+        case Expression::Div:
+            return Expression::mkDiv(args[0], args[1]);
+        case Expression::Mod:
+            return Expression::mkMod(args[0], args[1]);
+        case Expression::App:
+            return Expression::mkApp(args[0], args[1]);
+        case Expression::Update:
+            return Expression::mkFunctionUpdate(args[0], args[1], args[2]);
+        default:
+            return e;
+    }
+}
+
+ExprPtr Preprocessor::simplify(ExprPtr e, std::map<unsigned, ExprPtr> &subst) {
+    std::map<unsigned, ExprPtr> cache;
+    return simplify(e, subst, cache);
+}
+
+ExprPtr Preprocessor::simplify(ExprPtr e, std::map<unsigned, ExprPtr> &subst,
+                               std::map<unsigned, ExprPtr> &cache) {
+    std::map<unsigned, ExprPtr>::iterator it = cache.find(e->getID());
+    if (it!=cache.end()) {
+        return it->second;
+    }
+    ExprPtr r = e;
+    switch (e->getOpCode()) {
+        case Expression::True:
+        case Expression::False:
+        case Expression::UInt32Num:
+        case Expression::SInt32Num:
+        case Expression::ToParse:
+            break;
+        case Expression::BoolVar:
+        case Expression::IntVar:
+        case Expression::IntToIntVar: {
+            SingleExprPtr se = std::static_pointer_cast<SingleExpression>(e);
+            std::map<unsigned, ExprPtr>::iterator is = subst.find(se->getNameID());
+            if (is!=subst.end()) {
+                // The substitutions are simplified once
+                r = simplify(is->second, subst, cache);
+                is->second = r;
+            }
+            break;
+        }
+        default: {
+            std::vector<ExprPtr> args = getArgs(e);
+            bool changed = false;
+            for (unsigned i=0; i<args.size(); i++) {
+                ExprPtr a = simplify(args[i], subst, cache);
+                changed = changed || a.get()!=args[i].get();
+                args[i] = a;
+            }
+            ExprPtr f = fold(e, args);
+            // Keep e if nothing was simplified
+            if (changed || f->getOpCode()!=e->getOpCode()) {
+                r = f;
+            }
+            break;
+        }
+    }
+    cache[e->getID()] = r;
+    return r;
+}
+
+void Preprocessor::run(Formula *f, std::set<unsigned> &frozen,
+                       std::map<unsigned, int> &constants,
+                       unsigned &nbHard, unsigned &nbSoft) {
+    nbHard = 0;
+    nbSoft = 0;
+    std::vector<ExprPtr> exprs = f->getExprs();
+    // Number of expressions using each variable, and
+    // number of definitions of each variable
+    std::vector<std::set<unsigned> > exprVars(exprs.size());
+    std::map<unsigned, unsigned> nbUses, nbDefs;
+    for (unsigned i=0; i<exprs.size(); i++) {
+        if (!ConeOfInfluence::getVariables(exprs[i], exprVars[i])) {
+            return;
+        }
+        for (unsigned x : exprVars[i]) {
+            nbUses[x]++;
+        }
+        if (exprs[i]->getOpCode()==Expression::Eq) {
+            BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(exprs[i]);
+            ExprPtr lhs = be->getExpr1();
+            if (lhs->getOpCode()==Expression::BoolVar || 
+                lhs->getOpCode()==Expression::IntVar) {
+                nbDefs[std::static_pointer_cast<SingleExpression>(lhs)->getNameID()]++;
+            }
+        }
+    }
+    // Substitutions: constants and hard definitions
+    std::map<unsigned, ExprPtr> subst;
+    std::map<unsigned, int>::iterator ic;
+    for (ic=constants.begin(); ic!=constants.end(); ++ic) {
+        subst[ic->first] = Expression::mkSInt32Num(ic->second);
+    }
+    std::vector<bool> removed(exprs.size(), false);
+    for (unsigned i=0; i<exprs.size(); i++) {
+        if (exprs[i]->isSoft() || exprs[i]->getOpCode()!=Expression::Eq) {
+            continue;
+        }
+        BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(exprs[i]);
+        ExprPtr lhs = be->getExpr1();
+        ExprPtr rhs = be->getExpr2();
+        if (lhs->getOpCode()!=Expression::BoolVar && 
+            lhs->getOpCode()!=Expression::IntVar) {
+            continue;
+        }
+        unsigned x = std::static_pointer_cast<SingleExpression>(lhs)->getNameID();
+        if (frozen.count(x) || subst.count(x) || nbDefs[x]!=1) {
+            continue;
+        }
+        std::set<unsigned> used;
+        ConeOfInfluence::getVariables(rhs, used);
+        if (used.count(x)) {
+            continue;
+        }
+        // Do not duplicate the expression of x
+        bool isLeaf = getArgs(rhs).empty();
+        if (!isLeaf && nbUses[x]>2) {
+            continue;
+        }
+        // Do not create a cycle of substitutions
+        bool cycle = false;
+        std::vector<unsigned> worklist(used.begin(), used.end());
+        std::set<unsigned> visited;
+        while (!worklist.empty() && !cycle) {
+            unsigned y = worklist.back();
+            worklist.pop_back();
+            if (!visited.insert(y).second) {
+                continue;
+            }
+            std::map<unsigned, ExprPtr>::iterator is = subst.find(y);
+            if (is!=subst.end()) {
+                std::set<unsigned> used2;
+                ConeOfInfluence::getVariables(is->second, used2);
+                cycle = used2.count(x)>0;
+                worklist.insert(worklist.end(), used2.begin(), used2.end());
+            }
+        }
+        if (cycle) {
+            continue;
+        }
+        subst[x] = rhs;
+        removed[i] = true;
+        nbHard++;
+    }
+    // Rewrite the other expressions
+    std::map<unsigned, ExprPtr> cache;
+    std::vector<ExprPtr> kept;
+    for (unsigned i=0; i<exprs.size(); i++) {
+        if (removed[i]) {
+            continue;
+        }
+        ExprPtr e = exprs[i];
+        ExprPtr r = simplify(e, subst, cache);
+        if (r->getOpCode()==Expression::True) {
+            if (e->isSoft()) nbSoft++;
+            else             nbHard++;
+            continue;
+        }
+        if (r.get()!=e.get()) {
+            // New root, with the information of e
+            r = copy(r);
+            r->setInstruction(e->getInstruction());
+            if (e->isSoft()) {
+                r->setSoft();
+                r->setWeight(e->getWeight());
+            } else {
+                r->setHard();
+            }
+            r->setLine(e->getLine());
+        }
+        kept.push_back(r);
+    }
+    *f = Formula(kept);
+}
@@ -0,0 +1,119 @@
+/**
+ * \file Preprocessor.h
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#ifndef _PREPROCESSOR_H
+#define _PREPROCESSOR_H
+
+#include <vector>
+#include <set>
+#include <map>
+
+#include "Expression.h"
+#include "Formula.h"
+
+/**
+ * \class Preprocessor
+ *
+ * \brief Simplification of a trace formula before it is 
+ *        asserted in the solver.
+ *
+ * The preprocessing has three steps:
+ * - the hard definitions (= x e) of the formula are substituted 
+ *   away: x is replaced by e in the other expressions, and the
+ *   definition is removed. Only the definitions that do not 
+ *   duplicate e are substituted (e is a variable or a constant, 
+ *   or x is used by a single expression);
+ * - the given constants are propagated (e.g. the input values);
+ * - the constant sub-expressions are evaluated and the trivially 
+ *   true expressions are removed.
+ *
+ * A rewritten expression keeps the LLVM instruction, line number,
+ * weight and soft/hard property of the original one, so that the 
+ * soft expressions still map back to the source code.
+ */
+class Preprocessor {
+
+public:
+    /**
+     * \brief Preprocess the formula \p f.
+     *
+     * The formula is left unchanged if it contains an 
+     * expression to parse.
+     *
+     * \param f A formula.
+     * \param frozen Name IDs of the variables that must not be
+     *        substituted away (variables of constraints that will be 
+     *        added to the formula later).
+     * \param constants Values of the variables to propagate, 
+     *        indexed by name ID.
+     * \param nbHard Receives the number of hard expressions removed.
+     * \param nbSoft Receives the number of soft expressions removed.
+     */
+    static void run(Formula *f, std::set<unsigned> &frozen,
+                    std::map<unsigned, int> &constants,
+                    unsigned &nbHard, unsigned &nbSoft);
+    
+    /**
+     * \brief Return the simplification of \p e, where the variables
+     *        of \p subst are replaced by their expressions.
+     *
+     * The sub-expressions that are not modified are shared with \p e.
+     *
+     * \param e An expression.
+     * \param subst Expressions of the variables to replace, 
+     *        indexed by name ID.
+     */
+    static ExprPtr simplify(ExprPtr e, std::map<unsigned, ExprPtr> &subst);
+
+private:
+    /**
+     * Simplify \p e with \p cache (indexed by expression ID).
+     */
+    static ExprPtr simplify(ExprPtr e, std::map<unsigned, ExprPtr> &subst,
+                            std::map<unsigned, ExprPtr> &cache);
+    /**
+     * Return an expression with the operator of \p e and the
+     * arguments \p args, after constant folding.
+     */
+    static ExprPtr fold(ExprPtr e, std::vector<ExprPtr> &args);
+    /**
+     * Return the arguments of \p e.
+     */
+    static std::vector<ExprPtr> getArgs(ExprPtr e);
+    /**
+     * Return a new instance of the root of \p e.
+     */
+    static ExprPtr copy(ExprPtr e);
+    /**
+     * Return \a true and set \p v if \p e is a numeral.
+     */
+    static bool getNum(ExprPtr e, long long &v);
+
+};
+
+#endif // _PREPROCESSOR_H
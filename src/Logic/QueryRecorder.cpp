@@ -0,0 +1,512 @@
+/**
+ * \file QueryRecorder.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#include "QueryRecorder.h"
+#include "SolverStats.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <iomanip>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+std::string QueryRecorder::directory;
+int QueryRecorder::traceID = -1;
+static unsigned localNbQueries = 0;
+unsigned *QueryRecorder::nbQueries = &localNbQueries;
+
+bool QueryRecorder::setDirectory(std::string dir) {
+    directory = dir;
+    if (dir.empty()) {
+        return true;
+    }
+    if (mkdir(dir.c_str(), 0755)!=0 && errno!=EEXIST) {
+        directory.clear();
+        return false;
+    }
+    if (nbQueries==&localNbQueries) {
+        void *m = mmap(NULL, sizeof(unsigned), PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (m!=MAP_FAILED) {
+            *(unsigned*) m = localNbQueries;
+            nbQueries = (unsigned*) m;
+        }
+    }
+    return true;
+}
+
+std::string QueryRecorder::record(bool isMaxSat, std::vector<ExprPtr> &hard,
+                                  std::vector<ExprPtr> &soft) {
+    assert(isEnabled() && "Recording is disabled!");
+    std::string phase = SolverStats::getPhaseName(SolverStats::getPhase());
+    // Atomic: the counter may be shared with other processes
+    const unsigned n = __sync_fetch_and_add(nbQueries, 1);
+    std::ostringstream oss;
+    oss << directory << "/q" << std::setw(6) << std::setfill('0');
+    oss << n << "_" << phase;
+    if (traceID>=0) {
+        oss << "_t" << traceID;
+    }
+    oss << (isMaxSat ? "_maxsat" : "_check") << ".smt2";
+    std::ofstream out(oss.str().c_str());
+    if (!out.is_open()) {
+        return "";
+    }
+    write(out, isMaxSat, hard, soft, phase, traceID);
+    return oss.str();
+}
+
+void QueryRecorder::write(std::ostream &out, bool isMaxSat,
+                          std::vector<ExprPtr> &hard, std::vector<ExprPtr> &soft,
+                          std::string phase, int trace) {
+    out << "; query: " << (isMaxSat ? "maxsat" : "check") << "\n";
+    out << "; phase: " << phase << "\n";
+    out << "; trace: " << trace << "\n";
+    out << "(set-logic QF_AUFNIA)\n";
+    // Declarations
+    std::set<unsigned> visited;
+    std::map<unsigned, ExprPtr> vars;
+    for (ExprPtr e : hard) {
+        collectVars(e, visited, vars);
+    }
+    for (ExprPtr e : soft) {
+        collectVars(e, visited, vars);
+    }
+    std::map<unsigned, ExprPtr>::iterator it;
+    for (it = vars.begin(); it != vars.end(); ++it) {
+        SingleExprPtr v = std::static_pointer_cast<SingleExpression>(it->second);
+        out << "(declare-fun " << quote(v->getName()) << " () ";
+        switch (v->getOpCode()) {
+            case Expression::BoolVar:
+                out << "Bool";
+                break;
+            case Expression::IntVar:
+                out << "Int";
+                break;
+            default:
+                out << "(Array Int Int)";
+                break;
+        }
+        out << ")\n";
+    }
+    // 32-bit integers
+    for (it = vars.begin(); it != vars.end(); ++it) {
+        if (it->second->getOpCode()==Expression::IntVar) {
+            SingleExprPtr v = std::static_pointer_cast<SingleExpression>(it->second);
+            std::string name = quote(v->getName());
+            out << "(assert (and (<= (- 2147483648) " << name << ") ";
+            out << "(<= " << name << " 2147483647)))\n";
+        }
+    }
+    // Assertions (the soft/hard property is ignored by check)
+    for (ExprPtr e : hard) {
+        out << "(assert ";
+        writeTerm(out, e);
+        out << ")\n";
+    }
+    for (ExprPtr e : soft) {
+        out << (isMaxSat ? "(assert-soft " : "(assert ");
+        writeTerm(out, e);
+        out << (isMaxSat ? " :weight " : ") ; soft :weight ") << e->getWeight();
+        out << (isMaxSat ? ")\n" : "\n");
+    }
+    out << "(check-sat)\n";
+}
+
+std::string QueryRecorder::toSMTLIB2(ExprPtr e) {
+    std::ostringstream oss;
+    writeTerm(oss, e);
+    return oss.str();
+}
+
+std::string QueryRecorder::quote(std::string name) {
+    if (name.empty() || isdigit(name[0])) {
+        return "|"+name+"|";
+    }
+    for (char c : name) {
+        if (!isalnum(c) && std::string("~!@$%^&*_-+=<>.?/").find(c)==std::string::npos) {
+            return "|"+name+"|";
+        }
+    }
+    return name;
+}
+
+void QueryRecorder::collectVars(ExprPtr e, std::set<unsigned> &visited,
+                                std::map<unsigned, ExprPtr> &vars) {
+    if (!visited.insert(e->getID()).second) {
+        return;
+    }
+    switch (e->getOpCode()) {
+        case Expression::BoolVar:
+        case Expression::IntVar:
+        case Expression::IntToIntVar: {
+            SingleExprPtr v = std::static_pointer_cast<SingleExpression>(e);
+            vars[v->getNameID()] = e;
+        } break;
+        case Expression::Not: {
+            NotExprPtr ne = std::static_pointer_cast<NotExpression>(e);
+            collectVars(ne->get(), visited, vars);
+        } break;
+        case Expression::Gt:
+        case Expression::Ge:
+        case Expression::Le:
+        case Expression::Lt:
+        case Expression::Diseq:
+        case Expression::Eq:
+        case Expression::Div:
+        case Expression::Mod:
+        case Expression::App: {
+            BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(e);
+            collectVars(be->getExpr1(), visited, vars);
+            collectVars(be->getExpr2(), visited, vars);
+        } break;
+        case Expression::And:
+        case Expression::Or:
+        case Expression::Xor:
+        case Expression::Sum:
+        case Expression::Sub:
+        case Expression::Mul: {
+            UnaryExprPtr ue = std::static_pointer_cast<UnaryExpression>(e);
+            for (ExprPtr a : ue->getExprs()) {
+                collectVars(a, visited, vars);
+            }
+        } break;
+        case Expression::Ite:
+        case Expression::Update: {
+            TrinaryExprPtr te = std::static_pointer_cast<TrinaryExpression>(e);
+            collectVars(te->getExpr1(), visited, vars);
+            collectVars(te->getExpr2(), visited, vars);
+            collectVars(te->getExpr3(), visited, vars);
+        } break;
+        default:
+            break;
+    }
+}
+
+void QueryRecorder::writeArgs(std::ostream &out, std::string op,
+                              std::vector<ExprPtr> es) {
+    out << "(" << op;
+    for (ExprPtr a : es) {
+        out << " ";
+        writeTerm(out, a);
+    }
+    out << ")";
+}
+
+void QueryRecorder::writeTerm(std::ostream &out, ExprPtr e) {
+    switch (e->getOpCode()) {
+        case Expression::True:
+            out << "true";
+            break;
+        case Expression::False:
+            out << "false";
+            break;
+        case Expression::UInt32Num: {
+            UInt32NumExprPtr ne = std::static_pointer_cast<UInt32NumExpression>(e);
+            out << ne->getValue();
+        } break;
+        case Expression::SInt32Num: {
+            SInt32NumExprPtr ne = std::static_pointer_cast<SInt32NumExpression>(e);
+            long v = ne->getValue();
+            if (v<0) {
+                out << "(- " << -v << ")";
+            } else {
+                out << v;
+            }
+        } break;
+        case Expression::BoolVar:
+        case Expression::IntVar:
+        case Expression::IntToIntVar: {
+            SingleExprPtr v = std::static_pointer_cast<SingleExpression>(e);
+            out << quote(v->getName());
+        } break;
+        case Expression::ToParse: {
+            // Yices syntax, most expressions are valid SMT-LIB2 terms
+            ToParseExprPtr te = std::static_pointer_cast<ToParseExpression>(e);
+            out << te->getString();
+        } break;
+        case Expression::Not: {
+            NotExprPtr ne = std::static_pointer_cast<NotExpression>(e);
+            out << "(not ";
+            writeTerm(out, ne->get());
+            out << ")";
+        } break;
+        case Expression::Gt:
+        case Expression::Ge:
+        case Expression::Le:
+        case Expression::Lt:
+        case Expression::Diseq:
+        case Expression::Eq:
+        case Expression::Div:
+        case Expression::Mod:
+        case Expression::App: {
+            const char *ops[] = { ">", ">=", "<=", "<", "distinct", "=" };
+            std::string op;
+            switch (e->getOpCode()) {
+                case Expression::Div: op = "div";    break;
+                case Expression::Mod: op = "mod";    break;
+                case Expression::App: op = "select"; break;
+                default: op = ops[e->getOpCode()-Expression::Gt]; break;
+            }
+            BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(e);
+            std::vector<ExprPtr> es;
+            es.push_back(be->getExpr1());
+            es.push_back(be->getExpr2());
+            writeArgs(out, op, es);
+        } break;
+        case Expression::And:
+        case Expression::Or:
+        case Expression::Xor:
+        case Expression::Sum:
+        case Expression::Sub:
+        case Expression::Mul: {
+            UnaryExprPtr ue = std::static_pointer_cast<UnaryExpression>(e);
+            std::vector<ExprPtr> es = ue->getExprs();
+            if (es.empty()) {
+                out << (e->getOpCode()==Expression::And ? "true" : "false");
+            } else if (es.size()==1) {
+                writeTerm(out, es.back());
+            } else {
+                std::string op;
+                switch (e->getOpCode()) {
+                    case Expression::And: op = "and"; break;
+                    case Expression::Or:  op = "or";  break;
+                    case Expression::Xor: op = "xor"; break;
+                    case Expression::Sum: op = "+";   break;
+                    case Expression::Sub: op = "-";   break;
+                    default:              op = "*";   break;
+                }
+                writeArgs(out, op, es);
+            }
+        } break;
+        case Expression::Ite:
+        case Expression::Update: {
+            TrinaryExprPtr te = std::static_pointer_cast<TrinaryExpression>(e);
+            std::vector<ExprPtr> es;
+            es.push_back(te->getExpr1());
+            es.push_back(te->getExpr2());
+            es.push_back(te->getExpr3());
+            writeArgs(out, e->getOpCode()==Expression::Ite ? "ite" : "store", es);
+        } break;
+        default:
+            llvm_unreachable("Illegal expression opcode!");
+            break;
+    }
+}
+
+// =============================================================================
+// Loading
+// =============================================================================
+
+/**
+ * S-expression of a recorded query.
+ */
+struct SExpr {
+    std::string atom;
+    std::vector<SExpr> args;
+    bool isList;
+    SExpr() : isList(false) { }
+};
+
+// Read the next s-expression from the stream
+static bool readSExpr(std::istream &in, SExpr &s) {
+    char c;
+    // Skip blanks and comments
+    for (;;) {
+        if (!in.get(c)) {
+            return false;
+        }
+        if (c==';') {
+            std::string line;
+            std::getline(in, line);
+        } else if (!isspace(c)) {
+            break;
+        }
+    }
+    if (c=='(') {
+        s.isList = true;
+        for (;;) {
+            while (in.peek()!=EOF && isspace(in.peek())) {
+                in.get();
+            }
+            if (in.peek()==';') {
+                std::string line;
+                std::getline(in, line);
+                continue;
+            }
+            if (in.peek()==')') {
+                in.get();
+                return true;
+            }
+            SExpr a;
+            if (!readSExpr(in, a)) {
+                return false;
+            }
+            s.args.push_back(a);
+        }
+    }
+    if (c==')') {
+        return false;
+    }
+    if (c=='|') {
+        while (in.get(c) && c!='|') {
+            s.atom += c;
+        }
+        return c=='|';
+    }
+    s.atom += c;
+    while (in.peek()!=EOF && !isspace(in.peek())
+           && in.peek()!='(' && in.peek()!=')') {
+        s.atom += (char) in.get();
+    }
+    return true;
+}
+
+// Fold a n-ary operator into binary expressions
+template<class F>
+static ExprPtr foldArgs(std::vector<ExprPtr> &es, F mk) {
+    ExprPtr r = es[0];
+    for (unsigned i=1; i<es.size(); i++) {
+        r = mk(r, es[i]);
+    }
+    return r;
+}
+
+static ExprPtr toExpr(const SExpr &s, std::map<std::string, ExprPtr> &vars) {
+    if (!s.isList) {
+        if (s.atom=="true")  return Expression::mkTrue();
+        if (s.atom=="false") return Expression::mkFalse();
+        if (isdigit(s.atom[0])) {
+            return Expression::mkSInt32Num((int) strtol(s.atom.c_str(), NULL, 10));
+        }
+        std::map<std::string, ExprPtr>::iterator it = vars.find(s.atom);
+        return it!=vars.end() ? it->second : NULL;
+    }
+    if (s.args.empty() || s.args[0].isList) {
+        return NULL;
+    }
+    const std::string &op = s.args[0].atom;
+    if (op=="-" && s.args.size()==2 && !s.args[1].isList
+        && isdigit(s.args[1].atom[0])) {
+        // Negative number
+        long v = strtol(s.args[1].atom.c_str(), NULL, 10);
+        return Expression::mkSInt32Num((int) -v);
+    }
+    std::vector<ExprPtr> es;
+    for (unsigned i=1; i<s.args.size(); i++) {
+        ExprPtr a = toExpr(s.args[i], vars);
+        if (!a) {
+            return NULL;
+        }
+        es.push_back(a);
+    }
+    const unsigned n = es.size();
+    if (n==0) return NULL;
+    if (op=="not" && n==1) return Expression::mkNot(es[0]);
+    if (op=="and") return Expression::mkAnd(es);
+    if (op=="or")  return Expression::mkOr(es);
+    if (op=="xor") return Expression::mkXor(es);
+    if (op=="-" && n==1) {
+        return Expression::mkSub(Expression::mkSInt32Num(0), es[0]);
+    }
+    if (op=="+") return Expression::mkSum(es);
+    if (op=="-") return foldArgs(es, Expression::mkSub);
+    if (op=="*") return foldArgs(es, Expression::mkMul);
+    if (n==2) {
+        if (op==">")        return Expression::mkGt(es[0], es[1]);
+        if (op==">=")       return Expression::mkGe(es[0], es[1]);
+        if (op=="<=")       return Expression::mkLe(es[0], es[1]);
+        if (op=="<")        return Expression::mkLt(es[0], es[1]);
+        if (op=="=")        return Expression::mkEq(es[0], es[1]);
+        if (op=="distinct") return Expression::mkDiseq(es[0], es[1]);
+        if (op=="div")      return Expression::mkDiv(es[0], es[1]);
+        if (op=="mod")      return Expression::mkMod(es[0], es[1]);
+        if (op=="select")   return Expression::mkApp(es[0], es[1]);
+    }
+    if (n==3) {
+        if (op=="ite")   return Expression::mkIte(es[0], es[1], es[2]);
+        if (op=="store") return Expression::mkFunctionUpdate(es[0], es[1], es[2]);
+    }
+    return NULL;
+}
+
+bool QueryRecorder::load(std::string filename, std::vector<ExprPtr> &hard,
+                         std::vector<ExprPtr> &soft, bool &isMaxSat) {
+    std::ifstream in(filename.c_str());
+    if (!in.is_open()) {
+        return false;
+    }
+    // The kind of query is given by the header
+    std::string line;
+    std::getline(in, line);
+    if (line.find("; query: ")!=0) {
+        return false;
+    }
+    isMaxSat = line.find("maxsat")!=std::string::npos;
+    std::map<std::string, ExprPtr> vars;
+    SExpr s;
+    while (readSExpr(in, s)) {
+        if (!s.isList || s.args.empty()) {
+            return false;
+        }
+        const std::string &cmd = s.args[0].atom;
+        if (cmd=="declare-fun" && s.args.size()==4) {
+            const std::string &name = s.args[1].atom;
+            const SExpr &ty = s.args[3];
+            if (ty.isList) {
+                vars[name] = Expression::mkIntToIntVar(name);
+            } else if (ty.atom=="Bool") {
+                vars[name] = Expression::mkBoolVar(name);
+            } else {
+                vars[name] = Expression::mkIntVar(name);
+            }
+        } else if ((cmd=="assert" || cmd=="assert-soft") && s.args.size()>=2) {
+            ExprPtr e = toExpr(s.args[1], vars);
+            if (!e) {
+                return false;
+            }
+            if (cmd=="assert-soft") {
+                e->setSoft();
+                if (s.args.size()>=4 && s.args[2].atom==":weight") {
+                    unsigned w = strtoul(s.args[3].atom.c_str(), NULL, 10);
+                    e->setWeight(w>0 ? w : 1);
+                }
+                soft.push_back(e);
+            } else {
+                e->setHard();
+                hard.push_back(e);
+            }
+        } else if (cmd!="set-logic" && cmd!="check-sat") {
+            return false;
+        }
+        s = SExpr();
+    }
+    return true;
+}
@@ -0,0 +1,158 @@
+/**
+ * \file QueryRecorder.h
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#ifndef _QUERYRECORDER_H
+#define _QUERYRECORDER_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "Expression.h"
+
+/**
+ * \class QueryRecorder
+ *
+ * \brief Record the solver queries as SMT-LIB2 files.
+ *
+ * When a record directory is set, each check and maxSat query 
+ * of YicesSolver is written in this directory as a self-contained
+ * SMT-LIB2 file: declarations, 32-bit ranges of the integer 
+ * variables, hard assertions (assert), soft assertions with 
+ * their weight (assert-soft ... :weight w) and check-sat. 
+ * The header of each file gives the kind of query (check or 
+ * maxsat), the phase (see SolverStats) and the trace ID.
+ *
+ * Function variables (int->int) are encoded as arrays, and the
+ * integer division and modulo as div and mod (SMT-LIB semantics
+ * differ from Yices for negative operands).
+ *
+ * The recorded files can be loaded back (see load) and replayed 
+ * against any solver backend with the sniper-replay tool.
+ */
+class QueryRecorder {
+
+private:
+    /**
+     * Record directory (recording is disabled if empty).
+     */
+    static std::string directory;
+    /**
+     * ID of the trace being diagnosed (-1 if none).
+     */
+    static int traceID;
+    /**
+     * Number of recorded queries. Once the recording is enabled,
+     * the counter is in shared memory, so that the worker processes
+     * forked afterwards (see PortfolioSolver and FaultLocalization) 
+     * share the numbering of the queries.
+     */
+    static unsigned *nbQueries;
+
+public:
+    /**
+     * \brief Enable the recording in the directory \p dir
+     *        (created if needed), or disable it if \p dir is empty.
+     *
+     * \return false if the directory can not be created.
+     */
+    static bool setDirectory(std::string dir);
+    
+    /**
+     * \brief Return \a true if the queries are recorded.
+     */
+    static bool isEnabled() {
+        return !directory.empty();
+    }
+    
+    /**
+     * \brief Set the ID of the trace being diagnosed (-1 if none).
+     */
+    static void setTraceID(int id) {
+        traceID = id;
+    }
+    
+    /**
+     * \brief Return the number of recorded queries.
+     */
+    static unsigned getNbQueries() {
+        return *nbQueries;
+    }
+    
+    /**
+     * \brief Record a query in a new file of the record directory.
+     *
+     * \param isMaxSat True for a maxSat query, false for a check.
+     * \param hard The hard expressions of the logical context.
+     * \param soft The soft expressions of the logical context.
+     * \return the name of the file, or an empty string on error.
+     */
+    static std::string record(bool isMaxSat, std::vector<ExprPtr> &hard,
+                              std::vector<ExprPtr> &soft);
+    
+    /**
+     * \brief Write a query in SMT-LIB2 format.
+     */
+    static void write(std::ostream &out, bool isMaxSat,
+                      std::vector<ExprPtr> &hard, std::vector<ExprPtr> &soft,
+                      std::string phase, int trace);
+    
+    /**
+     * \brief Load a recorded query.
+     *
+     * The loaded expressions are tagged as hard or soft.
+     *
+     * \param filename An SMT-LIB2 file written by record.
+     * \param hard Receives the hard expressions of the query.
+     * \param soft Receives the soft expressions of the query.
+     * \param isMaxSat Receives true for a maxSat query.
+     * \return false if the file can not be read or parsed.
+     */
+    static bool load(std::string filename, std::vector<ExprPtr> &hard,
+                     std::vector<ExprPtr> &soft, bool &isMaxSat);
+    
+    /**
+     * \brief Return \p e as an SMT-LIB2 term.
+     */
+    static std::string toSMTLIB2(ExprPtr e);
+
+private:
+    static void writeTerm(std::ostream &out, ExprPtr e);
+    static void writeArgs(std::ostream &out, std::string op,
+                          std::vector<ExprPtr> es);
+    static void collectVars(ExprPtr e, std::set<unsigned> &visited,
+                            std::map<unsigned, ExprPtr> &vars);
+    static std::string quote(std::string name);
+
+};
+
+#endif // _QUERYRECORDER_H
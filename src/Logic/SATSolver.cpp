@@ -0,0 +1,1134 @@
+/**
+ * \file SATSolver.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+#include "SATSolver.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_set>
+
+const unsigned SATSolver::NoReason;
+
+// Luby sequence (1 1 2 1 1 2 4 1 1 2 ...)
+static double luby(double y, int x) {
+    int size, seq;
+    for (size=1, seq=0; size<x+1; seq++, size=2*size+1);
+    while (size-1!=x) {
+        size = (size-1)>>1;
+        seq--;
+        x = x % size;
+    }
+    double r = 1;
+    for (int i=0; i<seq; i++) {
+        r *= y;
+    }
+    return r;
+}
+
+void SATSolver::init() {
+    clean();
+    // Constant true literal
+    trueLit = mkLit(newVar(), false);
+    addClause(std::vector<Lit>(1, trueLit));
+}
+
+void SATSolver::clean() {
+    arena.clear();
+    clauses.clear();
+    learnts.clear();
+    watches.clear();
+    assigns.clear();
+    levels.clear();
+    reasons.clear();
+    polarity.clear();
+    activity.clear();
+    heap.clear();
+    heapIndex.clear();
+    seen.clear();
+    trail.clear();
+    trailLim.clear();
+    conflictCore.clear();
+    modelValues.clear();
+    exprLits.clear();
+    nameVars.clear();
+    softs.clear();
+    softLits.clear();
+    softAssumpLits.clear();
+    scopeSels.clear();
+    softMarks.clear();
+    retractSels.clear();
+    retractMarks.clear();
+    varInc = 1.0;
+    qhead = 0;
+    ok = true;
+    maxLearnts = 0;
+    nbConflicts = 0;
+    nbDecisions = 0;
+    nbPropagations = 0;
+    nbCacheHits = 0;
+    nbCacheMisses = 0;
+}
+
+void SATSolver::addToContext(ExprPtr e) {
+    Lit p = makeLiteral(e);
+    if (e->isHard()) {
+        std::vector<Lit> c;
+        c.push_back(p);
+        if (!scopeSels.empty()) {
+            c.push_back(scopeSels.back() ^ 1);
+        }
+        addClause(c);
+    } else {
+        softs.push_back(e);
+        softLits.push_back(p);
+    }
+}
+
+void SATSolver::addToContext(Formula *f) {
+    assert(f && "Expecting a valid formula!");
+    std::vector<ExprPtr> E = f->getExprs();
+    for(ExprPtr e : E) {
+        addToContext(e);
+    }
+}
+
+SolverBackend::AssertionID SATSolver::addRetractable(ExprPtr e) {
+    const Lit sel = mkLit(newVar(), false);
+    std::vector<Lit> c;
+    c.push_back(sel ^ 1);
+    c.push_back(makeLiteral(e));
+    addClause(c);
+    retractSels.push_back(sel);
+    return retractSels.size()-1;
+}
+
+void SATSolver::retract(AssertionID i) {
+    assert(i>=0 && i<(int)retractSels.size() && "Unknown assertion!");
+    if (retractSels[i]>=0) {
+        // The guarded clause is now satisfied
+        addClause(std::vector<Lit>(1, retractSels[i] ^ 1));
+        retractSels[i] = -1;
+    }
+}
+
+std::vector<SolverBackend::AssertionID> SATSolver::getUnsatCore() {
+    std::unordered_map<int, AssertionID> var2id;
+    for (unsigned i=0; i<retractSels.size(); i++) {
+        if (retractSels[i]>=0) {
+            var2id[var(retractSels[i])] = i;
+        }
+    }
+    std::vector<AssertionID> core;
+    for (Lit p : conflictCore) {
+        std::unordered_map<int, AssertionID>::iterator it = var2id.find(var(p));
+        if (it!=var2id.end()) {
+            core.push_back(it->second);
+        }
+    }
+    return core;
+}
+
+std::vector<SATSolver::Lit> SATSolver::getScopeAssumptions() {
+    std::vector<Lit> assumps(scopeSels);
+    for (Lit sel : retractSels) {
+        if (sel>=0) {
+            assumps.push_back(sel);
+        }
+    }
+    return assumps;
+}
+
+int SATSolver::check() {
+    std::vector<Lit> assumps = getScopeAssumptions();
+    assumps.insert(assumps.end(), softLits.begin(), softLits.end());
+    double startTime = SolverStats::getTime();
+    int res = solve(assumps);
+    SolverStats::record(false, SolverStats::getTime()-startTime,
+                        clauses.size(), softs.size(), assigns.size(), res);
+    return res;
+}
+
+int SATSolver::maxSat() {
+    double startTime = SolverStats::getTime();
+    // Selector of this call: all the clauses added by the
+    // relaxation are guarded by it, and disabled at the end
+    const int firstVar = assigns.size();
+    const Lit callSel = mkLit(newVar(), false);
+    const unsigned n = softLits.size();
+    std::vector<Lit> softAssumps(n);
+    std::vector<std::vector<Lit> > relaxs(n);
+    std::vector<int> softOfVar;
+    std::vector<int> keptVars;
+    std::unordered_set<Lit> seenSoftLits;
+    for (unsigned i=0; i<n; i++) {
+        // The assumption (a -> soft) is reused by the next calls
+        std::unordered_map<Lit, Lit>::iterator it =
+            softAssumpLits.find(softLits[i]);
+        if (it==softAssumpLits.end() || value(it->second)==0) {
+            const Lit a = mkLit(newVar(), false);
+            std::vector<Lit> c;
+            c.push_back(a ^ 1);
+            c.push_back(softLits[i]);
+            addClause(c);
+            softAssumpLits[softLits[i]] = a;
+            keptVars.push_back(var(a));
+        }
+        softAssumps[i] = softAssumpLits[softLits[i]];
+        if (!seenSoftLits.insert(softLits[i]).second) {
+            // Duplicated soft literal: distinct assumption
+            softAssumps[i] = mkLit(newVar(), false);
+            std::vector<Lit> c;
+            c.push_back(callSel ^ 1);
+            c.push_back(softAssumps[i] ^ 1);
+            c.push_back(softLits[i]);
+            addClause(c);
+        }
+    }
+    int res = SolverBackend::Undef;
+    for (;;) {
+        std::vector<Lit> assumps = getScopeAssumptions();
+        assumps.push_back(callSel);
+        assumps.insert(assumps.end(), softAssumps.begin(), softAssumps.end());
+        res = solve(assumps);
+        if (res!=SolverBackend::False) {
+            break;
+        }
+        // Soft expressions in the core
+        softOfVar.assign(assigns.size(), -1);
+        for (unsigned i=0; i<n; i++) {
+            softOfVar[var(softAssumps[i])] = i;
+        }
+        std::vector<unsigned> K;
+        for (Lit p : conflictCore) {
+            if (softOfVar[var(p)]>=0) {
+                K.push_back(softOfVar[var(p)]);
+            }
+        }
+        if (K.empty()) {
+            break; // The hard part is unsatisfiable
+        }
+        // Relax the soft expressions of the core:
+        // exactly one of them can be falsified
+        std::vector<Lit> R;
+        for (unsigned i : K) {
+            Lit r = mkLit(newVar(), false);
+            R.push_back(r);
+            relaxs[i].push_back(r);
+            addClause(std::vector<Lit>(1, softAssumps[i] ^ 1));
+            softAssumps[i] = mkLit(newVar(), false);
+            std::vector<Lit> c;
+            c.push_back(callSel ^ 1);
+            c.push_back(softAssumps[i] ^ 1);
+            c.push_back(softLits[i]);
+            c.insert(c.end(), relaxs[i].begin(), relaxs[i].end());
+            addClause(c);
+        }
+        std::vector<Lit> atLeastOne(R);
+        atLeastOne.push_back(callSel ^ 1);
+        addClause(atLeastOne);
+        addAtMostOne(R);
+    }
+    addClause(std::vector<Lit>(1, callSel ^ 1));
+    // The other variables of this call only appear in satisfied
+    // clauses or in the at-most-one constraints, which hold when
+    // they are false: fix them and remove the satisfied clauses
+    std::vector<char> kept(assigns.size()-firstVar, 0);
+    for (int v : keptVars) {
+        kept[v-firstVar] = 1;
+    }
+    for (int v=firstVar; v<(int)assigns.size(); v++) {
+        if (!kept[v-firstVar] && assigns[v]<0) {
+            addClause(std::vector<Lit>(1, mkLit(v, true)));
+        }
+    }
+    if (ok) {
+        removeSatisfied();
+    }
+    SolverStats::record(true, SolverStats::getTime()-startTime,
+                        clauses.size(), softs.size(), assigns.size(), res);
+    return res;
+}
+
+std::string SATSolver::getModel() {
+    std::ostringstream oss;
+    if (modelValues.empty()) {
+        return "";
+    }
+    for (unsigned id=0; id<nameVars.size(); id++) {
+        if (nameVars[id]>=0) {
+            oss << "(= " << Expression::getInternedName(id) << " ";
+            oss << (modelValues[nameVars[id]]==1 ? "true" : "false");
+            oss << ")\n";
+        }
+    }
+    return oss.str();
+}
+
+double SATSolver::getCostAsDouble() {
+    double cost = 0;
+    if (modelValues.empty()) {
+        return cost;
+    }
+    for (Lit p : softLits) {
+        if (!modelValue(p)) {
+            cost++;
+        }
+    }
+    return cost;
+}
+
+int SATSolver::evaluate(ExprPtr e) {
+    assert(!modelValues.empty() && "Model is empty!");
+    std::unordered_map<unsigned, Lit>::iterator it = exprLits.find(e->getID());
+    if (it!=exprLits.end() && var(it->second)<(int)modelValues.size()) {
+        return modelValue(it->second) 
+            ? SolverBackend::True : SolverBackend::False;
+    }
+    switch (e->getOpCode()) {
+        case Expression::True:
+            return SolverBackend::True;
+        case Expression::False:
+            return SolverBackend::False;
+        case Expression::BoolVar: {
+            BoolVarExprPtr be = std::static_pointer_cast<BoolVarExpression>(e);
+            const unsigned id = be->getNameID();
+            if (id>=nameVars.size() || nameVars[id]<0
+                || nameVars[id]>=(int)modelValues.size()) {
+                return SolverBackend::Undef;
+            }
+            return modelValues[nameVars[id]]==1 
+                ? SolverBackend::True : SolverBackend::False;
+        }
+        case Expression::Not: {
+            NotExprPtr ne = std::static_pointer_cast<NotExpression>(e);
+            return -evaluate(ne->get());
+        }
+        case Expression::And:
+        case Expression::Or: {
+            // An OR is a negated AND of negated values
+            const int sign = (e->getOpCode()==Expression::Or) ? -1 : 1;
+            UnaryExprPtr ue = std::static_pointer_cast<UnaryExpression>(e);
+            std::vector<ExprPtr> es = ue->getExprs();
+            int val = SolverBackend::True;
+            for (ExprPtr e2 : es) {
+                const int v = sign*evaluate(e2);
+                if (v==SolverBackend::False) {
+                    return sign*v;
+                }
+                if (v==SolverBackend::Undef) {
+                    val = SolverBackend::Undef;
+                }
+            }
+            return sign*val;
+        }
+        case Expression::Xor: {
+            XorExprPtr xe = std::static_pointer_cast<XorExpression>(e);
+            std::vector<ExprPtr> es = xe->getExprs();
+            int val = SolverBackend::False;
+            for (ExprPtr e2 : es) {
+                // -1 * -1 = 1: (false xor false) = false
+                val = -(val*evaluate(e2));
+            }
+            return val;
+        }
+        case Expression::Eq:
+        case Expression::Diseq: {
+            if (!isPropositional(e)) {
+                return SolverBackend::Undef;
+            }
+            BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(e);
+            const int val = evaluate(be->getExpr1())*evaluate(be->getExpr2());
+            return (e->getOpCode()==Expression::Eq) ? val : -val;
+        }
+        case Expression::Ite: {
+            if (!isPropositional(e)) {
+                return SolverBackend::Undef;
+            }
+            TrinaryExprPtr te = std::static_pointer_cast<TrinaryExpression>(e);
+            const int c = evaluate(te->getExpr1());
+            const int t = evaluate(te->getExpr2());
+            const int f = evaluate(te->getExpr3());
+            if (c==SolverBackend::Undef) {
+                return (t==f) ? t : SolverBackend::Undef;
+            }
+            return (c==SolverBackend::True) ? t : f;
+        }
+        default:
+            return SolverBackend::Undef;
+    }
+}
+
+int SATSolver::getBoolValue(std::string name) {
+    unsigned id = 0;
+    if (!Expression::lookupName(name, id)) {
+        std::cout << ">> " << name << std::endl;
+        std::cerr << "error: unknown variable name\n";
+        return -3;
+    }
+    return getBoolValue(id);
+}
+
+int SATSolver::getBoolValue(unsigned nameID) {
+    assert(!modelValues.empty() && "Model is empty!");
+    if (nameID>=nameVars.size() || nameVars[nameID]<0) {
+        std::cout << ">> " << Expression::getInternedName(nameID) << std::endl;
+        std::cerr << "error: variable not declared\n";
+        return -3;
+    }
+    return modelValues[nameVars[nameID]]==1 
+        ? SolverBackend::True : SolverBackend::False;
+}
+
+std::vector<ExprPtr> SATSolver::getUnsatExpressions() {
+    std::vector<ExprPtr> exprs;
+    for (unsigned i=0; i<softs.size(); i++) {
+        if (!modelValue(softLits[i])) {
+            exprs.push_back(softs[i]);
+        }
+    }
+    return exprs;
+}
+
+std::vector<ExprPtr> SATSolver::getSatExpressions() {
+    std::vector<ExprPtr> exprs;
+    for (unsigned i=0; i<softs.size(); i++) {
+        if (modelValue(softLits[i])) {
+            exprs.push_back(softs[i]);
+        }
+    }
+    return exprs;
+}
+
+void SATSolver::push() {
+    scopeSels.push_back(mkLit(newVar(), false));
+    softMarks.push_back(softs.size());
+    retractMarks.push_back(retractSels.size());
+}
+
+void SATSolver::pop() {
+    assert(!scopeSels.empty() && "pop without push!");
+    const Lit sel = scopeSels.back();
+    scopeSels.pop_back();
+    // The clauses guarded by sel are now satisfied
+    addClause(std::vector<Lit>(1, sel ^ 1));
+    softs.resize(softMarks.back());
+    softLits.resize(softMarks.back());
+    softMarks.pop_back();
+    // The assertion IDs are not reused
+    for (unsigned i=retractMarks.back(); i<retractSels.size(); i++) {
+        retract(i);
+    }
+    retractMarks.pop_back();
+}
+
+bool SATSolver::isPropositional(ExprPtr e) {
+    switch (e->getOpCode()) {
+        case Expression::True:
+        case Expression::False:
+        case Expression::BoolVar:
+            return true;
+        case Expression::Not: {
+            NotExprPtr ne = std::static_pointer_cast<NotExpression>(e);
+            return isPropositional(ne->get());
+        }
+        case Expression::And:
+        case Expression::Or:
+        case Expression::Xor: {
+            UnaryExprPtr ue = std::static_pointer_cast<UnaryExpression>(e);
+            std::vector<ExprPtr> es = ue->getExprs();
+            for (ExprPtr e2 : es) {
+                if (!isPropositional(e2)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case Expression::Eq:
+        case Expression::Diseq: {
+            BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(e);
+            return isPropositional(be->getExpr1())
+                && isPropositional(be->getExpr2());
+        }
+        case Expression::Ite: {
+            TrinaryExprPtr te = std::static_pointer_cast<TrinaryExpression>(e);
+            return isPropositional(te->getExpr1())
+                && isPropositional(te->getExpr2())
+                && isPropositional(te->getExpr3());
+        }
+        default:
+            return false;
+    }
+}
+
+// ============================================================
+// Translation
+// ============================================================
+
+SATSolver::Lit SATSolver::makeLiteral(ExprPtr e) {
+    const unsigned id = e->getID();
+    std::unordered_map<unsigned, Lit>::iterator it = exprLits.find(id);
+    if (it!=exprLits.end()) {
+        nbCacheHits++;
+        return it->second;
+    }
+    nbCacheMisses++;
+    Lit p = translate(e);
+    exprLits[id] = p;
+    return p;
+}
+
+SATSolver::Lit SATSolver::translate(ExprPtr e) {
+    switch (e->getOpCode()) {
+        case Expression::True:
+            return trueLit;
+        case Expression::False:
+            return trueLit ^ 1;
+        case Expression::BoolVar: {
+            BoolVarExprPtr be = std::static_pointer_cast<BoolVarExpression>(e);
+            const unsigned id = be->getNameID();
+            if (id>=nameVars.size()) {
+                nameVars.resize(Expression::getNbInternedNames(), -1);
+            }
+            if (nameVars[id]<0) {
+                nameVars[id] = newVar();
+            }
+            return mkLit(nameVars[id], false);
+        }
+        case Expression::Not: {
+            NotExprPtr ne = std::static_pointer_cast<NotExpression>(e);
+            return makeLiteral(ne->get()) ^ 1;
+        }
+        case Expression::And:
+        case Expression::Or: {
+            UnaryExprPtr ue = std::static_pointer_cast<UnaryExpression>(e);
+            std::vector<ExprPtr> es = ue->getExprs();
+            assert(!es.empty() && "empty AND/OR expression!");
+            if (es.size()==1) {
+                return makeLiteral(es.back());
+            }
+            // An OR is a negated AND of negated literals
+            const bool isOr = (e->getOpCode()==Expression::Or);
+            std::vector<Lit> args;
+            for (ExprPtr e2 : es) {
+                args.push_back(makeLiteral(e2) ^ (int)isOr);
+            }
+            // v <-> (and args)
+            Lit v = mkLit(newVar(), false);
+            std::vector<Lit> big(1, v);
+            for (Lit a : args) {
+                std::vector<Lit> c;
+                c.push_back(v ^ 1);
+                c.push_back(a);
+                addClause(c);
+                big.push_back(a ^ 1);
+            }
+            addClause(big);
+            return v ^ (int)isOr;
+        }
+        case Expression::Xor: {
+            XorExprPtr xe = std::static_pointer_cast<XorExpression>(e);
+            std::vector<ExprPtr> es = xe->getExprs();
+            assert(!es.empty() && "empty XOR expression!");
+            Lit p = makeLiteral(es[0]);
+            for (unsigned i=1; i<es.size(); i++) {
+                p = mkXorLit(p, makeLiteral(es[i]));
+            }
+            return p;
+        }
+        case Expression::Eq:
+        case Expression::Diseq: {
+            BinaryExprPtr be = std::static_pointer_cast<BinaryExpression>(e);
+            if (!isPropositional(e)) {
+                break;
+            }
+            Lit p = mkXorLit(makeLiteral(be->getExpr1()),
+                             makeLiteral(be->getExpr2()));
+            return (e->getOpCode()==Expression::Eq) ? (p ^ 1) : p;
+        }
+        case Expression::Ite: {
+            TrinaryExprPtr te = std::static_pointer_cast<TrinaryExpression>(e);
+            if (!isPropositional(e)) {
+                break;
+            }
+            Lit c = makeLiteral(te->getExpr1());
+            Lit t = makeLiteral(te->getExpr2());
+            Lit f = makeLiteral(te->getExpr3());
+            Lit v = mkLit(newVar(), false);
+            std::vector<Lit> c1, c2, c3, c4;
+            c1.push_back(c ^ 1); c1.push_back(t ^ 1); c1.push_back(v);
+            c2.push_back(c ^ 1); c2.push_back(t); c2.push_back(v ^ 1);
+            c3.push_back(c); c3.push_back(f ^ 1); c3.push_back(v);
+            c4.push_back(c); c4.push_back(f); c4.push_back(v ^ 1);
+            addClause(c1);
+            addClause(c2);
+            addClause(c3);
+            addClause(c4);
+            return v;
+        }
+        default:
+            break;
+    }
+    std::cout << "error: SATSolver: non-propositional expression: ";
+    e->dump();
+    std::cout << std::endl;
+    exit(1);
+}
+
+SATSolver::Lit SATSolver::mkXorLit(Lit a, Lit b) {
+    Lit v = mkLit(newVar(), false);
+    std::vector<Lit> c1, c2, c3, c4;
+    c1.push_back(v ^ 1); c1.push_back(a); c1.push_back(b);
+    c2.push_back(v ^ 1); c2.push_back(a ^ 1); c2.push_back(b ^ 1);
+    c3.push_back(v); c3.push_back(a ^ 1); c3.push_back(b);
+    c4.push_back(v); c4.push_back(a); c4.push_back(b ^ 1);
+    addClause(c1);
+    addClause(c2);
+    addClause(c3);
+    addClause(c4);
+    return v;
+}
+
+void SATSolver::addAtMostOne(const std::vector<Lit> &lits) {
+    const unsigned n = lits.size();
+    if (n<=1) {
+        return;
+    }
+    if (n<=5) {
+        // Pairwise encoding
+        for (unsigned i=0; i<n; i++) {
+            for (unsigned j=i+1; j<n; j++) {
+                std::vector<Lit> c;
+                c.push_back(lits[i] ^ 1);
+                c.push_back(lits[j] ^ 1);
+                addClause(c);
+            }
+        }
+        return;
+    }
+    // Sequential counter encoding (Sinz): si <-> (l0 or ... or li)
+    std::vector<Lit> s(n-1);
+    for (unsigned i=0; i<n-1; i++) {
+        s[i] = mkLit(newVar(), false);
+    }
+    for (unsigned i=0; i<n; i++) {
+        std::vector<Lit> c;
+        if (i<n-1) {
+            c.push_back(lits[i] ^ 1);
+            c.push_back(s[i]);
+            addClause(c);
+            c.clear();
+        }
+        if (i>0) {
+            c.push_back(lits[i] ^ 1);
+            c.push_back(s[i-1] ^ 1);
+            addClause(c);
+            c.clear();
+            if (i<n-1) {
+                c.push_back(s[i-1] ^ 1);
+                c.push_back(s[i]);
+                addClause(c);
+            }
+        }
+    }
+}
+
+// ============================================================
+// CDCL
+// ============================================================
+
+int SATSolver::newVar() {
+    const int v = assigns.size();
+    assigns.push_back(-1);
+    levels.push_back(0);
+    reasons.push_back(NoReason);
+    polarity.push_back(1); // false first
+    activity.push_back(0.0);
+    heapIndex.push_back(-1);
+    seen.push_back(0);
+    watches.push_back(std::vector<Watch>());
+    watches.push_back(std::vector<Watch>());
+    heapInsert(v);
+    return v;
+}
+
+bool SATSolver::addClause(std::vector<Lit> lits) {
+    if (!ok) {
+        return false;
+    }
+    cancelUntil(0);
+    // Remove duplicates and false literals,
+    // skip satisfied and tautological clauses
+    std::sort(lits.begin(), lits.end());
+    std::vector<Lit> c;
+    Lit prev = -1;
+    for (Lit p : lits) {
+        if (value(p)==1 || p==(prev ^ 1)) {
+            return true;
+        }
+        if (value(p)!=0 && p!=prev) {
+            c.push_back(p);
+            prev = p;
+        }
+    }
+    if (c.empty()) {
+        ok = false;
+        return false;
+    }
+    if (c.size()==1) {
+        enqueue(c[0], NoReason);
+        ok = (propagate()==NoReason);
+        return ok;
+    }
+    unsigned cref = allocClause(c);
+    clauses.push_back(cref);
+    attachClause(cref);
+    return true;
+}
+
+unsigned SATSolver::allocClause(const std::vector<Lit> &lits) {
+    const unsigned cref = arena.size();
+    arena.push_back(lits.size());
+    arena.insert(arena.end(), lits.begin(), lits.end());
+    return cref;
+}
+
+void SATSolver::attachClause(unsigned cref) {
+    const int *c = &arena[cref+1];
+    watches[c[0] ^ 1].push_back(Watch(cref, c[1]));
+    watches[c[1] ^ 1].push_back(Watch(cref, c[0]));
+}
+
+void SATSolver::enqueue(Lit p, unsigned from) {
+    const int v = var(p);
+    assigns[v] = !sign(p);
+    levels[v] = decisionLevel();
+    reasons[v] = from;
+    trail.push_back(p);
+}
+
+unsigned SATSolver::propagate() {
+    unsigned confl = NoReason;
+    while (qhead<trail.size()) {
+        const Lit p = trail[qhead++];
+        const Lit falseLit = p ^ 1;
+        std::vector<Watch> &ws = watches[p];
+        unsigned i = 0, j = 0;
+        const unsigned n = ws.size();
+        nbPropagations++;
+        while (i<n) {
+            // Clause satisfied by its blocker
+            const Watch w = ws[i++];
+            if (value(w.blocker)==1) {
+                ws[j++] = w;
+                continue;
+            }
+            const unsigned cref = w.cref;
+            int *c = &arena[cref+1];
+            const int size = arena[cref];
+            // Make sure the false literal is c[1]
+            if (c[0]==falseLit) {
+                c[0] = c[1];
+                c[1] = falseLit;
+            }
+            const Lit first = c[0];
+            if (first!=w.blocker && value(first)==1) {
+                ws[j++] = Watch(cref, first);
+                continue;
+            }
+            // Look for a new literal to watch
+            bool found = false;
+            for (int k=2; k<size; k++) {
+                if (value(c[k])!=0) {
+                    c[1] = c[k];
+                    c[k] = falseLit;
+                    watches[c[1] ^ 1].push_back(Watch(cref, first));
+                    found = true;
+                    break;
+                }
+            }
+            if (found) {
+                continue;
+            }
+            // Unit or conflicting clause
+            ws[j++] = Watch(cref, first);
+            if (value(first)==0) {
+                confl = cref;
+                qhead = trail.size();
+                while (i<n) {
+                    ws[j++] = ws[i++];
+                }
+            } else {
+                enqueue(first, cref);
+            }
+        }
+        ws.resize(j);
+        if (confl!=NoReason) {
+            break;
+        }
+    }
+    return confl;
+}
+
+void SATSolver::analyze(unsigned confl, std::vector<Lit> &learnt, int &btLevel) {
+    int pathC = 0;
+    Lit p = -1;
+    learnt.clear();
+    learnt.push_back(-1); // room for the asserting literal
+    int index = trail.size()-1;
+    do {
+        assert(confl!=NoReason && "Missing reason clause!");
+        const int *c = &arena[confl+1];
+        const int size = arena[confl];
+        for (int k=(p==-1)?0:1; k<size; k++) {
+            const Lit q = c[k];
+            const int v = var(q);
+            if (!seen[v] && levels[v]>0) {
+                varBumpActivity(v);
+                seen[v] = 1;
+                if (levels[v]>=decisionLevel()) {
+                    pathC++;
+                } else {
+                    learnt.push_back(q);
+                }
+            }
+        }
+        // Next literal of the current level to look at
+        while (!seen[var(trail[index])]) {
+            index--;
+        }
+        p = trail[index--];
+        confl = reasons[var(p)];
+        seen[var(p)] = 0;
+        pathC--;
+    } while (pathC>0);
+    learnt[0] = p ^ 1;
+    // Remove the literals implied by the other literals of the clause
+    std::vector<Lit> marked(learnt);
+    unsigned j = 1;
+    for (unsigned i=1; i<learnt.size(); i++) {
+        const unsigned r = reasons[var(learnt[i])];
+        bool redundant = (r!=NoReason);
+        if (redundant) {
+            const int *c = &arena[r+1];
+            const int size = arena[r];
+            for (int k=1; k<size; k++) {
+                const int v = var(c[k]);
+                if (!seen[v] && levels[v]>0) {
+                    redundant = false;
+                    break;
+                }
+            }
+        }
+        if (!redundant) {
+            learnt[j++] = learnt[i];
+        }
+    }
+    learnt.resize(j);
+    for (Lit q : marked) {
+        seen[var(q)] = 0;
+    }
+    // Backtrack level: the highest level after the asserting literal
+    btLevel = 0;
+    if (learnt.size()>1) {
+        unsigned max = 1;
+        for (unsigned i=2; i<learnt.size(); i++) {
+            if (levels[var(learnt[i])]>levels[var(learnt[max])]) {
+                max = i;
+            }
+        }
+        std::swap(learnt[1], learnt[max]);
+        btLevel = levels[var(learnt[1])];
+    }
+}
+
+void SATSolver::analyzeFinal(Lit p) {
+    conflictCore.clear();
+    conflictCore.push_back(p);
+    if (decisionLevel()==0) {
+        return;
+    }
+    seen[var(p)] = 1;
+    for (int i=trail.size()-1; i>=(int)trailLim[0]; i--) {
+        const int v = var(trail[i]);
+        if (seen[v]) {
+            const unsigned r = reasons[v];
+            if (r==NoReason) {
+                // Decisions are assumptions at this point
+                conflictCore.push_back(trail[i]);
+            } else {
+                const int *c = &arena[r+1];
+                const int size = arena[r];
+                for (int k=1; k<size; k++) {
+                    if (levels[var(c[k])]>0) {
+                        seen[var(c[k])] = 1;
+                    }
+                }
+            }
+            seen[v] = 0;
+        }
+    }
+    seen[var(p)] = 0;
+}
+
+void SATSolver::cancelUntil(int level) {
+    if (decisionLevel()>level) {
+        for (int i=trail.size()-1; i>=(int)trailLim[level]; i--) {
+            const int v = var(trail[i]);
+            assigns[v] = -1;
+            polarity[v] = sign(trail[i]);
+            if (heapIndex[v]<0) {
+                heapInsert(v);
+            }
+        }
+        trail.resize(trailLim[level]);
+        trailLim.resize(level);
+        qhead = trail.size();
+    }
+}
+
+void SATSolver::reduceDB() {
+    assert(decisionLevel()==0 && "reduceDB must be called at level 0!");
+    // Keep the smallest half of the learnt clauses
+    std::vector<std::pair<int, unsigned> > bySize;
+    for (unsigned cref : learnts) {
+        bySize.push_back(std::make_pair(arena[cref], cref));
+    }
+    std::sort(bySize.begin(), bySize.end());
+    std::vector<unsigned> keptLearnts;
+    for (unsigned i=0; i<bySize.size(); i++) {
+        if (i<bySize.size()/2 || bySize[i].first<=2) {
+            keptLearnts.push_back(bySize[i].second);
+        }
+    }
+    learnts.swap(keptLearnts);
+    removeSatisfied();
+}
+
+void SATSolver::removeSatisfied() {
+    assert(decisionLevel()==0 && "removeSatisfied must be called at level 0!");
+    // Level 0 assignments do not need their reasons
+    for (Lit p : trail) {
+        reasons[var(p)] = NoReason;
+    }
+    // Rebuild the arena without the satisfied clauses
+    // and the level 0 false literals
+    std::vector<int> old;
+    old.swap(arena);
+    for (unsigned w=0; w<watches.size(); w++) {
+        watches[w].clear();
+    }
+    std::vector<unsigned> *lists[2] = { &clauses, &learnts };
+    std::vector<unsigned> oldClauses(clauses);
+    std::vector<unsigned> oldLearnts(learnts);
+    std::vector<unsigned> *olds[2] = { &oldClauses, &oldLearnts };
+    for (unsigned l=0; l<2; l++) {
+        lists[l]->clear();
+        for (unsigned cref : *olds[l]) {
+            std::vector<Lit> c;
+            bool satisfied = false;
+            for (int k=0; k<old[cref]; k++) {
+                const Lit p = old[cref+1+k];
+                if (value(p)==1) {
+                    satisfied = true;
+                    break;
+                }
+                if (value(p)==-1) {
+                    c.push_back(p);
+                }
+            }
+            if (satisfied) {
+                continue;
+            }
+            assert(c.size()>=2 && "Clause not propagated at level 0!");
+            unsigned newCref = allocClause(c);
+            lists[l]->push_back(newCref);
+            attachClause(newCref);
+        }
+    }
+}
+
+int SATSolver::search(int nbConflictsMax, const std::vector<Lit> &assumps) {
+    int nbConflictsCur = 0;
+    std::vector<Lit> learnt;
+    for (;;) {
+        unsigned confl = propagate();
+        if (confl!=NoReason) {
+            // Conflict
+            nbConflicts++;
+            nbConflictsCur++;
+            if (decisionLevel()==0) {
+                ok = false;
+                return SolverBackend::False;
+            }
+            int btLevel;
+            analyze(confl, learnt, btLevel);
+            cancelUntil(btLevel);
+            if (learnt.size()==1) {
+                enqueue(learnt[0], NoReason);
+            } else {
+                unsigned cref = allocClause(learnt);
+                learnts.push_back(cref);
+                attachClause(cref);
+                enqueue(learnt[0], cref);
+            }
+            varInc *= (1 / 0.95);
+        } else {
+            if (nbConflictsCur>=nbConflictsMax) {
+                cancelUntil(0);
+                return SolverBackend::Undef;
+            }
+            // Assumptions first, then the most active variable
+            Lit next = -1;
+            while (decisionLevel()<(int)assumps.size()) {
+                const Lit p = assumps[decisionLevel()];
+                if (value(p)==1) {
+                    trailLim.push_back(trail.size()); // dummy level
+                } else if (value(p)==0) {
+                    analyzeFinal(p);
+                    return SolverBackend::False;
+                } else {
+                    next = p;
+                    break;
+                }
+            }
+            if (next==-1) {
+                int v = -1;
+                while (!heap.empty()) {
+                    v = heapRemoveMin();
+                    if (assigns[v]<0) {
+                        break;
+                    }
+                    v = -1;
+                }
+                if (v==-1) {
+                    // All variables assigned: model found
+                    modelValues = assigns;
+                    return SolverBackend::True;
+                }
+                nbDecisions++;
+                next = mkLit(v, polarity[v]);
+            }
+            trailLim.push_back(trail.size());
+            enqueue(next, NoReason);
+        }
+    }
+}
+
+int SATSolver::solve(const std::vector<Lit> &assumps) {
+    conflictCore.clear();
+    if (!ok) {
+        return SolverBackend::False;
+    }
+    cancelUntil(0);
+    if (maxLearnts==0) {
+        maxLearnts = clauses.size()/3.0+1000;
+    }
+    int status = SolverBackend::Undef;
+    for (int restarts=0; status==SolverBackend::Undef; restarts++) {
+        if (learnts.size()>=maxLearnts) {
+            if (propagate()!=NoReason) {
+                ok = false;
+                return SolverBackend::False;
+            }
+            reduceDB();
+            maxLearnts *= 1.1;
+        }
+        status = search(luby(2, restarts)*100, assumps);
+    }
+    cancelUntil(0);
+    return status;
+}
+
+// ============================================================
+// VSIDS heap
+// ============================================================
+
+void SATSolver::varBumpActivity(int v) {
+    activity[v] += varInc;
+    if (activity[v]>1e100) {
+        // Rescale
+        for (unsigned i=0; i<activity.size(); i++) {
+            activity[i] *= 1e-100;
+        }
+        varInc *= 1e-100;
+    }
+    if (heapIndex[v]>=0) {
+        heapPercolateUp(heapIndex[v]);
+    }
+}
+
+void SATSolver::heapInsert(int v) {
+    heapIndex[v] = heap.size();
+    heap.push_back(v);
+    heapPercolateUp(heapIndex[v]);
+}
+
+int SATSolver::heapRemoveMin() {
+    const int v = heap[0];
+    heap[0] = heap.back();
+    heapIndex[heap[0]] = 0;
+    heapIndex[v] = -1;
+    heap.pop_back();
+    if (heap.size()>1) {
+        heapPercolateDown(0);
+    }
+    return v;
+}
+
+void SATSolver::heapPercolateUp(int i) {
+    const int v = heap[i];
+    while (i>0) {
+        const int parent = (i-1)>>1;
+        if (!heapLess(v, heap[parent])) {
+            break;
+        }
+        heap[i] = heap[parent];
+        heapIndex[heap[i]] = i;
+        i = parent;
+    }
+    heap[i] = v;
+    heapIndex[v] = i;
+}
+
+void SATSolver::heapPercolateDown(int i) {
+    const int v = heap[i];
+    const int n = heap.size();
+    while (2*i+1<n) {
+        int child = 2*i+1;
+        if (child+1<n && heapLess(heap[child+1], heap[child])) {
+            child++;
+        }
+        if (!heapLess(heap[child], v)) {
+            break;
+        }
+        heap[i] = heap[child];
+        heapIndex[heap[i]] = i;
+        i = child;
+    }
+    heap[i] = v;
+    heapIndex[v] = i;
+}
@@ -0,0 +1,564 @@
+/**
+ * \file SATSolver.h
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+#ifndef _SATSOLVER_H
+#define _SATSOLVER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <unordered_map>
+
+#include "Expression.h"
+#include "Formula.h"
+#include "SolverBackend.h"
+#include "SolverStats.h"
+
+/**
+ * \class SATSolver
+ *
+ * \brief A CDCL SAT solver with a core-guided max-sat layer,
+ *        for propositional formulas.
+ *
+ * The expressions are translated into clauses with the Tseitin
+ * encoding (only True, False, BoolVar, Not, And, Or, Xor, and
+ * boolean Eq, Diseq and Ite are supported). The SAT core uses
+ * two watched literals with blocker literals, clauses stored
+ * in a single arena, VSIDS branching, phase saving, first-UIP
+ * clause learning and Luby restarts. The retractable assertions
+ * and the backtracking points are guarded by selector literals,
+ * which are assumed while solving.
+ *
+ * Max-sat is solved with the Fu-Malik algorithm: unsatisfiable
+ * cores over the soft expressions are extracted with assumption
+ * literals and relaxed until the formula is satisfiable.
+ * Soft expressions have a unit weight. The assumption literals are
+ * shared by the successive calls, and the clauses of the relaxations
+ * are removed at the end of each call.
+ *
+ * The solver is meant for small and purely propositional queries
+ * (e.g. the hitting-set problems), where it avoids the overhead of
+ * the SMT solver.
+ */
+class SATSolver : public SolverBackend {
+
+public:
+    /**
+     * Literal: 2*v for the variable v, 2*v+1 for its negation.
+     */
+    typedef int Lit;
+
+private:
+    /**
+     * Entry of a watch list.
+     */
+    struct Watch {
+        /**
+         * Reference of the watching clause in the arena.
+         */
+        unsigned cref;
+        /**
+         * A literal of the clause, if true the clause
+         * does not need to be visited.
+         */
+        Lit blocker;
+        Watch() : cref(0), blocker(0) { }
+        Watch(unsigned _cref, Lit _blocker)
+        : cref(_cref), blocker(_blocker) { }
+    };
+    /**
+     * Clause arena: each clause is stored as its size
+     * followed by its literals.
+     */
+    std::vector<int> arena;
+    /**
+     * References of the problem clauses.
+     */
+    std::vector<unsigned> clauses;
+    /**
+     * References of the learnt clauses.
+     */
+    std::vector<unsigned> learnts;
+    /**
+     * Watch lists, indexed by literal. The list of p contains the
+     * clauses watching the negation of p.
+     */
+    std::vector<std::vector<Watch> > watches;
+    /**
+     * Current assignment: -1 (undefined), 0 (false) or 1 (true).
+     */
+    std::vector<signed char> assigns;
+    /**
+     * Decision level of the assigned variables.
+     */
+    std::vector<int> levels;
+    /**
+     * Reason clause of the assigned variables (or NoReason).
+     */
+    std::vector<unsigned> reasons;
+    /**
+     * Saved phase of the variables.
+     */
+    std::vector<signed char> polarity;
+    /**
+     * VSIDS activity of the variables.
+     */
+    std::vector<double> activity;
+    /**
+     * Variable activity increment.
+     */
+    double varInc;
+    /**
+     * Binary heap of the variables ordered by activity.
+     */
+    std::vector<int> heap;
+    /**
+     * Position of the variables in the heap (-1 if not in the heap).
+     */
+    std::vector<int> heapIndex;
+    /**
+     * Marks used by the conflict analysis.
+     */
+    std::vector<char> seen;
+    /**
+     * Assignment trail.
+     */
+    std::vector<Lit> trail;
+    /**
+     * Trail size at each decision level.
+     */
+    std::vector<unsigned> trailLim;
+    /**
+     * Head of the propagation queue in the trail.
+     */
+    unsigned qhead;
+    /**
+     * False if the clauses are unsatisfiable at decision level 0.
+     */
+    bool ok;
+    /**
+     * Maximum number of learnt clauses before reduction.
+     */
+    double maxLearnts;
+    /**
+     * Assumptions responsible for the last unsatisfiable answer.
+     */
+    std::vector<Lit> conflictCore;
+    /**
+     * Model of the last satisfiable answer.
+     */
+    std::vector<signed char> modelValues;
+    /**
+     * Literal that is always true.
+     */
+    Lit trueLit;
+    /**
+     * Literals of the translated expressions, indexed by expression ID.
+     */
+    std::unordered_map<unsigned, Lit> exprLits;
+    /**
+     * Variables of the boolean variables, indexed by name ID
+     * (-1 if not declared).
+     */
+    std::vector<int> nameVars;
+    /**
+     * Soft expressions and their literals.
+     */
+    std::vector<ExprPtr> softs;
+    std::vector<Lit> softLits;
+    /**
+     * Assumption literal of each soft literal, shared by the
+     * max-sat calls until a relaxation disables it.
+     */
+    std::unordered_map<Lit, Lit> softAssumpLits;
+    /**
+     * Selector of each backtracking point (see push).
+     */
+    std::vector<Lit> scopeSels;
+    /**
+     * Number of soft expressions at each backtracking point.
+     */
+    std::vector<unsigned> softMarks;
+    /**
+     * Selector of each retractable assertion, indexed by
+     * assertion ID (-1 once retracted).
+     */
+    std::vector<Lit> retractSels;
+    /**
+     * Number of retractable assertions at each backtracking point.
+     */
+    std::vector<unsigned> retractMarks;
+    /**
+     * Statistics.
+     */
+    unsigned long nbConflicts, nbDecisions, nbPropagations;
+    unsigned nbCacheHits, nbCacheMisses;
+    
+    static const unsigned NoReason = ~0u;
+
+public:
+    /**
+     * Default constructor.
+     */
+    SATSolver() : varInc(1.0), qhead(0), ok(true), maxLearnts(0),
+                  trueLit(0), nbConflicts(0), nbDecisions(0),
+                  nbPropagations(0), nbCacheHits(0), nbCacheMisses(0) { }
+    /**
+     * Destructor.
+     */
+    virtual ~SATSolver() { }
+    
+    /**
+     * \brief Initialize the solver.
+     */
+    virtual void init();
+    
+    /**
+     * \brief Assert an expression in the logical context.
+     *
+     * \param e A propositional expression (hard or soft).
+     */
+    virtual void addToContext(ExprPtr e);
+    
+    /**
+     * \brief Assert a formula in the logical context.
+     *
+     * \param f A propositional formula.
+     */
+    virtual void addToContext(Formula *f);
+    
+    /**
+     * \brief Assert a hard expression that can be retracted.
+     *
+     * The expression is guarded by a selector literal, which is
+     * assumed by check and maxSat until the assertion is retracted.
+     *
+     * \param e A propositional expression.
+     * \return the assertion ID to be given to retract.
+     */
+    virtual AssertionID addRetractable(ExprPtr e);
+    
+    /**
+     * \brief Retract an assertion made with addRetractable.
+     *
+     * \param i An assertion ID returned by addRetractable.
+     */
+    virtual void retract(AssertionID i);
+    
+    /**
+     * \brief Return the retractable assertions of the unsatisfiable
+     *        core of the last check.
+     */
+    virtual std::vector<AssertionID> getUnsatCore();
+    
+    /**
+     * \brief Check if the logical context is satisfiable.
+     *
+     * This function ignores the soft/hard property associated with the
+     * expressions.
+     *
+     * \return True if the context is satisfiable, or
+     *         False if the context is unsatisfiable.
+     */
+    virtual int check();
+    
+    /**
+     * \brief Compute the maximal satisfying assignment for
+     *        the asserted soft constraints (Fu-Malik).
+     *
+     * \return True if a maximal satisfying assignment was found, or
+     *         False if the hard constraints are unsatisfiable.
+     */
+    virtual int maxSat();
+    
+    /**
+     * \brief Max-sat is always core-guided (CORE): 
+     *        the algorithm cannot be changed.
+     */
+    virtual void setMaxSatAlgorithm(unsigned a) { }
+    virtual unsigned getMaxSatAlgorithm() {
+        return CORE;
+    }
+    virtual void convertMaxSatAlgorithm(unsigned a) { }
+    
+    /**
+     * \brief Return the current model as a list of (= name value).
+     */
+    virtual std::string getModel();
+    
+    /**
+     * \brief Return the number of soft expressions
+     *        falsified by the current model.
+     */
+    virtual double getCostAsDouble();
+    
+    /**
+     * \brief Get the boolean value assigned to variable v in the current model.
+     *
+     * \param name The name of a boolean variable.
+     * \return True, False or -3 if the variable was not declared.
+     */
+    virtual int getBoolValue(std::string name);
+    
+    /**
+     * \brief Get the boolean value assigned to variable v in the current model.
+     *
+     * \param nameID The name ID of a boolean variable.
+     * \return True, False or -3 if the variable was not declared.
+     */
+    virtual int getBoolValue(unsigned nameID);
+    
+    /**
+     * \brief The solver has no integer variables: 
+     *        \p error is always set to true.
+     */
+    virtual int getValue(std::string name, bool &error) {
+        error = true;
+        return 0;
+    }
+    virtual int getValue(unsigned nameID, bool &error) {
+        error = true;
+        return 0;
+    }
+    
+    /**
+     * \brief Return the value of the propositional expression \p e 
+     *        in the current model.
+     *
+     * \return True, False or Undef if \p e contains a variable
+     *         that is not declared.
+     */
+    virtual int evaluate(ExprPtr e);
+    
+    /**
+     * \brief Return the soft expressions that are not
+     *        satisfied by the current model.
+     */
+    virtual std::vector<ExprPtr> getUnsatExpressions();
+    
+    /**
+     * \brief Return the soft expressions that are
+     *        satisfied by the current model.
+     */
+    virtual std::vector<ExprPtr> getSatExpressions();
+    
+    /**
+     * \brief Return the soft expressions, in assertion order.
+     */
+    virtual std::vector<ExprPtr> getSoftExpressions() {
+        return softs;
+    }
+    
+    /**
+     * \brief Create a backtracking point.
+     *
+     * The hard expressions asserted after the push are guarded by
+     * a selector literal, which is assumed while solving and
+     * disabled for good by the matching pop.
+     */
+    virtual void push();
+    
+    /**
+     * \brief Backtrack.
+     *
+     * The expressions asserted since the matching push (including
+     * the retractable ones) are removed.
+     * The learnt clauses and translations are kept.
+     */
+    virtual void pop();
+    
+    /**
+     * \brief Clean the solver state.
+     */
+    virtual void clean();
+    
+    /**
+     * \brief Return \a true if \p e can be handled by the SAT solver,
+     *        that is if \p e is a propositional expression.
+     */
+    static bool isPropositional(ExprPtr e);
+    
+    /**
+     * \brief Return the number of conflicts since init.
+     */
+    unsigned long getNbConflicts() {
+        return nbConflicts;
+    }
+    /**
+     * \brief Return the number of decisions since init.
+     */
+    unsigned long getNbDecisions() {
+        return nbDecisions;
+    }
+    /**
+     * \brief Return the number of propagated literals since init.
+     */
+    unsigned long getNbPropagations() {
+        return nbPropagations;
+    }
+    /**
+     * \brief Return the number of problem clauses (the unit
+     *        clauses are not stored).
+     */
+    unsigned getNbClauses() {
+        return clauses.size();
+    }
+    
+    /**
+     * \brief Sizes of the context and of the translation cache
+     *        (see SolverBackend).
+     */
+    virtual unsigned getNbHardAsserts() {
+        return clauses.size();
+    }
+    virtual unsigned getNbSoftAsserts() {
+        return softs.size();
+    }
+    virtual unsigned getNbVarDecls() {
+        return assigns.size();
+    }
+    virtual unsigned getNbCacheHits() {
+        return nbCacheHits;
+    }
+    virtual unsigned getNbCacheMisses() {
+        return nbCacheMisses;
+    }
+
+private:
+
+    // === Literals and variables ===
+    
+    static int var(Lit p) {
+        return p >> 1;
+    }
+    static bool sign(Lit p) {
+        return p & 1;
+    }
+    static Lit mkLit(int v, bool neg) {
+        return v+v+(int)neg;
+    }
+    /**
+     * Value of the literal \p p: -1 (undefined), 0 (false) or 1 (true).
+     */
+    int value(Lit p) {
+        const signed char a = assigns[var(p)];
+        return a<0 ? -1 : (a ^ (int)sign(p));
+    }
+    int decisionLevel() {
+        return trailLim.size();
+    }
+    /**
+     * Create a fresh variable.
+     */
+    int newVar();
+    
+    // === CDCL ===
+    
+    /**
+     * Add a clause at decision level 0. Return false if the
+     * clauses became unsatisfiable.
+     */
+    bool addClause(std::vector<Lit> lits);
+    void attachClause(unsigned cref);
+    unsigned allocClause(const std::vector<Lit> &lits);
+    void enqueue(Lit p, unsigned from);
+    /**
+     * Propagate the enqueued literals. Return the reference
+     * of a conflicting clause, or NoReason.
+     */
+    unsigned propagate();
+    /**
+     * First-UIP conflict analysis.
+     */
+    void analyze(unsigned confl, std::vector<Lit> &learnt, int &btLevel);
+    /**
+     * Compute in conflictCore the assumptions responsible
+     * for the falsified assumption \p p.
+     */
+    void analyzeFinal(Lit p);
+    void cancelUntil(int level);
+    /**
+     * Remove half of the learnt clauses and the satisfied clauses.
+     * Must be called at decision level 0.
+     */
+    void reduceDB();
+    /**
+     * Remove the satisfied clauses and the false literals, then
+     * rebuild the arena and the watch lists. Must be called at
+     * decision level 0, after propagation.
+     */
+    void removeSatisfied();
+    int search(int nbConflictsMax, const std::vector<Lit> &assumps);
+    /**
+     * Solve under the given assumptions.
+     *
+     * \return True, False (see conflictCore) or Undef.
+     */
+    int solve(const std::vector<Lit> &assumps);
+    
+    // === VSIDS heap ===
+    
+    void varBumpActivity(int v);
+    void heapInsert(int v);
+    int  heapRemoveMin();
+    void heapPercolateUp(int i);
+    void heapPercolateDown(int i);
+    bool heapLess(int v1, int v2) {
+        return activity[v1]>activity[v2];
+    }
+    
+    // === Translation ===
+    
+    /**
+     * Return the literal equivalent to \p e (Tseitin encoding).
+     */
+    Lit makeLiteral(ExprPtr e);
+    Lit translate(ExprPtr e);
+    /**
+     * Return a literal equivalent to (a xor b).
+     */
+    Lit mkXorLit(Lit a, Lit b);
+    /**
+     * Add the clauses constraining at most one of \p lits to be true.
+     */
+    void addAtMostOne(const std::vector<Lit> &lits);
+    /**
+     * Return the assumptions of the current backtracking points
+     * and of the retractable assertions.
+     */
+    std::vector<Lit> getScopeAssumptions();
+    /**
+     * Value of the literal \p p in the model.
+     */
+    bool modelValue(Lit p) {
+        return (modelValues[var(p)]==1) != sign(p);
+    }
+
+};
+
+#endif // _SATSOLVER_H
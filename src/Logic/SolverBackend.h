@@ -0,0 +1,286 @@
+/**
+ * \file SolverBackend.h
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+#ifndef _SOLVERBACKEND_H
+#define _SOLVERBACKEND_H
+
+#include <string>
+#include <vector>
+
+#include "Expression.h"
+#include "Formula.h"
+
+/**
+ * \class SolverBackend
+ *
+ * \brief Abstract interface of the (max-)sat solvers used by SNIPER.
+ *
+ * A backend owns a logical context in which hard and soft
+ * expressions are asserted, and can check or max-sat this context.
+ * Hard expressions can also be asserted as retractable assertions,
+ * which are reported in the unsatisfiable cores. The results are
+ * three-valued (see Result) and have the values of the lbool of 
+ * Yices 1, so that the backends can be used interchangeably.
+ *
+ * Two backends are available: YicesSolver (SMT, used for the
+ * trace formulas) and SATSolver (propositional only, used for
+ * the hitting-set problems and the block-transition skeletons).
+ */
+class SolverBackend {
+
+public:
+    /**
+     * Result of check and maxSat, and value of an expression 
+     * or of a boolean variable in a model.
+     */
+    enum Result {
+        False = -1, /*!< Unsatisfiable (false) */
+        Undef =  0, /*!< Unknown */
+        True  =  1  /*!< Satisfiable (true) */
+    };
+    
+    /**
+     * Max-sat algorithms.
+     */
+    enum MaxSatAlgorithm {
+        NATIVE, /*!< Built-in max-sat of the backend (default) */
+        CORE    /*!< Core-guided max-sat (Fu-Malik) over check calls */
+    };
+    
+    /**
+     * Identifier of a retractable assertion.
+     */
+    typedef int AssertionID;
+    
+    /**
+     * Destructor.
+     */
+    virtual ~SolverBackend() { }
+    
+    /**
+     * \brief Initialize the solver.
+     *
+     * This function should be call before calling check or maxSat.
+     */
+    virtual void init() = 0;
+    
+    /**
+     * \brief Assert an expression in the logical context.
+     *
+     * \param e An expression (hard or soft).
+     */
+    virtual void addToContext(ExprPtr e) = 0;
+    
+    /**
+     * \brief Assert a formula in the logical context.
+     *
+     * \param f A formula.
+     */
+    virtual void addToContext(Formula *f) = 0;
+    
+    /**
+     * \brief Assert a hard expression that can be retracted.
+     *
+     * \param e A hard expression.
+     * \return the identifier of the assertion (see retract and
+     *         getUnsatCore).
+     */
+    virtual AssertionID addRetractable(ExprPtr e) = 0;
+    
+    /**
+     * \brief Retract an assertion made with addRetractable.
+     */
+    virtual void retract(AssertionID id) = 0;
+    
+    /**
+     * \brief Return the retractable assertions of the unsatisfiable
+     *        core found by the last check.
+     */
+    virtual std::vector<AssertionID> getUnsatCore() = 0;
+    
+    /**
+     * \brief Check if the logical context is satisfiable.
+     *
+     * This function ignores the soft/hard property associated with the
+     * expressions.
+     *
+     * \return True, False or Undef.
+     */
+    virtual int check() = 0;
+    
+    /**
+     * \brief Compute the maximal satisfying assignment for
+     *        the asserted soft constraints.
+     *
+     * \return True if a maximal satisfying assignment was found, or
+     *         False if the hard constraints are unsatisfiable, or
+     *         Undef if it was not possible to decide.
+     */
+    virtual int maxSat() = 0;
+    
+    /**
+     * \brief Select the algorithm used by maxSat, before any soft
+     *        expression is asserted.
+     *
+     * \param a NATIVE or CORE.
+     */
+    virtual void setMaxSatAlgorithm(unsigned a) = 0;
+    
+    /**
+     * \brief Return the algorithm used by maxSat.
+     */
+    virtual unsigned getMaxSatAlgorithm() = 0;
+    
+    /**
+     * \brief Switch the max-sat algorithm of a context in which
+     *        soft expressions are already asserted (see 
+     *        PortfolioSolver). pop must not be called afterwards.
+     *
+     * \param a NATIVE or CORE.
+     */
+    virtual void convertMaxSatAlgorithm(unsigned a) = 0;
+    
+    /**
+     * \brief Return a model for a satisfiable logical context.
+     */
+    virtual std::string getModel() = 0;
+    
+    /**
+     * \brief Return the cost of the current model.
+     */
+    virtual double getCostAsDouble() = 0;
+    
+    /**
+     * \brief Get the integer value assigned to a variable 
+     *        in the current model.
+     *
+     * \param name The name of an integer variable.
+     * \param error Receives true if the variable has no value.
+     * \return the value of the variable, or 0.
+     */
+    virtual int getValue(std::string name, bool &error) = 0;
+    
+    /**
+     * \brief Get the integer value assigned to a variable 
+     *        in the current model.
+     *
+     * \param nameID The name ID of an integer variable
+     *        (see Expression::internName).
+     * \param error Receives true if the variable has no value.
+     * \return the value of the variable, or 0.
+     */
+    virtual int getValue(unsigned nameID, bool &error) = 0;
+    
+    /**
+     * \brief Get the boolean value assigned to variable v in the current model.
+     *
+     * \param name The name of a boolean variable.
+     * \return the value of the variable, or
+     *         -3 if the variable was not declared.
+     */
+    virtual int getBoolValue(std::string name) = 0;
+    
+    /**
+     * \brief Get the boolean value assigned to variable v in the current model.
+     *
+     * \param nameID The name ID of a boolean variable
+     *        (see Expression::internName).
+     * \return the value of the variable, or
+     *         -3 if the variable was not declared.
+     */
+    virtual int getBoolValue(unsigned nameID) = 0;
+    
+    /**
+     * \brief Return the value (True, False or Undef) of the 
+     *        boolean expression \p e in the current model.
+     */
+    virtual int evaluate(ExprPtr e) = 0;
+    
+    /**
+     * \brief Return the soft expressions that are not
+     *        satisfied by the current model.
+     */
+    virtual std::vector<ExprPtr> getUnsatExpressions() = 0;
+    
+    /**
+     * \brief Return the soft expressions that are
+     *        satisfied by the current model.
+     */
+    virtual std::vector<ExprPtr> getSatExpressions() = 0;
+    
+    /**
+     * \brief Return the soft expressions of the context,
+     *        in a deterministic order.
+     */
+    virtual std::vector<ExprPtr> getSoftExpressions() = 0;
+    
+    /**
+     * \brief Create a backtracking point.
+     */
+    virtual void push() = 0;
+    
+    /**
+     * \brief Backtrack to the last backtracking point.
+     */
+    virtual void pop() = 0;
+    
+    /**
+     * \brief Clean the solver state.
+     */
+    virtual void clean() = 0;
+
+    /**
+     * \brief Return the number of hard assertions (or clauses) 
+     *        in the context.
+     */
+    virtual unsigned getNbHardAsserts() = 0;
+    
+    /**
+     * \brief Return the number of soft assertions in the context.
+     */
+    virtual unsigned getNbSoftAsserts() = 0;
+    
+    /**
+     * \brief Return the number of declared variables.
+     */
+    virtual unsigned getNbVarDecls() = 0;
+    
+    /**
+     * \brief Return the number of expression translations that
+     *        were answered by the translation cache.
+     */
+    virtual unsigned getNbCacheHits() = 0;
+    
+    /**
+     * \brief Return the number of expression translations that
+     *        were not answered by the translation cache.
+     */
+    virtual unsigned getNbCacheMisses() = 0;
+
+};
+
+#endif // _SOLVERBACKEND_H
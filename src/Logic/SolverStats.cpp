@@ -0,0 +1,220 @@
+/**
+ * \file SolverStats.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#include "SolverStats.h"
+#include "SolverBackend.h"
+
+SolverStats::Entry SolverStats::entries[SolverStats::NbPhases][2];
+unsigned SolverStats::phase = SolverStats::OTHER;
+
+static const char *bucketNames[SolverStats::NbBuckets] = {
+    "<0.01ms", "<0.1ms", "<1ms", "<10ms", "<100ms", "<1s", "<10s", ">=10s"
+};
+
+void SolverStats::record(bool isMaxSat, double ms, unsigned nbHard,
+                         unsigned nbSoft, unsigned nbVars, int result) {
+    Entry &e = entries[phase][isMaxSat ? 1 : 0];
+    e.nbQueries++;
+    // False=-1, Undef=0, True=1
+    if (result>=SolverBackend::False && result<=SolverBackend::True) {
+        e.nbResults[result+1]++;
+    }
+    e.totalTime += ms;
+    if (ms>e.maxTime) e.maxTime = ms;
+    e.totalHard += nbHard;
+    e.totalSoft += nbSoft;
+    e.totalVars += nbVars;
+    if (nbHard>e.maxHard) e.maxHard = nbHard;
+    if (nbSoft>e.maxSoft) e.maxSoft = nbSoft;
+    if (nbVars>e.maxVars) e.maxVars = nbVars;
+    e.histogram[getBucket(ms)]++;
+}
+
+unsigned SolverStats::getBucket(double ms) {
+    unsigned b = 0;
+    double bound = 0.01;
+    while (b<NbBuckets-1 && ms>=bound) {
+        bound *= 10;
+        b++;
+    }
+    return b;
+}
+
+unsigned long SolverStats::getNbQueries(unsigned p) {
+    assert(p<NbPhases && "Unknown phase!");
+    return entries[p][0].nbQueries + entries[p][1].nbQueries;
+}
+
+unsigned long SolverStats::getNbResults(unsigned p, int result) {
+    assert(p<NbPhases && "Unknown phase!");
+    assert(result>=SolverBackend::False && result<=SolverBackend::True
+           && "Unknown result!");
+    return entries[p][0].nbResults[result+1]
+         + entries[p][1].nbResults[result+1];
+}
+
+std::string SolverStats::getPhaseName(unsigned p) {
+    switch (p) {
+        case BMC:        return "bmc";
+        case CONCOLIC:   return "concolic";
+        case MCS:        return "mcs";
+        case HITTINGSET: return "hitting-set";
+        default:         return "other";
+    }
+}
+
+void SolverStats::printReport(std::ostream &out) {
+    out << "=================================================\n";
+    out << "Solver statistics\n";
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    for (unsigned p=0; p<NbPhases; p++) {
+        for (unsigned k=0; k<2; k++) {
+            const Entry &e = entries[p][k];
+            if (e.nbQueries==0) {
+                continue;
+            }
+            out << "\n[" << getPhaseName(p) << "] ";
+            out << (k==0 ? "check" : "max-sat") << std::endl;
+            out << "   queries      " << e.nbQueries;
+            out << " (sat " << e.nbResults[2];
+            out << ", unsat " << e.nbResults[0];
+            out << ", unknown " << e.nbResults[1] << ")\n";
+            out << "   time (ms)    total " << e.totalTime;
+            out << ", avg " << e.totalTime/e.nbQueries;
+            out << ", max " << e.maxTime << std::endl;
+            out << "   hard asserts avg " << e.totalHard/e.nbQueries;
+            out << ", max " << e.maxHard << std::endl;
+            out << "   soft asserts avg " << e.totalSoft/e.nbQueries;
+            out << ", max " << e.maxSoft << std::endl;
+            out << "   variables    avg " << e.totalVars/e.nbQueries;
+            out << ", max " << e.maxVars << std::endl;
+            // Histogram (bars scaled to 40 characters)
+            unsigned long maxCount = 0;
+            for (unsigned b=0; b<NbBuckets; b++) {
+                if (e.histogram[b]>maxCount) maxCount = e.histogram[b];
+            }
+            for (unsigned b=0; b<NbBuckets; b++) {
+                out << "   " << std::setw(8) << bucketNames[b] << " |";
+                unsigned len = (e.histogram[b]*40+maxCount-1)/maxCount;
+                out << std::string(len, '#');
+                out << " " << e.histogram[b] << std::endl;
+            }
+        }
+    }
+    out << std::endl;
+    out.flags(flags);
+}
+
+bool SolverStats::exportJSON(std::string filename) {
+    std::ofstream out(filename.c_str());
+    if (!out.is_open()) {
+        return false;
+    }
+    out << "{\n  \"buckets\": [";
+    for (unsigned b=0; b<NbBuckets; b++) {
+        out << (b ? ", " : "") << "\"" << bucketNames[b] << "\"";
+    }
+    out << "],\n  \"phases\": [";
+    bool first = true;
+    for (unsigned p=0; p<NbPhases; p++) {
+        for (unsigned k=0; k<2; k++) {
+            const Entry &e = entries[p][k];
+            if (e.nbQueries==0) {
+                continue;
+            }
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "    {\"phase\": \"" << getPhaseName(p) << "\", ";
+            out << "\"query\": \"" << (k==0 ? "check" : "maxsat") << "\", ";
+            out << "\"queries\": " << e.nbQueries << ", ";
+            out << "\"sat\": " << e.nbResults[2] << ", ";
+            out << "\"unsat\": " << e.nbResults[0] << ", ";
+            out << "\"unknown\": " << e.nbResults[1] << ",\n";
+            out << "     \"time_ms\": " << e.totalTime << ", ";
+            out << "\"max_time_ms\": " << e.maxTime << ", ";
+            out << "\"hard\": " << e.totalHard << ", ";
+            out << "\"max_hard\": " << e.maxHard << ", ";
+            out << "\"soft\": " << e.totalSoft << ", ";
+            out << "\"max_soft\": " << e.maxSoft << ", ";
+            out << "\"vars\": " << e.totalVars << ", ";
+            out << "\"max_vars\": " << e.maxVars << ",\n";
+            out << "     \"histogram\": [";
+            for (unsigned b=0; b<NbBuckets; b++) {
+                out << (b ? ", " : "") << e.histogram[b];
+            }
+            out << "]}";
+        }
+    }
+    out << "\n  ]\n}\n";
+    return true;
+}
+
+void SolverStats::reset() {
+    for (unsigned p=0; p<NbPhases; p++) {
+        for (unsigned k=0; k<2; k++) {
+            entries[p][k] = Entry();
+        }
+    }
+    phase = OTHER;
+}
+
+void SolverStats::save(std::string &buf) {
+    buf.append((const char*) entries, sizeof(entries));
+}
+
+bool SolverStats::merge(const std::string &buf, size_t &pos) {
+    if (pos+sizeof(entries)>buf.size()) {
+        return false;
+    }
+    Entry saved[NbPhases][2];
+    buf.copy((char*) saved, sizeof(saved), pos);
+    pos += sizeof(saved);
+    for (unsigned p=0; p<NbPhases; p++) {
+        for (unsigned k=0; k<2; k++) {
+            Entry &e = entries[p][k];
+            const Entry &s = saved[p][k];
+            e.nbQueries += s.nbQueries;
+            for (unsigned r=0; r<3; r++) {
+                e.nbResults[r] += s.nbResults[r];
+            }
+            e.totalTime += s.totalTime;
+            if (s.maxTime>e.maxTime) e.maxTime = s.maxTime;
+            e.totalHard += s.totalHard;
+            e.totalSoft += s.totalSoft;
+            e.totalVars += s.totalVars;
+            if (s.maxHard>e.maxHard) e.maxHard = s.maxHard;
+            if (s.maxSoft>e.maxSoft) e.maxSoft = s.maxSoft;
+            if (s.maxVars>e.maxVars) e.maxVars = s.maxVars;
+            for (unsigned b=0; b<NbBuckets; b++) {
+                e.histogram[b] += s.histogram[b];
+            }
+        }
+    }
+    return true;
+}
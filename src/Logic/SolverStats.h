@@ -0,0 +1,197 @@
+/**
+ * \file SolverStats.h
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#ifndef _SOLVERSTATS_H
+#define _SOLVERSTATS_H
+
+#include <cassert>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+
+/**
+ * \class SolverStats
+ *
+ * \brief Telemetry of the solver queries.
+ *
+ * Each check and maxSat call of a solver backend is recorded 
+ * with its wall time, the number of hard and soft assertions 
+ * in the context, the number of declared variables and its 
+ * result. The records are aggregated per phase of SNIPER 
+ * (see Phase), which is set by the caller before solving.
+ *
+ * The statistics can be printed as a histogram report 
+ * (see printReport) or exported in a JSON file (see exportJSON).
+ */
+class SolverStats {
+
+public:
+    /**
+     * Phases of SNIPER in which the solvers are called.
+     */
+    enum Phase {
+        BMC,        /*!< Bounded model checking */
+        CONCOLIC,   /*!< Concolic execution (path constraints) */
+        MCS,        /*!< MCS enumeration */
+        HITTINGSET, /*!< Minimal hitting sets */
+        OTHER,      /*!< Default phase */
+        NbPhases
+    };
+    /**
+     * Number of buckets of the latency histograms: 
+     * <0.01ms, <0.1ms, <1ms, <10ms, <100ms, <1s, <10s and >=10s.
+     */
+    static const unsigned NbBuckets = 8;
+
+private:
+    /**
+     * Aggregated records of a phase and a kind of query.
+     */
+    struct Entry {
+        unsigned long nbQueries;
+        /**
+         * Number of queries per result (False, Undef, True, see
+         * SolverBackend::Result).
+         */
+        unsigned long nbResults[3];
+        double totalTime;
+        double maxTime;
+        unsigned long totalHard, totalSoft, totalVars;
+        unsigned maxHard, maxSoft, maxVars;
+        unsigned long histogram[NbBuckets];
+    };
+    /**
+     * Records of check (index 0) and maxSat (index 1) queries,
+     * for each phase.
+     */
+    static Entry entries[NbPhases][2];
+    /**
+     * Current phase.
+     */
+    static unsigned phase;
+
+public:
+    /**
+     * \brief Set the current phase and return the previous one.
+     */
+    static unsigned setPhase(unsigned p) {
+        assert(p<NbPhases && "Unknown phase!");
+        unsigned old = phase;
+        phase = p;
+        return old;
+    }
+    
+    /**
+     * \brief Return the current phase.
+     */
+    static unsigned getPhase() {
+        return phase;
+    }
+    
+    /**
+     * \brief Return the wall-clock time (ms).
+     */
+    static double getTime() {
+        struct timeval t;
+        gettimeofday(&t, NULL);
+        return t.tv_sec*1000.0 + t.tv_usec/1000.0;
+    }
+    
+    /**
+     * \brief Record a query in the current phase.
+     *
+     * \param isMaxSat True for a maxSat query, false for a check.
+     * \param ms Wall time of the query (ms).
+     * \param nbHard Number of hard assertions in the context.
+     * \param nbSoft Number of soft assertions in the context.
+     * \param nbVars Number of declared variables.
+     * \param result True, False or Undef (see SolverBackend::Result).
+     */
+    static void record(bool isMaxSat, double ms, unsigned nbHard,
+                       unsigned nbSoft, unsigned nbVars, int result);
+    
+    /**
+     * \brief Return the number of queries recorded in phase \p p.
+     */
+    static unsigned long getNbQueries(unsigned p);
+    
+    /**
+     * \brief Return the number of queries of phase \p p
+     *        with the given result.
+     */
+    static unsigned long getNbResults(unsigned p, int result);
+    
+    /**
+     * \brief Print the statistics of each phase, with
+     *        the latency histograms.
+     */
+    static void printReport(std::ostream &out);
+    
+    /**
+     * \brief Export the statistics in the JSON file \p filename.
+     *
+     * \return false if the file can not be written.
+     */
+    static bool exportJSON(std::string filename);
+    
+    /**
+     * \brief Reset the statistics and the phase.
+     */
+    static void reset();
+    
+    /**
+     * \brief Append the statistics to \p buf, e.g. to send them
+     *        from a worker process to its parent (see merge).
+     */
+    static void save(std::string &buf);
+    
+    /**
+     * \brief Add the statistics saved at position \p pos of \p buf
+     *        to the current ones, and move \p pos after them.
+     *
+     * \return false if \p buf is too short.
+     */
+    static bool merge(const std::string &buf, size_t &pos);
+    
+    /**
+     * \brief Return the name of phase \p p.
+     */
+    static std::string getPhaseName(unsigned p);
+
+private:
+    /**
+     * \brief Return the histogram bucket of a query of \p ms ms.
+     */
+    static unsigned getBucket(double ms);
+
+};
+
+#endif // _SOLVERSTATS_H
@@ -75,13 +75,31 @@ void YicesSolver::init() {
 
 void YicesSolver::addToContext(ExprPtr e) {
     assert(ctx && "Context is null!");
+    retractPending();
+    if (QueryRecorder::isEnabled()) {
+        recordedExprs.push_back(std::make_pair(e, e->isSoft()));
+    }
     yices_expr expr = makeYicesExpression(e);
     if (e->isHard()) {
         // Hard assert
         yices_assert(ctx, expr);
+        nbHardAsserts++;
+        return;
+    }
+    nbSoftAsserts++;
+    if (maxSatAlgorithm==CORE) {
+        // Soft assert: (or (not b) e) with the selector b
+        yices_expr b = yices_mk_fresh_bool_var(ctx);
+        yices_expr args[2];
+        args[0] = yices_mk_not(ctx, b);
+        args[1] = expr;
+        yices_assert(ctx, yices_mk_or(ctx, args, 2));
+        softExprs.push_back(e);
+        softYExprs.push_back(expr);
+        softSels.push_back(b);
     } else {
         // Soft assert
-        assertion_id i = yices_assert_weighted(ctx, expr, 1);
+        assertion_id i = yices_assert_weighted(ctx, expr, e->getWeight());
         expr2ids[e]    = i;
         expr2yexpr[e]  = expr;
     }
@@ -95,12 +113,70 @@ void YicesSolver::addToContext(Formula *f) {
     }
 }
 
+SolverBackend::AssertionID YicesSolver::addRetractable(ExprPtr e) {
+    assert(ctx && "Context is null!");
+    retractPending();
+    yices_expr expr = makeYicesExpression(e);
+    nbHardAsserts++;
+    assertion_id i = yices_assert_retractable(ctx, expr);
+    if (QueryRecorder::isEnabled()) {
+        recordedRetractables[i] = recordedExprs.size();
+        recordedExprs.push_back(std::make_pair(e, false));
+    }
+    return i;
+}
+
+void YicesSolver::retract(AssertionID i) {
+    assert(ctx && "Context is null!");
+    retractPending();
+    yices_retract(ctx, i);
+    std::map<assertion_id, unsigned>::iterator it = recordedRetractables.find(i);
+    if (it!=recordedRetractables.end()) {
+        recordedExprs[it->second].first = NULL;
+        recordedRetractables.erase(it);
+    }
+}
+
+std::vector<SolverBackend::AssertionID> YicesSolver::getUnsatCore() {
+    assert(ctx && "Context is null!");
+    unsigned size = yices_get_unsat_core_size(ctx);
+    std::vector<assertion_id> core(size);
+    if (size>0) {
+        yices_get_unsat_core(ctx, &core[0]);
+    }
+    return core;
+}
+
+void YicesSolver::recordQuery(bool isMaxSat) {
+    std::vector<ExprPtr> hard, soft;
+    for (unsigned i=0; i<recordedExprs.size(); i++) {
+        ExprPtr e = recordedExprs[i].first;
+        if (e) {
+            (recordedExprs[i].second ? soft : hard).push_back(e);
+        }
+    }
+    if (QueryRecorder::record(isMaxSat, hard, soft).empty()) {
+        std::cerr << "warning: could not record the query.\n";
+    }
+}
+
 int YicesSolver::check() {
     assert(ctx && "Context is null!");
+    retractPending();
+    // The soft expressions are checked as hard ones
+    for (yices_expr b : softSels) {
+        pendingRetracts.push_back(yices_assert_retractable(ctx, b));
+    }
+    if (QueryRecorder::isEnabled()) {
+        recordQuery(false);
+    }
     // Solve the formula
+    double startTime = SolverStats::getTime();
     int val = yices_check(ctx);
     // Save the model
     model = yices_get_model(ctx);
+    SolverStats::record(false, SolverStats::getTime()-startTime,
+                        nbHardAsserts, nbSoftAsserts, nbVarDecls, val);
     return val;
 }
 
@@ -110,18 +186,26 @@ int YicesSolver::check(Formula *f) {
     // Construct and assert the Yices expression
     addToContext(f);
     // Solve the formula
-    int val = yices_check(ctx);
-    // Save the model
-    model = yices_get_model(ctx);
-    return val;
+    return check();
 }
 
 int YicesSolver::maxSat() {
     assert(ctx && "Context is null!");
-    // Solve the formula
-    int val = yices_max_sat(ctx);
-    // Save the model
-    model = yices_get_model(ctx);
+    if (QueryRecorder::isEnabled()) {
+        recordQuery(true);
+    }
+    double startTime = SolverStats::getTime();
+    int val;
+    if (maxSatAlgorithm==CORE) {
+        val = maxSatCoreGuided();
+    } else {
+        // Solve the formula
+        val = yices_max_sat(ctx);
+        // Save the model
+        model = yices_get_model(ctx);
+    }
+    SolverStats::record(true, SolverStats::getTime()-startTime,
+                        nbHardAsserts, nbSoftAsserts, nbVarDecls, val);
     return val;
 }
 
@@ -131,10 +215,134 @@ int YicesSolver::maxSat(Formula *f) {
     // Construct and assert the Yices expression
     addToContext(f);
     // Solve the formula
-    int val = yices_max_sat(ctx);
-    // Save the model
-    model = yices_get_model(ctx);
-    return val;
+    return maxSat();
+}
+
+int YicesSolver::maxSatCoreGuided() {
+    const unsigned n = softExprs.size();
+    // Current selector and relaxation variables of each soft expression
+    std::vector<yices_expr> sels(softSels);
+    std::vector<std::vector<yices_expr> > relaxs(n);
+    // Selector of the relaxation clauses of this call
+    yices_expr callSel = yices_mk_fresh_bool_var(ctx);
+    yices_expr notCallSel = yices_mk_not(ctx, callSel);
+    coreCost = 0;
+    for (;;) {
+        retractPending();
+        pendingRetracts.push_back(yices_assert_retractable(ctx, callSel));
+        std::map<assertion_id, unsigned> id2soft;
+        for (unsigned i=0; i<n; i++) {
+            assertion_id id = yices_assert_retractable(ctx, sels[i]);
+            pendingRetracts.push_back(id);
+            id2soft[id] = i;
+        }
+        int val = yices_check(ctx);
+        if (val!=l_false) {
+            // Keep the selectors until the context changes,
+            // the model refers to them
+            model = yices_get_model(ctx);
+            pendingDisables.push_back(callSel);
+            return val;
+        }
+        model = NULL;
+        // Relax the soft expressions of the core
+        std::vector<yices_expr> R;
+        unsigned size = yices_get_unsat_core_size(ctx);
+        std::vector<assertion_id> core(size);
+        if (size>0) {
+            yices_get_unsat_core(ctx, &core[0]);
+        }
+        for (assertion_id id : core) {
+            std::map<assertion_id, unsigned>::iterator it = id2soft.find(id);
+            if (it==id2soft.end()) {
+                continue;
+            }
+            const unsigned i = it->second;
+            yices_expr r = yices_mk_fresh_bool_var(ctx);
+            R.push_back(r);
+            relaxs[i].push_back(r);
+            // (or (not sel) (not b') e r1 ... rk)
+            sels[i] = yices_mk_fresh_bool_var(ctx);
+            std::vector<yices_expr> args;
+            args.push_back(notCallSel);
+            args.push_back(yices_mk_not(ctx, sels[i]));
+            args.push_back(softYExprs[i]);
+            args.insert(args.end(), relaxs[i].begin(), relaxs[i].end());
+            yices_assert(ctx, mkOr(args));
+        }
+        if (R.empty()) {
+            // The hard constraints are unsatisfiable
+            pendingDisables.push_back(callSel);
+            return l_false;
+        }
+        // Exactly one of the relaxation variables is true
+        std::vector<yices_expr> atLeastOne(R);
+        atLeastOne.push_back(notCallSel);
+        yices_assert(ctx, mkOr(atLeastOne));
+        assertAtMostOne(R, callSel);
+        coreCost++;
+    }
+}
+
+void YicesSolver::retractPending() {
+    for (assertion_id id : pendingRetracts) {
+        yices_retract(ctx, id);
+    }
+    pendingRetracts.clear();
+    // The guarded clauses are now satisfied
+    for (yices_expr s : pendingDisables) {
+        yices_assert(ctx, yices_mk_not(ctx, s));
+    }
+    pendingDisables.clear();
+}
+
+void YicesSolver::assertAtMostOne(std::vector<yices_expr> &lits,
+                                  yices_expr guard) {
+    const unsigned n = lits.size();
+    yices_expr args[3];
+    args[2] = yices_mk_not(ctx, guard);
+    if (n<=5) {
+        // Pairwise encoding
+        for (unsigned i=0; i<n; i++) {
+            for (unsigned j=i+1; j<n; j++) {
+                args[0] = yices_mk_not(ctx, lits[i]);
+                args[1] = yices_mk_not(ctx, lits[j]);
+                yices_assert(ctx, yices_mk_or(ctx, args, 3));
+            }
+        }
+        return;
+    }
+    // Sequential counter: s_i is true if one of lits[0..i] is true
+    yices_expr s = yices_mk_fresh_bool_var(ctx);
+    args[0] = yices_mk_not(ctx, lits[0]);
+    args[1] = s;
+    yices_assert(ctx, yices_mk_or(ctx, args, 3));
+    for (unsigned i=1; i<n; i++) {
+        // (not s_i-1) or (not l_i)
+        args[0] = yices_mk_not(ctx, s);
+        args[1] = yices_mk_not(ctx, lits[i]);
+        yices_assert(ctx, yices_mk_or(ctx, args, 3));
+        if (i+1==n) {
+            break;
+        }
+        yices_expr next = yices_mk_fresh_bool_var(ctx);
+        // l_i -> s_i and s_i-1 -> s_i
+        args[0] = yices_mk_not(ctx, lits[i]);
+        args[1] = next;
+        yices_assert(ctx, yices_mk_or(ctx, args, 3));
+        args[0] = yices_mk_not(ctx, s);
+        args[1] = next;
+        yices_assert(ctx, yices_mk_or(ctx, args, 3));
+        s = next;
+    }
+}
+
+yices_expr YicesSolver::mkOr(std::vector<yices_expr> &args) {
+    assert(!args.empty() && "empty OR expression!");
+    if (args.size()==1) {
+        return args.back();
+    }
+    return yices_mk_or(ctx, &args[0], args.size());
 }
 
 std::string YicesSolver::getModel() {
@@ -150,14 +358,20 @@ std::string YicesSolver::getModel() {
 
 double YicesSolver::getCostAsDouble() {
     assert(model && "Model is empty!");
+    if (maxSatAlgorithm==CORE) {
+        return coreCost;
+    }
     return yices_get_cost_as_double(model);
 }
 
 int YicesSolver::getValue(std::string name) { 
     assert(model && "Model is empty!");
     assert(ctx && "Context is null!");
-    yices_var_decl d = yices_get_var_decl_from_name(ctx, name.c_str());
-    assert(d!=0 && "yices_get_var_decl_from_name");
+    unsigned id = 0;
+    const bool found = Expression::lookupName(name, id);
+    assert(found && "getValue: unknown variable name");
+    yices_var_decl d = getVarDecl(id);
+    assert(d!=0 && "getValue: variable not declared");
     long value;
     int error = yices_get_int_value(model, d, &value);
     assert(error!=1 && "cannot extract value from model:\n" &&
@@ -172,12 +386,21 @@ int YicesSolver::getValue(std::string name) {
 }
 
 int YicesSolver::getValue(std::string name, bool &error) {
+    unsigned id = 0;
+    if (!Expression::lookupName(name, id)) {
+        error = true;
+        return 0;
+    }
+    return getValue(id, error);
+}
+
+int YicesSolver::getValue(unsigned nameID, bool &error) {
     assert(ctx && "Context is null!");
     if (model==NULL) {
         error = true;
         return 0;
     }
-    yices_var_decl d = yices_get_var_decl_from_name(ctx, name.c_str());
+    yices_var_decl d = getVarDecl(nameID);
     if (d!=0) {
         long value;
         int e = yices_get_int_value(model, d, &value);
@@ -191,11 +414,19 @@ int YicesSolver::getValue(std::string name, bool &error) {
 }
 
 int YicesSolver::getValueOrZero(std::string name) {
+    unsigned id = 0;
+    if (!Expression::lookupName(name, id)) {
+        return 0;
+    }
+    return getValueOrZero(id);
+}
+
+int YicesSolver::getValueOrZero(unsigned nameID) {
     assert(ctx && "Context is null!");
     if (model==NULL) {
         return 0;
     }
-    yices_var_decl d = yices_get_var_decl_from_name(ctx, name.c_str());
+    yices_var_decl d = getVarDecl(nameID);
     if (d!=0) {
         long value;
         int error = yices_get_int_value(model, d, &value);
@@ -207,16 +438,25 @@ int YicesSolver::getValueOrZero(std::string name) {
 }
 
 int YicesSolver::getBoolValue(std::string name) {
+    unsigned id = 0;
+    if (!Expression::lookupName(name, id)) {
+        std::cout << ">> " << name << std::endl;
+        std::cerr << "error: unknown variable name\n";
+        return -3;
+    }
+    return getBoolValue(id);
+}
+
+int YicesSolver::getBoolValue(unsigned nameID) {
     assert(model && "Model is empty!");
     assert(ctx && "Context is null!");
-    yices_var_decl d = 
-    yices_get_var_decl_from_name(ctx, name.c_str());
+    yices_var_decl d = getVarDecl(nameID);
     if (d!=0) { 
         lbool val = yices_get_value(model, d);
         return val;
     } else {
-        std::cout << ">> " << name << std::endl;
-        std::cerr << "error: yices_get_var_decl_from_name\n";
+        std::cout << ">> " << Expression::getInternedName(nameID) << std::endl;
+        std::cerr << "error: variable not declared\n";
         return -3;
     }
 }
@@ -224,6 +464,14 @@ int YicesSolver::getBoolValue(std::string name) {
 std::vector<ExprPtr> YicesSolver::getUnsatExpressions() {
     assert(model && "Model is empty!");
     std::vector<ExprPtr> unsatExprs;
+    if (maxSatAlgorithm==CORE) {
+        for (unsigned i=0; i<softExprs.size(); i++) {
+            if (yices_evaluate_in_model(model, softYExprs[i])==l_false) {
+                unsatExprs.push_back(softExprs[i]);
+            }
+        }
+        return unsatExprs;
+    }
     std::map<ExprPtr, assertion_id>::iterator it;
     for(it = expr2ids.begin(); it != expr2ids.end(); it++) {
         ExprPtr e = it->first;
@@ -237,9 +485,22 @@ std::vector<ExprPtr> YicesSolver::getUnsatExpressions() {
     return unsatExprs;
 }
 
+int YicesSolver::evaluate(ExprPtr e) {
+    assert(model && "Model is empty!");
+    return yices_evaluate_in_model(model, makeYicesExpression(e));
+}
+
 std::vector<ExprPtr> YicesSolver::getSatExpressions() {
     assert(model && "Model is empty!");
     std::vector<ExprPtr> satExprs;
+    if (maxSatAlgorithm==CORE) {
+        for (unsigned i=0; i<softExprs.size(); i++) {
+            if (yices_evaluate_in_model(model, softYExprs[i])!=l_false) {
+                satExprs.push_back(softExprs[i]);
+            }
+        }
+        return satExprs;
+    }
     std::map<ExprPtr, assertion_id>::iterator it;
     for(it = expr2ids.begin(); it != expr2ids.end(); it++) {
         ExprPtr e = it->first;
@@ -253,25 +514,168 @@ std::vector<ExprPtr> YicesSolver::getSatExpressions() {
     return satExprs;
 }
 
+std::vector<ExprPtr> YicesSolver::getSoftExpressions() {
+    if (maxSatAlgorithm==CORE) {
+        return softExprs;
+    }
+    std::vector<ExprPtr> softs;
+    std::map<ExprPtr, assertion_id>::iterator it;
+    for(it = expr2ids.begin(); it != expr2ids.end(); it++) {
+        softs.push_back(it->first);
+    }
+    return softs;
+}
+
+void YicesSolver::convertMaxSatAlgorithm(unsigned a) {
+    assert(ctx && "Context is null!");
+    if (a==maxSatAlgorithm) {
+        return;
+    }
+    retractPending();
+    if (a==CORE) {
+        // Weighted assertions -> (or (not b) e) with the selector b
+        std::map<ExprPtr, assertion_id>::iterator it;
+        for(it = expr2ids.begin(); it != expr2ids.end(); it++) {
+            yices_retract(ctx, it->second);
+            yices_expr expr = expr2yexpr[it->first];
+            yices_expr b = yices_mk_fresh_bool_var(ctx);
+            yices_expr args[2];
+            args[0] = yices_mk_not(ctx, b);
+            args[1] = expr;
+            yices_assert(ctx, yices_mk_or(ctx, args, 2));
+            softExprs.push_back(it->first);
+            softYExprs.push_back(expr);
+            softSels.push_back(b);
+        }
+        expr2ids.clear();
+        expr2yexpr.clear();
+    } else {
+        // Selectors are left free: (or (not b) e) is always satisfiable
+        for (unsigned i=0; i<softExprs.size(); i++) {
+            assertion_id id = yices_assert_weighted(ctx, softYExprs[i], 
+                                                    softExprs[i]->getWeight());
+            expr2ids[softExprs[i]]   = id;
+            expr2yexpr[softExprs[i]] = softYExprs[i];
+        }
+        softExprs.clear();
+        softYExprs.clear();
+        softSels.clear();
+    }
+    maxSatAlgorithm = a;
+}
+
 void YicesSolver::push() {
+    retractPending();
+    softMarks.push_back(softExprs.size());
+    assertMarks.push_back(std::make_pair(nbHardAsserts, nbSoftAsserts));
+    recordMarks.push_back(recordedExprs.size());
     yices_push(ctx);
+    exprCacheMarks.push_back(exprCacheTrail.size());
 }
 
 void YicesSolver::pop() {
+    retractPending();
     yices_pop(ctx);
+    // Forget the soft expressions asserted since the matching push
+    assert(!softMarks.empty() && "pop without push!");
+    softExprs.resize(softMarks.back());
+    softYExprs.resize(softMarks.back());
+    softSels.resize(softMarks.back());
+    softMarks.pop_back();
+    nbHardAsserts = assertMarks.back().first;
+    nbSoftAsserts = assertMarks.back().second;
+    assertMarks.pop_back();
+    // Forget the recorded expressions asserted since the matching push
+    recordedExprs.resize(recordMarks.back());
+    recordMarks.pop_back();
+    std::map<assertion_id, unsigned>::iterator it = recordedRetractables.begin();
+    while (it!=recordedRetractables.end()) {
+        if (it->second>=recordedExprs.size()) {
+            recordedRetractables.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    // Forget the translations made since the matching push
+    assert(!exprCacheMarks.empty() && "pop without push!");
+    unsigned mark = exprCacheMarks.back();
+    exprCacheMarks.pop_back();
+    while (exprCacheTrail.size()>mark) {
+        exprCache.erase(exprCacheTrail.back());
+        exprCacheTrail.pop_back();
+    }
 }
 
 void YicesSolver::clean() {
     model = NULL;
     expr2ids.clear();
     expr2yexpr.clear();
+    exprCache.clear();
+    exprCacheTrail.clear();
+    exprCacheMarks.clear();
+    varDecls.clear();
+    softExprs.clear();
+    softYExprs.clear();
+    softSels.clear();
+    softMarks.clear();
+    pendingRetracts.clear();
+    pendingDisables.clear();
+    coreCost = 0;
+    nbHardAsserts = 0;
+    nbSoftAsserts = 0;
+    assertMarks.clear();
+    nbVarDecls = 0;
+    recordedExprs.clear();
+    recordedRetractables.clear();
+    recordMarks.clear();
     if (ctx!=0) {
         yices_del_context(ctx);
     }
     ctx = 0;
 }
 
+yices_var_decl YicesSolver::getOrMkVarDecl(SingleExprPtr v, yices_type ty) {
+    assert(ctx && "Context is null!");
+    const unsigned id = v->getNameID();
+    yices_var_decl d = getVarDecl(id);
+    if (d!=0) {
+        return d;
+    }
+    // Not in the table: the variable may still be known by the 
+    // context (e.g. declared by a parsed expression)
+    const char *name = Expression::getInternedName(id).c_str();
+    d = yices_get_var_decl_from_name(ctx, name);
+    if (d==0) {
+        if (ty==NULL) {
+            d = yices_mk_bool_var_decl(ctx, name);
+        } else {
+            d = yices_mk_var_decl(ctx, name, ty);
+        }
+    }
+    if (id>=varDecls.size()) {
+        varDecls.resize(Expression::getNbInternedNames(), 0);
+    }
+    varDecls[id] = d;
+    nbVarDecls++;
+    return d;
+}
+
 yices_expr YicesSolver::makeYicesExpression(ExprPtr e) {
+    assert(ctx && "Context is null!");
+    const unsigned id = e->getID();
+    auto it = exprCache.find(id);
+    if (it!=exprCache.end()) {
+        nbCacheHits++;
+        return it->second;
+    }
+    nbCacheMisses++;
+    yices_expr ye = translate(e);
+    exprCache[id] = ye;
+    exprCacheTrail.push_back(id);
+    return ye;
+}
+
+yices_expr YicesSolver::translate(ExprPtr e) {
     assert(ctx && "Context is null!");
     switch (e->getOpCode()) {
         case Expression::True:
@@ -288,33 +692,18 @@ yices_expr YicesSolver::makeYicesExpression(ExprPtr e) {
         }
         case Expression::BoolVar: {
             BoolVarExprPtr be = std::static_pointer_cast<BoolVarExpression>(e);
-            // Check if the varibale has already been created
-            yices_var_decl d = 
-            yices_get_var_decl_from_name(ctx, be->getName().c_str());
-            if (d==0) {
-                d = yices_mk_bool_var_decl(ctx, be->getName().c_str());	
-            }
+            yices_var_decl d = getOrMkVarDecl(be, NULL);
             return yices_mk_bool_var_from_decl(ctx, d);
         }
         case Expression::IntVar: {
             IntVarExprPtr ie = std::static_pointer_cast<IntVarExpression>(e);
-            // Check if the varibale has already been created
-            yices_var_decl d = 
-            yices_get_var_decl_from_name(ctx, ie->getName().c_str());
-            if (d==0) {
-                d = yices_mk_var_decl(ctx, ie->getName().c_str(), int32_ty);
-            }
+            yices_var_decl d = getOrMkVarDecl(ie, int32_ty);
             return yices_mk_var_from_decl(ctx, d);
         }
         case Expression::IntToIntVar: {
             IntToIntVarExprPtr ie =
             std::static_pointer_cast<IntToIntVarExpression>(e);
-            // Check if the varibale has already been created
-            yices_var_decl d = 
-            yices_get_var_decl_from_name(ctx, ie->getName().c_str()); 	
-            if (d==0) {
-                d = yices_mk_var_decl(ctx, ie->getName().c_str(), int32toint32_ty);
-            }
+            yices_var_decl d = getOrMkVarDecl(ie, int32toint32_ty);
             return yices_mk_var_from_decl(ctx, d);
         }
         case Expression::ToParse: {
@@ -31,6 +31,7 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <fstream>
 #include <sstream>
 
@@ -38,6 +39,9 @@
 
 #include "Expression.h"
 #include "Formula.h"
+#include "SolverBackend.h"
+#include "SolverStats.h"
+#include "QueryRecorder.h"
 
 /** 
  * \class YicesSolver
@@ -45,10 +49,11 @@
  * \brief Warper class for the Yices-1 SMT solver C API.
  *
  * This warper class provides access to the
- * basic Yices 1 functionalities.
+ * basic Yices 1 functionalities. It implements the
+ * SolverBackend interface.
  */
-class YicesSolver {
-        
+class YicesSolver : public SolverBackend {
+
 private:
     /**
      * Logical context
@@ -89,16 +94,118 @@ private:
      * Map of SNIPER expressions to their yices expressions.
      */
     std::map<ExprPtr, yices_expr> expr2yexpr;
-    
+    /**
+     * Translation cache: map of SNIPER expression IDs to their
+     * yices expressions.
+     *
+     * Every node translated by makeYicesExpression is memoized here,
+     * so that sub-expressions shared between clauses are translated
+     * only once per logical context.
+     */
+    std::unordered_map<unsigned, yices_expr> exprCache;
+    /**
+     * IDs of the cached expressions, in insertion order.
+     */
+    std::vector<unsigned> exprCacheTrail;
+    /**
+     * Size of the cache trail at each backtracking point (see push).
+     */
+    std::vector<unsigned> exprCacheMarks;
+    /**
+     * Variable declaration table, indexed by the name ID of the
+     * variables (see Expression::internName).
+     *
+     * A null entry means that the variable is not declared.
+     * Yices declarations are not undone by pop, so the table
+     * is only cleared by clean().
+     */
+    std::vector<yices_var_decl> varDecls;
+    /**
+     * Max-sat algorithm used by maxSat (see MaxSatAlgorithm).
+     */
+    unsigned maxSatAlgorithm;
+    /**
+     * Soft expressions in core-guided mode. Each soft expression 
+     * e is asserted as the hard clause (or (not b) e), where the 
+     * selector b is assumed while solving.
+     */
+    std::vector<ExprPtr> softExprs;
+    /**
+     * Yices expressions of the soft expressions (core-guided mode).
+     */
+    std::vector<yices_expr> softYExprs;
+    /**
+     * Selectors of the soft expressions (core-guided mode).
+     */
+    std::vector<yices_expr> softSels;
+    /**
+     * Number of soft expressions at each backtracking point 
+     * (core-guided mode).
+     */
+    std::vector<unsigned> softMarks;
+    /**
+     * Selectors assumed by the last check, to be retracted before
+     * the logical context is modified (the model stays valid 
+     * until then).
+     */
+    std::vector<assertion_id> pendingRetracts;
+    /**
+     * Selectors of the finished core-guided max-sat calls, disabled 
+     * for good with the pending retracts (the relaxation clauses of 
+     * a call are guarded by its selector).
+     */
+    std::vector<yices_expr> pendingDisables;
+    /**
+     * Cost of the last core-guided max-sat.
+     */
+    double coreCost;
+    /**
+     * Number of hard and soft assertions in the context 
+     * (see SolverStats).
+     */
+    unsigned nbHardAsserts, nbSoftAsserts;
+    /**
+     * Number of hard and soft assertions at each backtracking point.
+     */
+    std::vector<std::pair<unsigned, unsigned> > assertMarks;
+    /**
+     * Number of declared variables.
+     */
+    unsigned nbVarDecls;
+    /**
+     * Expressions of the logical context, kept only when the 
+     * queries are recorded (see QueryRecorder), with their
+     * soft property. Retracted expressions are set to NULL.
+     */
+    std::vector<std::pair<ExprPtr, bool> > recordedExprs;
+    /**
+     * Index in recordedExprs of the retractable expressions.
+     */
+    std::map<assertion_id, unsigned> recordedRetractables;
+    /**
+     * Size of recordedExprs at each backtracking point.
+     */
+    std::vector<unsigned> recordMarks;
+    /**
+     * Number of translations answered by the cache.
+     */
+    unsigned nbCacheHits;
+    /**
+     * Number of translations not answered by the cache.
+     */
+    unsigned nbCacheMisses;
+
 public:
     /**
      * Default constructor.
      */
-    YicesSolver() : ctx(0), model(NULL) { }
+    YicesSolver() : ctx(0), model(NULL), maxSatAlgorithm(NATIVE), coreCost(0),
+                    nbHardAsserts(0), nbSoftAsserts(0), nbVarDecls(0),
+                    nbCacheHits(0), nbCacheMisses(0) { }
     /**
      * Destructor.
      */
-    ~YicesSolver() { }
+    virtual ~YicesSolver() { }
     
     /**
      * \brief Initialize the solver.
@@ -106,21 +213,50 @@ public:
      * This function creates the logical context, types and operators.
      * This function should be call before calling check or maxSat.
      */
-    void init();
+    virtual void init();
     
     /**
      * \brief Assert an expression in the logical context.
      *
      * \param e An expression.
      */
-    void addToContext(ExprPtr e);
+    virtual void addToContext(ExprPtr e);
     
     /**
      * \brief Assert a formula in the logical context.
      *
      * \param e A formula.
      */
-    void addToContext(Formula *f);
+    virtual void addToContext(Formula *f);
+    
+    /**
+     * \brief Assert an expression in the logical context so that
+     *        it can be retracted later (see retract).
+     *
+     * The expression is treated as hard by check and maxSat
+     * until it is retracted. Together with a boolean selector 
+     * variable, this emulates solving under assumptions.
+     *
+     * \param e An expression.
+     * \return the assertion ID to be given to retract.
+     */
+    virtual AssertionID addRetractable(ExprPtr e);
+    
+    /**
+     * \brief Retract an assertion made with addRetractable.
+     *
+     * \param i An assertion ID returned by addRetractable.
+     */
+    virtual void retract(AssertionID i);
+    
+    /**
+     * \brief Return the retractable assertions of an unsatisfiable
+     *        core of the last check (see addRetractable).
+     *
+     * This should be only called if the last check returned l_false,
+     * and before the context is changed.
+     */
+    virtual std::vector<AssertionID> getUnsatCore();
     
     /**
      * \brief Check if the logical context is satisfiable.
@@ -134,7 +270,7 @@ public:
      *         l_undef if it was not possible to decide
      *         due to an incompletness.
      */
-    int check();
+    virtual int check();
     
     /**
      * \brief Check if the logical context is satisfiable.
@@ -181,7 +317,7 @@ public:
      *         l_undef if it was not possible to decide because
      *         of an incompleteness.
      */
-    int maxSat();
+    virtual int maxSat();
     
     /**
      * \brief Return a model for a satisfiable logical context.
@@ -193,7 +329,7 @@ public:
      * \return an empty string if a model is not available, or
      *         a string representating a model.
      */
-    std::string getModel();
+    virtual std::string getModel();
     
     /**
      * \brief Return the cost of the current model, converted
@@ -203,7 +339,7 @@ public:
      *
      * \return a cost
      */
-    double getCostAsDouble();
+    virtual double getCostAsDouble();
     
     /**
      * \brief Get the integer value assigned to variable v in the current model.
@@ -236,7 +372,7 @@ public:
      *           if the variable has a value that cannot be converted to long,
      *           because it is rational or too big.
      */
-    int getValue(std::string name, bool &error);
+    virtual int getValue(std::string name, bool &error);
     
     /**
      * \brief Get the integer value assigned to variable v in the current model.
@@ -257,6 +393,30 @@ public:
      */
     int getValueOrZero(std::string name);
     
+    /**
+     * \brief Get the integer value assigned to variable v in the current model.
+     *
+     * Same as getValue(std::string, bool&), but the variable is 
+     * identified by its name ID (see Expression::internName).
+     *
+     * \param nameID The name ID of an integer variable.
+     * \param error A reference to a boolean variable to check for errors after
+     *        the function has returned.
+     * \return the value of the variable, or 0 in case of errors.
+     */
+    virtual int getValue(unsigned nameID, bool &error);
+    
+    /**
+     * \brief Get the integer value assigned to variable v in the current model.
+     *
+     * Same as getValueOrZero(std::string), but the variable is 
+     * identified by its name ID (see Expression::internName).
+     *
+     * \param nameID The name ID of an integer variable.
+     * \return the value of the variable, or 0 in case of errors.
+     */
+    int getValueOrZero(unsigned nameID);
+    
     /**
      * \brief Get the boolean value assigned to variable v in the current model.
      *
@@ -267,7 +427,29 @@ public:
      * \return the value of the variable, or
      *         -3 if the variable was not declared.
      */
-    int getBoolValue(std::string name);
+    virtual int getBoolValue(std::string name);
+    
+    /**
+     * \brief Get the boolean value assigned to variable v in the current model.
+     *
+     * Same as getBoolValue(std::string), but the variable is 
+     * identified by its name ID (see Expression::internName).
+     *
+     * \param nameID The name ID of a boolean variable.
+     * \return the value of the variable, or
+     *         -3 if the variable was not declared.
+     */
+    virtual int getBoolValue(unsigned nameID);
+    
+    /**
+     * \brief Return the value of the boolean expression \p e 
+     *        in the current model.
+     *
+     * This should be only called when a valid model is available.
+     *
+     * \return l_true, l_false or l_undef (value not fixed by the model).
+     */
+    virtual int evaluate(ExprPtr e);
     
     /**
      * \brief Return the expressions that are not satisfied in the current model.
@@ -276,7 +458,7 @@ public:
      *
      * \return a vector of expressions
      */
-    std::vector<ExprPtr> getUnsatExpressions();
+    virtual std::vector<ExprPtr> getUnsatExpressions();
     
     /**
      * \brief Return the expressions that are satisfied in the current model.
@@ -285,7 +467,7 @@ public:
      *
      * \return a vector of expressions
      */
-    std::vector<ExprPtr> getSatExpressions();
+    virtual std::vector<ExprPtr> getSatExpressions();
     
     /**
      * \brief Create a backtracking point.
@@ -294,7 +476,7 @@ public:
      * The scope level is the number of elements on this stack.
      * The stack of contexts is simulated using trail (undo) stacks.
      */
-    void push();
+    virtual void push();
     
     /**
      * \brief Backtrack.
@@ -305,27 +487,181 @@ public:
      * and the context is completely restored to what it was right
      * before the push().
      */
-    void pop();
+    virtual void pop();
     
     /**
      * \brief Clean the solver state.
      *
      * This function deletes the logical context and the current model.
      */
-    void clean();
+    virtual void clean();
+    
+    /**
+     * \brief Select the algorithm used by maxSat.
+     *
+     * The algorithm has to be selected before any soft 
+     * expression is asserted.
+     *
+     * \param a NATIVE (Yices built-in max-sat, default) or CORE.
+     */
+    virtual void setMaxSatAlgorithm(unsigned a) {
+        assert(expr2ids.empty() && softExprs.empty()
+               && "Soft expressions already asserted!");
+        maxSatAlgorithm = a;
+    }
+    
+    /**
+     * \brief Return the algorithm used by maxSat.
+     */
+    virtual unsigned getMaxSatAlgorithm() {
+        return maxSatAlgorithm;
+    }
+    
+    /**
+     * \brief Return the number of expression translations that
+     *        were answered by the translation cache.
+     */
+    virtual unsigned getNbCacheHits() {
+        return nbCacheHits;
+    }
+    
+    /**
+     * \brief Return the number of expression translations that
+     *        were not answered by the translation cache.
+     */
+    virtual unsigned getNbCacheMisses() {
+        return nbCacheMisses;
+    }
+    
+    /**
+     * \brief Return the number of hard assertions in the context.
+     */
+    virtual unsigned getNbHardAsserts() {
+        return nbHardAsserts;
+    }
+    
+    /**
+     * \brief Return the number of soft assertions in the context.
+     */
+    virtual unsigned getNbSoftAsserts() {
+        return nbSoftAsserts;
+    }
+    
+    /**
+     * \brief Return the number of declared variables.
+     */
+    virtual unsigned getNbVarDecls() {
+        return nbVarDecls;
+    }
+    
+    /**
+     * \brief Return the soft expressions of the context, 
+     *        in a deterministic order.
+     */
+    virtual std::vector<ExprPtr> getSoftExpressions();
     
+    /**
+     * \brief Switch the max-sat algorithm of a context in which 
+     *        soft expressions are already asserted.
+     *
+     * The soft expressions are re-asserted with the encoding of 
+     * the algorithm \p a. This function is meant for the worker
+     * processes of the portfolio (see PortfolioSolver): the 
+     * backtracking points are not updated, so pop must not be 
+     * called afterwards.
+     *
+     * \param a NATIVE or CORE.
+     */
+    virtual void convertMaxSatAlgorithm(unsigned a);
+
 private:
     /**
      * \brief Return a yices expression representing the SNIPER expression
-     *        given as argument given arguments.
+     *        given as argument.
      *
-     * This function deletes the logical context and the current model.
+     * The translation is looked up in the translation cache first
+     * and is only computed (see translate) on a cache miss.
      *
      * \param e A SNIPER expression
      * \return a yices expression
      */
     yices_expr makeYicesExpression(ExprPtr e);
-      
+    
+    /**
+     * \brief Translate the root node of the SNIPER expression \p e
+     *        into a yices expression.
+     *
+     * Sub-expressions are translated with makeYicesExpression.
+     *
+     * \param e A SNIPER expression
+     * \return a yices expression
+     */
+    yices_expr translate(ExprPtr e);
+    
+    /**
+     * \brief Return the declaration of the variable with the 
+     *        name ID \p nameID, or null if it is not declared.
+     *
+     * \param nameID A name ID (see Expression::internName).
+     * \return a yices variable declaration
+     */
+    yices_var_decl getVarDecl(unsigned nameID) {
+        if (nameID<varDecls.size()) {
+            return varDecls[nameID];
+        }
+        return 0;
+    }
+    
+    /**
+     * \brief Return the declaration of the variable \p v,
+     *        declaring it with type \p ty if needed.
+     *
+     * \param v A variable expression.
+     * \param ty The type of the variable, or null for a boolean variable.
+     * \return a yices variable declaration
+     */
+    yices_var_decl getOrMkVarDecl(SingleExprPtr v, yices_type ty);
+    
+    /**
+     * \brief Core-guided max-sat (Fu-Malik).
+     *
+     * The soft expressions are assumed through their selectors 
+     * and the context is checked. While it is unsatisfiable, the 
+     * soft expressions of the unsat core are relaxed with fresh
+     * variables, exactly one of which can be true, and the cost 
+     * is increased by one. The weights of the soft expressions 
+     * are ignored (unit weights). The relaxation clauses are guarded
+     * by a selector of the call, which is disabled once the call is 
+     * finished, so that the context does not grow from one call to 
+     * the next.
+     *
+     * \return l_true, l_false or l_undef (as maxSat).
+     */
+    int maxSatCoreGuided();
+    
+    /**
+     * \brief Retract the selectors assumed by the last check,
+     *        and disable the selectors of the finished calls.
+     */
+    void retractPending();
+    
+    /**
+     * \brief Record the current query (see QueryRecorder).
+     */
+    void recordQuery(bool isMaxSat);
+    
+    /**
+     * \brief Assert that at most one of \p lits is true
+     *        (pairwise or sequential counter encoding), 
+     *        if \p guard is true.
+     */
+    void assertAtMostOne(std::vector<yices_expr> &lits, yices_expr guard);
+    
+    /**
+     * \brief Return the expression (or \p args).
+     */
+    yices_expr mkOr(std::vector<yices_expr> &args);
+
 }; 
 
 #endif // _YICESSOLVER_H
@@ -26,6 +26,7 @@
  */
 
 #include "Options.h"
+#include "Logic/SolverBackend.h"
 
 /*==== Global options ====*/
 
@@ -67,6 +68,21 @@ PrintMUS("print-mus", cl::desc("Print the MUSes"));
 static cl::opt <bool>
 PrintMCS("print-mcs", cl::desc("Print the MCSes (before combination)"));
 
+static cl::opt <bool>
+PrintSolverStats("solver-stats", cl::desc("Print the solver statistics (latency histograms)"));
+
+static cl::opt <std::string>
+SolverStatsFileName("solver-stats-file", cl::desc("Export the solver statistics in a JSON file"),
+                    cl::init(""), cl::value_desc("filename"));
+
+static cl::opt <std::string>
+RecordQueriesDir("record-queries", cl::desc("Record the solver queries as SMT-LIB2 files in the given directory"),
+                 cl::init(""), cl::value_desc("directory"));
+
+static cl::opt <std::string>
+JSONStreamFileName("json-stream", cl::desc("Stream the MCSes and diagnoses as JSON lines in the given file (- for the standard output)"),
+                   cl::init(""), cl::value_desc("filename"));
+
 static cl::opt <bool> 
 DbgMsg("dbg-msg", cl::desc("Print debug messages"));
 
@@ -142,9 +158,62 @@ static cl::opt <unsigned>
 MCSMaxSize("max-mcs-size", cl::desc("Maximum size of MCSes"),
               cl::init(UINT_MAX), cl::value_desc("MCSMaxSize"));
 
+static cl::opt <unsigned>
+MaxNbDiagnoses("max-diagnoses", cl::desc("Maximum number of diagnoses (MCSes) enumerated for each failing trace, smallest first (by stratum with -coverage-weights) (0 = all)"),
+               cl::init(0), cl::value_desc("k"));
+
+static cl::opt <unsigned>
+NbWeightLevels("coverage-weights", cl::desc("Weight the soft constraints with N levels from the suspiciousness of their block (coverage of the failing and passing runs), and enumerate the MCSes by strata, most suspicious first (0 = unit weights)"),
+               cl::init(0), cl::value_desc("N"));
+
+static cl::opt <bool>
+SlicePaths("path-slicing", cl::desc("Restrict the trace formula to the executed path of each failing trace before the MCS enumeration (needs the executed blocks of the traces)"));
+
+static cl::opt <bool>
+ConeOfInfluence("coi", cl::desc("Remove the constraints of the trace formula that are not in the cone of influence of the post-conditions and of the error-inducing inputs"));
+
+static cl::opt <bool>
+ReuseMCSes("reuse-mcs", cl::desc("Validate the MCSes of the previous failing traces before the enumeration of the MCSes of a trace (not with -max-diagnoses)"));
+
+static cl::opt <bool>
+Preprocess("preprocess", cl::desc("Simplify the trace formula before the MCS enumeration (substitution of the hard definitions, propagation of the input values common to all the failing traces)"));
+
 static cl::opt <bool>
 OutputCFGDotFile("cfg-dot", cl::desc("Output the CFG in a dot file."));
 
+static cl::opt <unsigned>
+NbPortfolioWorkers("portfolio", cl::desc("Number of max-sat portfolio workers (processes) racing in the MCS enumeration"),
+                   cl::init(0), cl::value_desc("N"));
+
+static cl::opt <bool>
+NoCexCache("no-cex-cache", cl::desc("Disable the counterexample cache of the concolic solver queries"));
+
+static cl::opt <bool>
+NoIndependence("no-independence", cl::desc("Disable the constraint-independence slicing of the concolic path conditions"));
+
+static cl::opt <unsigned>
+NbJobs("jobs", cl::desc("Number of worker processes diagnosing the failing traces in parallel (and of threads combining their MCSes by PWU)"),
+       cl::init(1), cl::value_desc("N"));
+
+static cl::opt <unsigned>
+NbTraceRepresentatives("trace-reps", cl::desc("Number of failing traces diagnosed per executed path (0 to diagnose all the failing traces)"),
+                       cl::init(0), cl::value_desc("N"));
+
+static cl::opt <unsigned>
+SolverTimeout("solver-timeout", cl::desc("Wall time budget of each solver query (max-sat or check) of the MCS enumeration and MUS extraction, in ms (0 for none)"),
+              cl::init(0), cl::value_desc("ms"));
+
+static cl::opt <unsigned>
+TraceTimeout("trace-timeout", cl::desc("Wall time budget of the MCS enumeration (and of the MUS extraction) of each failing trace, in ms (0 for none)"),
+             cl::init(0), cl::value_desc("ms"));
+
+static cl::opt <unsigned>
+SolverMemoryLimit("solver-mem", cl::desc("Memory budget of each solver query (max-sat or check) of the MCS enumeration and MUS extraction, in MB (0 for none)"),
+                  cl::init(0), cl::value_desc("MB"));
+
+static cl::opt <bool>
+Incremental("incremental", cl::desc("Diagnose the failing traces incrementally (selector literals instead of push/pop)"));
+
 /**
  * \brief Diagnosis combination methods. 
  *
@@ -165,6 +234,42 @@ ChoosedCombineMethod(cl::desc("Choose a combination method:"),
     clEnumVal(mhs,  "Minimal hitting-set"),
     clEnumValEnd));
 
+/**
+ * \brief Max-sat algorithms. 
+ *
+ * The max-sat problems can be solved by the Yices built-in 
+ * max-sat procedure (yices), or by a core-guided algorithm 
+ * (Fu-Malik) built on top of Yices check calls (core).
+ */
+enum MaxSatAlgorithm {
+    yices, core
+};
+cl::opt<MaxSatAlgorithm>
+ChoosedMaxSatAlgorithm("maxsat", cl::desc("Choose a max-sat algorithm:"),
+    cl::values(
+    clEnumVal(yices, "Yices max-sat (default)"),
+    clEnumVal(core,  "Core-guided max-sat (Fu-Malik)"),
+    clEnumValEnd),
+    cl::init(yices));
+
+/**
+ * \brief MCS enumeration algorithms. 
+ *
+ * The MCSes of a failing trace can be enumerated by repeated max-sat 
+ * calls (maxsat), or by a linear search with clause D (cld) that only 
+ * needs check calls.
+ */
+enum MCSAlgorithm {
+    maxsat, cld
+};
+cl::opt<MCSAlgorithm>
+ChoosedMCSAlgorithm("mcs", cl::desc("Choose an MCS enumeration algorithm:"),
+    cl::values(
+    clEnumVal(maxsat, "Repeated max-sat (default)"),
+    clEnumVal(cld,    "Linear search with clause D (CLD)"),
+    clEnumValEnd),
+    cl::init(maxsat));
+
 /*==== Implementation ====*/
 
 void printVersionInformation() {
@@ -223,6 +328,22 @@ bool Options::printDuration() {
     return PrintDuration;
 }
 
+bool Options::printSolverStats() {
+    return PrintSolverStats;
+}
+
+std::string Options::getSolverStatsFileName() {
+    return SolverStatsFileName;
+}
+
+std::string Options::getRecordQueriesDir() {
+    return RecordQueriesDir;
+}
+
+std::string Options::getJSONStreamFileName() {
+    return JSONStreamFileName;
+}
+
 bool Options::printModIR() {
     return PrintModIR;
 }
@@ -287,10 +408,70 @@ unsigned Options::mcsMaxSize() {
     return MCSMaxSize;
 }
 
+unsigned Options::getMaxNbDiagnoses() {
+    return MaxNbDiagnoses;
+}
+
+unsigned Options::getNbWeightLevels() {
+    return NbWeightLevels;
+}
+
+bool Options::slicePaths() {
+    return SlicePaths;
+}
+
+bool Options::reduceConeOfInfluence() {
+    return ConeOfInfluence;
+}
+
+bool Options::preprocessFormula() {
+    return Preprocess;
+}
+
+bool Options::reuseMCSes() {
+    return ReuseMCSes;
+}
+
 bool Options::outputCFGDotFile() {
     return OutputCFGDotFile;
 }
 
+bool Options::incremental() {
+    return Incremental;
+}
+
+unsigned Options::getNbPortfolioWorkers() {
+    return NbPortfolioWorkers;
+}
+
+unsigned Options::getNbJobs() {
+    return NbJobs;
+}
+
+unsigned Options::getNbTraceRepresentatives() {
+    return NbTraceRepresentatives;
+}
+
+unsigned Options::getSolverTimeout() {
+    return SolverTimeout;
+}
+
+unsigned Options::getTraceTimeout() {
+    return TraceTimeout;
+}
+
+unsigned Options::getSolverMemoryLimit() {
+    return SolverMemoryLimit;
+}
+
+bool Options::useCexCache() {
+    return !NoCexCache;
+}
+
+bool Options::useIndependence() {
+    return !NoIndependence;
+}
+
 unsigned Options::getCombineMethod() {
     if (ChoosedCombineMethod==fla) {
         return Combine::FLA;
@@ -302,6 +483,17 @@ unsigned Options::getCombineMethod() {
     return Combine::NONE;
 }
 
+unsigned Options::getMaxSatAlgorithm() {
+    if (ChoosedMaxSatAlgorithm==core) {
+        return SolverBackend::CORE;
+    }
+    return SolverBackend::NATIVE;
+}
+
+bool Options::useCLD() {
+    return ChoosedMCSAlgorithm==cld;
+}
+
 // Hide unwanted options
 void Options::hideOptions() {
     StringMap<cl::Option*> Map;
@@ -90,6 +90,26 @@ public:
      * Return \a true if times are diplayed, false otherwise.
      */
     bool printDuration();
+    /**
+     * Return \a true if the solver statistics are displayed, 
+     * false otherwise.
+     */
+    bool printSolverStats();
+    /**
+     * Return the name of the JSON file in which the solver 
+     * statistics are exported (empty if none).
+     */
+    std::string getSolverStatsFileName();
+    /**
+     * Return the directory in which the solver queries are 
+     * recorded as SMT-LIB2 files (empty if none).
+     */
+    std::string getRecordQueriesDir();
+    /**
+     * Return the name of the file in which the MCSes and diagnoses 
+     * are streamed as JSON lines while they are found (empty if none).
+     */
+    std::string getJSONStreamFileName();
     /**
      * Return \a true if the target LLVM module is diplayed, false otherwise.
      */
@@ -177,15 +197,113 @@ public:
      * Return the maximum size diagnoses (MCSes) should not be bigger than.
      */
     unsigned mcsMaxSize();
+    /**
+     * Return the maximum number of diagnoses (MCSes) enumerated for
+     * each failing trace, by increasing size (within each stratum 
+     * with coverage weights, see getNbWeightLevels) (all of them if 0).
+     */
+    unsigned getMaxNbDiagnoses();
+    /**
+     * Return the number of weight levels of the soft constraints, 
+     * derived from the suspiciousness of their block (unit weights 
+     * and no stratification if 0).
+     */
+    unsigned getNbWeightLevels();
+    /**
+     * Return \a true if the trace formula is restricted to the
+     * executed path of each failing trace before the MCS
+     * enumeration, false if not.
+     */
+    bool slicePaths();
+    /**
+     * Return \a true if the trace formula is reduced to the cone of
+     * influence of the post-conditions and of the error-inducing 
+     * inputs, false if not.
+     */
+    bool reduceConeOfInfluence();
+    /**
+     * Return \a true if the trace formula is simplified before the
+     * MCS enumeration (see Preprocessor), false if not.
+     */
+    bool preprocessFormula();
+    /**
+     * Return \a true if the MCSes of the previous failing traces are
+     * validated for a trace before its enumeration, false if not.
+     * The validated MCSes are blocked, so that only the other ones 
+     * are enumerated by max-sat (the MCSes found are the same).
+     */
+    bool reuseMCSes();
     /**
      * Return \a true if a dot file representating the target program 
      * has to be generated and output to the user.
      */
     bool outputCFGDotFile();
+    /**
+     * Return \a true if the failing traces have to be diagnosed 
+     * incrementally, each trace being guarded by a selector literal,
+     * false if each trace is diagnosed between a push and a pop.
+     */
+    bool incremental();
+    /**
+     * Return the number of max-sat portfolio workers 
+     * (the portfolio is disabled if lower than 2).
+     */
+    unsigned getNbPortfolioWorkers();
+    /**
+     * Return the number of worker processes diagnosing 
+     * the failing traces (sequential if lower than 2), which
+     * is also the number of threads of the PWU combination.
+     */
+    unsigned getNbJobs();
+    /**
+     * Return the number of failing traces diagnosed for each executed 
+     * path, the MCSes of the other traces of the same path being the 
+     * ones of these representatives (all the traces are diagnosed 
+     * if 0). Requires the executed blocks (HFTF).
+     */
+    unsigned getNbTraceRepresentatives();
+    /**
+     * Return the wall time budget (in ms) of each solver query 
+     * (max-sat or check) of the MCS enumeration and of the MUS 
+     * extraction (0 if none).
+     */
+    unsigned getSolverTimeout();
+    /**
+     * Return the wall time budget (in ms) of the MCS enumeration
+     * of each failing trace (0 if none).
+     */
+    unsigned getTraceTimeout();
+    /**
+     * Return the memory budget (in MB) of each solver query
+     * (max-sat or check) of the MCS enumeration and of the MUS 
+     * extraction (0 if none).
+     */
+    unsigned getSolverMemoryLimit();
+    /**
+     * Return \a true if the results of the concolic solver queries
+     * are cached (see CexCache), false otherwise.
+     */
+    bool useCexCache();
+    /**
+     * Return \a true if only the path constraints that share variables
+     * with the negated branch are solved, false otherwise.
+     */
+    bool useIndependence();
     /**
      * Return the combination method (FLA, PWU, MHS) to be used.
      */
     unsigned getCombineMethod();
+    /**
+     * Return the max-sat algorithm (see SolverBackend::MaxSatAlgorithm)
+     * to be used.
+     */
+    unsigned getMaxSatAlgorithm();
+    /**
+     * Return \a true if the MCSes are enumerated by linear search 
+     * with clause D (CLD), false if they are enumerated by repeated
+     * max-sat calls.
+     */
+    bool useCLD();
     
 private:
     /**
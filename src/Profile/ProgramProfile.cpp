@@ -27,6 +27,8 @@
 
 #include "ProgramProfile.h"
 
+#include <cmath>
+
 
 std::set<BasicBlock*> ProgramProfile::getFailingRunBB() {
     std::set<BasicBlock*> bbs;
@@ -61,6 +63,30 @@ std::set<BasicBlock*> ProgramProfile::getOtherRunBB() {
     return bbs;
 }
 
+std::map<BasicBlock*, double> ProgramProfile::getBlockSuspiciousness() {
+    std::map<BasicBlock*, unsigned> nbFail, nbPass;
+    unsigned totalFail = 0;
+    for (ProgramTrace *t : traces) {
+        if (t->isFailing()) {
+            totalFail++;
+            for (BasicBlock *bb : t->getExecutedBB()) {
+                nbFail[bb]++;
+            }
+        } else if (t->isSuccessful()) {
+            for (BasicBlock *bb : t->getExecutedBB()) {
+                nbPass[bb]++;
+            }
+        }
+    }
+    std::map<BasicBlock*, double> susp;
+    std::map<BasicBlock*, unsigned>::iterator it;
+    for (it=nbFail.begin(); it!=nbFail.end(); ++it) {
+        const double f = it->second;
+        susp[it->first] = f / std::sqrt(totalFail*(f+nbPass[it->first]));
+    }
+    return susp;
+}
+
 void ProgramProfile::computeBugFreeBlocks(Options *o) {
     
     assert(!bugFreeBlocksComputed && "Bug free blocks already computed!");
@@ -227,6 +253,39 @@ std::vector<ProgramTrace*> ProgramProfile::getFailingProgramTraces() {
     return failingTraces;
 }
 
+std::vector<std::vector<ProgramTrace*> > 
+ProgramProfile::getFailingTraceClasses() {
+    std::vector<ProgramTrace*> failingTraces = getFailingProgramTraces();
+    return groupByPathSignature(failingTraces);
+}
+
+std::vector<std::vector<ProgramTrace*> > 
+ProgramProfile::groupByPathSignature(std::vector<ProgramTrace*> &traces) {
+    std::vector<std::vector<ProgramTrace*> > classes;
+    // Classes of each signature (different paths can collide)
+    std::map<uint64_t, std::vector<unsigned> > classIndex;
+    for (ProgramTrace *t : traces) {
+        if (!t->hasPathSignature()) {
+            classes.push_back(std::vector<ProgramTrace*>(1, t));
+            continue;
+        }
+        std::vector<unsigned> &bucket = classIndex[t->getPathSignature()];
+        bool found = false;
+        for (unsigned c : bucket) {
+            if (classes[c][0]->getExecutedPath()==t->getExecutedPath()) {
+                classes[c].push_back(t);
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            bucket.push_back(classes.size());
+            classes.push_back(std::vector<ProgramTrace*>(1, t));
+        }
+    }
+    return classes;
+}
+
 std::vector<ProgramTrace*> ProgramProfile::getSuccessfulProgramTraces() {
     std::vector<ProgramTrace*> successfulTraces;
     for (ProgramTrace *t : traces) {
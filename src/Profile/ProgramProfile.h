@@ -29,6 +29,7 @@
 #define _PROGRAMPROFILE_H
 
 #include <set>
+#include <map>
 #include <vector>
 #include <iostream>
 #include <memory>
@@ -109,6 +110,21 @@ public:
      * Return program execution traces that are neither failing or successful.
      */
     std::vector<ProgramTrace*> getUnkownProgramTraces();
+    /**
+     * Return the failing program execution traces grouped 
+     * by path signature (see groupByPathSignature).
+     */
+    std::vector<std::vector<ProgramTrace*> > getFailingTraceClasses();
+    /**
+     * Group the program execution traces \p traces that executed 
+     * the same path (same path signature and same sequence of 
+     * basicblocks). The classes are ordered 
+     * by their first trace in \p traces, and each class keeps the 
+     * order of \p traces. A trace without signature is alone in
+     * its class.
+     */
+    static std::vector<std::vector<ProgramTrace*> > 
+    groupByPathSignature(std::vector<ProgramTrace*> &traces);
     /**
      * Load testcases inputs and golden outputs.
      *
@@ -164,6 +180,14 @@ public:
      * failing or successful program executions.
      */
     std::set<BasicBlock*> getOtherRunBB();
+    /**
+     * Return the suspiciousness of the LLVM basic blocks executed in
+     * failing program executions, computed from the block coverage
+     * (spectrum) of the failing and successful executions with the 
+     * Ochiai metric: fail(b) / sqrt(totalFail * (fail(b) + pass(b))).
+     * The suspiciousness is in [0,1], missing blocks have 0.
+     */
+    std::map<BasicBlock*, double> getBlockSuspiciousness();
     /**
      * Return LLVM basic blocks that were never executed in
      * failing program executions.
@@ -32,6 +32,17 @@ unsigned ProgramTrace::ID = 0;
 void ProgramTrace::setExecutedBlocks(std::vector<BasicBlock*> &bb) {
     std::copy(bb.begin(), bb.end(),
               std::inserter(executedBlocks, executedBlocks.end()));
+    executedPath = bb;
+    // FNV-1a hash of the ordered blocks
+    uint64_t h = 14695981039346656037ULL;
+    for (BasicBlock *b : bb) {
+        uint64_t v = (uint64_t) (uintptr_t) b;
+        for (unsigned i=0; i<sizeof(v); i++) {
+            h ^= (v >> (8*i)) & 0xff;
+            h *= 1099511628211ULL;
+        }
+    }
+    pathSignature = bb.empty() ? 0 : (h ? h : 1);
 }
 
 void ProgramTrace::addProgramInput(Value *origin, Value *val) {
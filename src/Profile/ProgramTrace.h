@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <vector>
+#include <stdint.h>
 
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Instructions.h"
@@ -82,6 +83,16 @@ private:
      * associated to this trace.
      */
     std::set<BasicBlock*> executedBlocks;
+    /**
+     * Ordered sequence of executed LLVM basicblocks.
+     */
+    std::vector<BasicBlock*> executedPath;
+    /**
+     * Hash of the ordered sequence of executed LLVM basicblocks,
+     * which also encodes the branch outcomes (0 if the blocks
+     * were not collected).
+     */
+    uint64_t pathSignature;
     /**
      * Program input values used to trigger this trace.
      */
@@ -102,7 +113,7 @@ public:
      * \param _targetFun An LLVM target function.
      */
     ProgramTrace(Function *_targetFun)
-    : myID(ID++), targetFun(_targetFun), type(UNKNOW) {
+    : myID(ID++), targetFun(_targetFun), type(UNKNOW), pathSignature(0) {
         inputVars = std::make_shared<Variables>();
         expectedOutput = NULL;
     }
@@ -113,7 +124,7 @@ public:
      * \param _type The assert outcome of this trace.
      */
     ProgramTrace(Function *_targetFun, AssertResult _type)
-    : myID(ID++), targetFun(_targetFun), type(_type) {
+    : myID(ID++), targetFun(_targetFun), type(_type), pathSignature(0) {
         inputVars = std::make_shared<Variables>();
         expectedOutput = NULL;
     }
@@ -127,7 +138,7 @@ public:
      */
     ProgramTrace(Function *_targetFun, std::vector<Value*> _inputs,
                  AssertResult _type)
-    : myID(ID++), targetFun(_targetFun), type(_type) {
+    : myID(ID++), targetFun(_targetFun), type(_type), pathSignature(0) {
         assert(_targetFun->arg_size()==_inputs.size() &&
                "Wrong execution trace!");
         inputVars = std::make_shared<Variables>();
@@ -191,6 +202,29 @@ public:
      * Return the executed LLVM basicblocks of this trace.
      */
     std::set<BasicBlock*> getExecutedBB();
+    /**
+     * Return the ordered sequence of executed LLVM basicblocks.
+     */
+    const std::vector<BasicBlock*> &getExecutedPath() {
+        return executedPath;
+    }
+    /**
+     * Return \a true if the path signature of this trace 
+     * is available (see setExecutedBlocks).
+     */
+    bool hasPathSignature() {
+        return pathSignature!=0;
+    }
+    /**
+     * Return the signature of the executed path of this trace.
+     * Two traces that executed the same sequence of basicblocks
+     * have the same signature (the signature is only valid in 
+     * the current process). Different paths can collide, compare
+     * getExecutedPath to know if two paths are the same.
+     */
+    uint64_t getPathSignature() {
+        return pathSignature;
+    }
     
     // ==== Trace type (outcome) ====
     
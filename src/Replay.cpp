@@ -0,0 +1,157 @@
+/**
+ * \file Replay.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <dirent.h>
+
+#include "llvm/Support/CommandLine.h"
+
+#include "Logic/Expression.h"
+#include "Logic/SolverBackend.h"
+#include "Logic/YicesSolver.h"
+#include "Logic/SATSolver.h"
+#include "Logic/SolverStats.h"
+#include "Logic/QueryRecorder.h"
+
+using namespace llvm;
+
+static cl::opt <std::string>
+InputDirectory(cl::Positional, cl::desc("Directory of recorded queries (see -record-queries)"),
+               cl::Required, cl::value_desc("directory"));
+
+/**
+ * \brief Solver backends. 
+ */
+enum Backend {
+    yices, core, sat
+};
+cl::opt<Backend>
+ChoosedBackend("backend", cl::desc("Choose a solver backend:"),
+    cl::values(
+    clEnumVal(yices, "Yices with its max-sat (default)"),
+    clEnumVal(core,  "Yices with the core-guided max-sat"),
+    clEnumVal(sat,   "Built-in SAT solver (propositional queries only)"),
+    clEnumValEnd),
+    cl::init(yices));
+
+static cl::opt <bool>
+Verbose("v", cl::desc("Print the result and time of each query"));
+
+/**
+ * Replay a directory of recorded queries against a solver backend
+ * and report the timing.
+ */
+int main(int argc, char **argv) {
+    cl::ParseCommandLineOptions(argc, argv, "SNIPER query replay\n");
+    
+    // Recorded queries, in recording order
+    std::vector<std::string> files;
+    DIR *dir = opendir(InputDirectory.c_str());
+    if (!dir) {
+        std::cerr << "error: could not open " << InputDirectory << std::endl;
+        return 1;
+    }
+    while (struct dirent *ent = readdir(dir)) {
+        std::string name = ent->d_name;
+        if (name.size()>5 && name.substr(name.size()-5)==".smt2") {
+            files.push_back(InputDirectory+"/"+name);
+        }
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+    
+    SolverBackend *solver;
+    if (ChoosedBackend==sat) {
+        solver = new SATSolver();
+    } else {
+        YicesSolver *yices = new YicesSolver();
+        if (ChoosedBackend==core) {
+            yices->setMaxSatAlgorithm(SolverBackend::CORE);
+        }
+        solver = yices;
+    }
+    
+    unsigned nbReplayed = 0, nbSkipped = 0;
+    double totalTime = 0;
+    for (std::string f : files) {
+        std::vector<ExprPtr> hard, soft;
+        bool isMaxSat;
+        if (!QueryRecorder::load(f, hard, soft, isMaxSat)) {
+            std::cerr << "warning: could not load " << f << std::endl;
+            nbSkipped++;
+            continue;
+        }
+        if (ChoosedBackend==sat) {
+            bool propositional = true;
+            for (ExprPtr e : hard) {
+                propositional = propositional && SATSolver::isPropositional(e);
+            }
+            for (ExprPtr e : soft) {
+                propositional = propositional && SATSolver::isPropositional(e);
+            }
+            if (!propositional) {
+                nbSkipped++;
+                continue;
+            }
+        }
+        solver->init();
+        for (ExprPtr e : hard) {
+            solver->addToContext(e);
+        }
+        for (ExprPtr e : soft) {
+            solver->addToContext(e);
+        }
+        double startTime = SolverStats::getTime();
+        int res = isMaxSat ? solver->maxSat() : solver->check();
+        double ms = SolverStats::getTime()-startTime;
+        totalTime += ms;
+        nbReplayed++;
+        if (Verbose) {
+            std::cout << f << " ";
+            std::cout << (res==SolverBackend::True ? "sat" : (res==SolverBackend::False ? "unsat" : "unknown"));
+            if (isMaxSat && res==SolverBackend::True) {
+                std::cout << " (cost " << solver->getCostAsDouble() << ")";
+            }
+            std::cout << std::fixed << std::setprecision(2);
+            std::cout << " " << ms << " ms" << std::endl;
+        }
+        solver->clean();
+    }
+    delete solver;
+    
+    std::cout << "Replayed queries : " << nbReplayed << std::endl;
+    std::cout << "Skipped queries  : " << nbSkipped << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Total time (ms)  : " << totalTime << std::endl;
+    SolverStats::printReport(std::cout);
+    return 0;
+}
@@ -35,13 +35,19 @@
 #include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <bitset>
+#include <stdint.h>
 
-#include "yices_c.h"
+#include "Logic/Expression.h"
+#include "Logic/SolverBackend.h"
+#include "Logic/SATSolver.h"
+#include "Logic/SolverStats.h"
 
 /**
  * \class HittingSet
  *
- * \brief This class provides a method to compute minimal hitting-set.
+ * \brief This class provides methods to compute minimal hitting-set,
+ * either with a max-sat solver (LP) or natively (MMCS).
  */
 template <typename T>
 class HittingSet {
@@ -65,16 +71,220 @@ public:
      *
      * \param S A vector of sets (MCSes) (input).
      * \param H A vector of sets (MCSes) (output).
+     * \param solver A max-sat solver, or NULL to use the 
+     *        built-in propositional solver (SATSolver).
      */
     static void getMinimalHittingSets_LP(std::vector<std::set<T> > &S,
-                                  std::vector<std::set<T> > &H);
+                                  std::vector<std::set<T> > &H,
+                                  SolverBackend *solver = NULL);
+
+    /**
+     * Compute the minimal hitting-sets \p H of \p S without solver,
+     * with the MMCS algorithm (Murakami and Uno, "Efficient algorithms 
+     * for dualizing large-scale hypergraphs").
+     *
+     * The elements are mapped to dense indices and the sets are 
+     * represented as packed bitsets. The hitting sets are built by a
+     * depth-first search: an uncovered set with the fewest candidate 
+     * elements is selected, and each of its candidates is added in 
+     * turn, as long as every element of the current hitting set still 
+     * has a critical set (a set that only this element hits).
+     * 
+     * The hitting sets are returned by increasing size, as with
+     * getMinimalHittingSets_LP.
+     *
+     * \param S A vector of sets (MCSes) (input).
+     * \param H A vector of sets (MCSes) (output).
+     */
+    static void getMinimalHittingSets_MMCS(std::vector<std::set<T> > &S,
+                                           std::vector<std::set<T> > &H);
+    
+private:
+    /**
+     * Packed bitset.
+     */
+    typedef std::vector<uint64_t> Bits;
+    
+    static bool testBit(const Bits &b, unsigned i) {
+        return (b[i/64]>>(i%64)) & 1;
+    }
+    static void setBit(Bits &b, unsigned i) {
+        b[i/64] |= ((uint64_t) 1)<<(i%64);
+    }
+    static void clearBit(Bits &b, unsigned i) {
+        b[i/64] &= ~(((uint64_t) 1)<<(i%64));
+    }
+    static bool isEmpty(const Bits &b) {
+        for (uint64_t w : b) {
+            if (w) return false;
+        }
+        return true;
+    }
+    /**
+     * Number of elements of (a and b).
+     */
+    static unsigned countAnd(const Bits &a, const Bits &b) {
+        unsigned n = 0;
+        for (unsigned i=0; i<a.size(); i++) {
+            n += std::bitset<64>(a[i] & b[i]).count();
+        }
+        return n;
+    }
+    
+    /**
+     * State of the MMCS search: the sets (edges) as bitsets of 
+     * elements, the sets hit by each element, the candidate 
+     * elements, the uncovered sets, the current hitting set, 
+     * and the critical sets of its elements.
+     */
+    struct MMCS {
+        std::vector<Bits> edges;
+        std::vector<Bits> occ;
+        Bits cand;
+        Bits uncov;
+        std::vector<unsigned> hs;
+        std::vector<Bits> crit;
+        std::vector<std::vector<unsigned> > out;
+    };
+    
+    static void search(MMCS &st);
+    
+    static bool smaller(const std::vector<unsigned> &a, 
+                        const std::vector<unsigned> &b) {
+        return a.size()!=b.size() ? a.size()<b.size() : a<b;
+    }
 
 };
 
+template<class T>
+void HittingSet<T>::search(MMCS &st) {
+    // Uncovered set with the fewest candidates
+    int best = -1;
+    unsigned bestNb = 0;
+    for (unsigned j=0; j<st.edges.size(); j++) {
+        if (!testBit(st.uncov, j)) {
+            continue;
+        }
+        unsigned nb = countAnd(st.edges[j], st.cand);
+        if (best<0 || nb<bestNb) {
+            best = j;
+            bestNb = nb;
+        }
+    }
+    if (best<0) {
+        // Every set is hit
+        if (!st.hs.empty()) {
+            st.out.push_back(st.hs);
+        }
+        return;
+    }
+    // C = (cand and F), cand = cand - C
+    std::vector<unsigned> C;
+    for (unsigned e=0; e<st.occ.size(); e++) {
+        if (testBit(st.edges[best], e) && testBit(st.cand, e)) {
+            C.push_back(e);
+            clearBit(st.cand, e);
+        }
+    }
+    const unsigned nbWords = st.uncov.size();
+    for (unsigned e : C) {
+        // Add e: the uncovered sets hit by e become critical for e,
+        // and are no more critical for the other elements
+        Bits critE(nbWords), oldUncov = st.uncov;
+        std::vector<Bits> oldCrit = st.crit;
+        bool minimal = true;
+        for (unsigned w=0; w<nbWords; w++) {
+            critE[w] = st.uncov[w] & st.occ[e][w];
+            st.uncov[w] &= ~st.occ[e][w];
+        }
+        for (unsigned k=0; k<st.crit.size(); k++) {
+            for (unsigned w=0; w<nbWords; w++) {
+                st.crit[k][w] &= ~st.occ[e][w];
+            }
+            minimal = minimal && !isEmpty(st.crit[k]);
+        }
+        if (minimal) {
+            st.hs.push_back(e);
+            st.crit.push_back(critE);
+            search(st);
+            st.crit.pop_back();
+            st.hs.pop_back();
+        }
+        st.uncov = oldUncov;
+        st.crit = oldCrit;
+        setBit(st.cand, e);
+    }
+}
+
+template<class T>
+void HittingSet<T>::getMinimalHittingSets_MMCS(std::vector<std::set<T> > &S,
+                                               std::vector<std::set<T> > &H) {
+    // Dense indices of the elements
+    std::map<T, unsigned> elt2id;
+    std::vector<T> elts;
+    for (unsigned j=0; j<S.size(); j++) {
+        typename std::set<T>::const_iterator it;
+        for (it=S[j].begin(); it!=S[j].end(); ++it) {
+            if (elt2id.insert(std::make_pair(*it, elts.size())).second) {
+                elts.push_back(*it);
+            }
+        }
+    }
+    // Sets (the empty ones cannot be hit) and elements as bitsets
+    MMCS st;
+    std::vector<unsigned> edgeIds;
+    for (unsigned j=0; j<S.size(); j++) {
+        if (!S[j].empty()) {
+            edgeIds.push_back(j);
+        }
+    }
+    const unsigned nbEltWords = (elts.size()+63)/64;
+    const unsigned nbEdgeWords = (edgeIds.size()+63)/64;
+    st.edges.assign(edgeIds.size(), Bits(nbEltWords));
+    st.occ.assign(elts.size(), Bits(nbEdgeWords));
+    for (unsigned j=0; j<edgeIds.size(); j++) {
+        typename std::set<T>::const_iterator it;
+        for (it=S[edgeIds[j]].begin(); it!=S[edgeIds[j]].end(); ++it) {
+            unsigned e = elt2id[*it];
+            setBit(st.edges[j], e);
+            setBit(st.occ[e], j);
+        }
+    }
+    st.cand.assign(nbEltWords, 0);
+    for (unsigned e=0; e<elts.size(); e++) {
+        setBit(st.cand, e);
+    }
+    st.uncov.assign(nbEdgeWords, 0);
+    for (unsigned j=0; j<edgeIds.size(); j++) {
+        setBit(st.uncov, j);
+    }
+    search(st);
+    // By increasing size
+    for (std::vector<unsigned> &hs : st.out) {
+        std::sort(hs.begin(), hs.end());
+    }
+    std::sort(st.out.begin(), st.out.end(), smaller);
+    for (std::vector<unsigned> &hs : st.out) {
+        std::set<T> subset;
+        for (unsigned e : hs) {
+            subset.insert(elts[e]);
+        }
+        H.push_back(subset);
+    }
+}
+
 // xi is equal to 1 iff Si is selected
 template<class T>
 void HittingSet<T>::getMinimalHittingSets_LP(std::vector<std::set<T> > &S,
-                                             std::vector<std::set<T> > &H) {
+                                             std::vector<std::set<T> > &H,
+                                             SolverBackend *solver) {
+    // The problem is purely propositional
+    SATSolver satSolver;
+    if (!solver) {
+        solver = &satSolver;
+    }
+    unsigned phase = SolverStats::setPhase(SolverStats::HITTINGSET);
+    solver->init();
     // Create the universe U
     std::set<T> U;
     for (unsigned i=0; i<S.size(); i++) {
@@ -82,9 +292,7 @@ void HittingSet<T>::getMinimalHittingSets_LP(std::vector<std::set<T> > &S,
     }
     // Create a boolean variables for each elements in U
     std::map<T, unsigned> elt2id;
-    std::vector<yices_expr> X(U.size());
-    std::vector<yices_var_decl> Xdecl(U.size());
-    yices_context ctx = yices_mk_context();
+    std::vector<BoolVarExprPtr> X(U.size());
     unsigned i = 0;
     typename std::set<T>::const_iterator itu;
     for (itu=U.begin(); itu!=U.end(); ++itu) {
@@ -92,11 +300,11 @@ void HittingSet<T>::getMinimalHittingSets_LP(std::vector<std::set<T> > &S,
         elt2id[elt] = i;
         std::stringstream ss;
         ss << "X" << i;
-        Xdecl[i] = yices_mk_bool_var_decl(ctx, ss.str().c_str());
-        X[i]     = yices_mk_bool_var_from_decl(ctx, Xdecl[i]);
-        // Construct the weighted constraints ((not xi) 1)
-        yices_expr eq_expr =  yices_mk_not(ctx, X[i]);
-        yices_assert_weighted(ctx, eq_expr, 1);
+        X[i] = Expression::mkBoolVar(ss.str());
+        // Construct the soft constraints (not xi)
+        ExprPtr notXi = Expression::mkNot(X[i]);
+        notXi->setSoft();
+        solver->addToContext(notXi);
         i++;
     }
     
@@ -104,83 +312,68 @@ void HittingSet<T>::getMinimalHittingSets_LP(std::vector<std::set<T> > &S,
     // create a hard constraint: (or x1 x2 ... xn)
     // where xi is present in the constraint iff
     // xi hits the current set
-    unsigned j = 0;
-    std::map<unsigned, std::set<yices_expr> > setid2Xs;
     typename std::vector<std::set<T> >::const_iterator it1;
     for (it1=S.begin(); it1!=S.end(); ++it1) {
+        std::set<unsigned> ids;
         typename std::set<T>::const_iterator it2;
         for (it2=(*it1).begin(); it2!=(*it1).end(); ++it2) {
             // element : (xi ... xj)
-            setid2Xs[j].insert(X[elt2id[*it2]]);
-        }
-        j++; // Next set
-    }
-    // Construct the constraints (or xi ... xj)
-    std::map<unsigned, std::set<yices_expr> >::const_iterator it3;
-    for (it3=setid2Xs.begin(); it3!=setid2Xs.end(); ++it3) {
-        std::set<yices_expr> Xs = it3->second;
-        yices_expr or_expr;
-        if (Xs.size()==1) {
-            or_expr = *Xs.begin();
-        } else {
-            yices_expr orTab[Xs.size()];
-            unsigned j = 0;
-            std::set<yices_expr>::const_iterator it4;
-            for (it4=Xs.begin(); it4!=Xs.end(); ++it4) {
-                yices_expr e = *it4;
-                orTab[j] = e;
-                j++;
-            }
-            or_expr = yices_mk_or(ctx, orTab, Xs.size());
+            ids.insert(elt2id[*it2]);
+        }
+        if (ids.empty()) {
+            continue;
+        }
+        // Construct the constraint (or xi ... xj)
+        std::vector<ExprPtr> Xs;
+        std::set<unsigned>::const_iterator it3;
+        for (it3=ids.begin(); it3!=ids.end(); ++it3) {
+            Xs.push_back(X[*it3]);
         }
-        yices_assert(ctx, or_expr);
+        ExprPtr orExpr = Expression::mkOr(Xs);
+        orExpr->setHard();
+        solver->addToContext(orExpr);
     }
     
     bool done =false;
     while (!done) {
         // Solve the formula
-        //std::cout << "max-sat\n";
-        switch(yices_max_sat(ctx)) {
-            case l_true: {
-                // Display the model
-                yices_model model = yices_get_model(ctx);
-                //yices_display_model(model);
+        switch(solver->maxSat()) {
+            case SolverBackend::True: {
                 // Get the value from the model for each Xi
-                unsigned j = 0;
-                yices_expr args[U.size()];
+                std::vector<ExprPtr> args;
                 std::set<T> subset;
-                for (unsigned i=0; i<U.size(); i++) {
-                    lbool val = yices_get_value(model, Xdecl[i]);
-                    // The set Si was selected
-                    if (val==l_true) {
+                typename std::set<T>::iterator it = U.begin();
+                for (unsigned i=0; i<U.size(); i++, ++it) {
+                    // The element was selected
+                    if (solver->getBoolValue(X[i]->getNameID())==SolverBackend::True) {
                         // Save the element
-                        typename std::set<T>::iterator it = U.begin();
-                        std::advance(it, i); // advanced by i
                         subset.insert(*it);
                         // To block the current solution
-                        args[j++] = yices_mk_not(ctx, X[i]);
+                        args.push_back(Expression::mkNot(X[i]));
                     }
                 }
                 if (!subset.empty()) {
                     // Save the solution
                     H.push_back(subset);
                     // Block the current solution
-                    yices_expr blockExpr = yices_mk_or(ctx, args, j);
-                    yices_assert(ctx, blockExpr);
+                    ExprPtr blockExpr = Expression::mkOr(args);
+                    blockExpr->setHard();
+                    solver->addToContext(blockExpr);
                 } else {
                     done = true;
                 }
             } break;
-            case l_false: // unsatisfiable
+            case SolverBackend::False: // unsatisfiable
                 done = true;
                 break;
-            case l_undef: // unknown
+            case SolverBackend::Undef: // unknown
                 done = true;
                 break;
         }
         
     }
-    yices_del_context(ctx);
+    solver->clean();
+    SolverStats::setPhase(phase);
 }
 
 #endif // _HITTINGSET_H
@@ -0,0 +1,135 @@
+/**
+ * \file CexCacheTest.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#include <stdio.h>
+#include <sstream>
+
+#include "Logic/CexCache.h"
+#include "gtest/gtest.h"
+
+
+TEST(CexCacheTest, CexCacheSubsets) {
+    
+    CexCache *cache = new CexCache();
+    
+    // x > 0, x < 10, x > 20
+    IntVarExprPtr x = Expression::mkIntVar("x");
+    ExprPtr e1 = Expression::mkGt(x, Expression::mkSInt32Num(0));
+    ExprPtr e2 = Expression::mkLt(x, Expression::mkSInt32Num(10));
+    ExprPtr e3 = Expression::mkGt(x, Expression::mkSInt32Num(20));
+    
+    // Structurally equal constraints have the same key
+    std::vector<ExprPtr> q1;
+    q1.push_back(e2);
+    q1.push_back(e1);
+    q1.push_back(Expression::mkGt(Expression::mkIntVar("x"), 
+                                  Expression::mkSInt32Num(0)));
+    std::vector<unsigned> k1 = cache->makeKey(q1);
+    EXPECT_EQ(k1.size(), 2);
+    CexCache::Model model;
+    EXPECT_EQ(cache->lookup(k1, model), SolverBackend::Undef);
+    model[x->getNameID()] = 5;
+    cache->insertSat(k1, model);
+    
+    // Exact hit and satisfiable superset
+    CexCache::Model m;
+    EXPECT_EQ(cache->lookup(k1, m), SolverBackend::True);
+    EXPECT_EQ(m[x->getNameID()], 5);
+    std::vector<ExprPtr> q2(1, e1);
+    std::vector<unsigned> k2 = cache->makeKey(q2);
+    EXPECT_EQ(cache->lookup(k2, m), SolverBackend::True);
+    
+    // (x < 10 and x > 20) is unsatisfiable, so is any superset
+    std::vector<ExprPtr> q3;
+    q3.push_back(e2);
+    q3.push_back(e3);
+    std::vector<unsigned> k3 = cache->makeKey(q3);
+    EXPECT_EQ(cache->lookup(k3, m), SolverBackend::Undef);
+    cache->insertUnsat(k3);
+    q3.push_back(e1);
+    std::vector<unsigned> k4 = cache->makeKey(q3);
+    EXPECT_EQ(cache->lookup(k4, m), SolverBackend::False);
+    
+    // The model of a subset satisfies the query (x > 0, x < 10, x != 7)
+    std::vector<ExprPtr> q5 = q1;
+    q5.push_back(Expression::mkDiseq(x, Expression::mkSInt32Num(7)));
+    std::vector<unsigned> k5 = cache->makeKey(q5);
+    m.clear();
+    EXPECT_EQ(cache->lookup(k5, m), SolverBackend::True);
+    EXPECT_EQ(m[x->getNameID()], 5);
+    
+    // ... or does not (x > 0, x < 10, x != 5)
+    std::vector<ExprPtr> q6 = q1;
+    q6.push_back(Expression::mkDiseq(x, Expression::mkSInt32Num(5)));
+    std::vector<unsigned> k6 = cache->makeKey(q6);
+    EXPECT_EQ(cache->lookup(k6, m), SolverBackend::Undef);
+    
+    EXPECT_EQ(cache->getNbLookups(), 7);
+    EXPECT_EQ(cache->getNbHits(), 4);
+    
+    delete cache;
+}
+
+TEST(CexCacheTest, CexCacheEvaluate) {
+    
+    // (p and (ite p (x + 1) 0) = 4) or (not p)
+    IntVarExprPtr x = Expression::mkIntVar("x");
+    BoolVarExprPtr p = Expression::mkBoolVar("p");
+    ExprPtr ite = Expression::mkIte(p, Expression::mkSum(x, Expression::mkSInt32Num(1)),
+                                    Expression::mkSInt32Num(0));
+    ExprPtr e1 = Expression::mkAnd(p, Expression::mkEq(ite, Expression::mkSInt32Num(4)));
+    ExprPtr e = Expression::mkOr(e1, Expression::mkNot(p));
+    
+    std::set<unsigned> boolVars, intVars;
+    CexCache::collectVars(e, boolVars, intVars);
+    EXPECT_EQ(boolVars.size(), 1);
+    EXPECT_EQ(intVars.size(), 1);
+    
+    CexCache::Model model;
+    long val;
+    // Unknown variables
+    EXPECT_FALSE(CexCache::evaluate(e, model, val));
+    model[p->getNameID()] = 1;
+    model[x->getNameID()] = 3;
+    EXPECT_TRUE(CexCache::evaluate(e, model, val));
+    EXPECT_EQ(val, 1);
+    model[x->getNameID()] = 2;
+    EXPECT_TRUE(CexCache::evaluate(e, model, val));
+    EXPECT_EQ(val, 0);
+    
+    // Division is not supported
+    ExprPtr d = Expression::mkEq(Expression::mkDiv(x, Expression::mkSInt32Num(2)),
+                                 Expression::mkSInt32Num(1));
+    EXPECT_FALSE(CexCache::evaluate(d, model, val));
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+    printf("Running main() from gtest_main.cc\n");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -81,6 +81,94 @@ TEST(CombineTest, CombineTestPWU) {
 
 }
 
+TEST(CombineTest, CombineTestPWUSubsumption) {
+    
+    // <{{a},{b}}, {{a},{c}}> -> {{b,a},{a,c},{b,c}}
+    ExprPtr a = Expression::mkBoolVar("a");
+    ExprPtr b = Expression::mkBoolVar("b");
+    ExprPtr c = Expression::mkBoolVar("c");
+    std::vector<SetOfFormulasPtr> D1;
+    SetOfFormulasPtr sf1 = SetOfFormulas::make();
+    FormulaPtr fa = Formula::make();
+    fa->add(a);
+    FormulaPtr fb = Formula::make();
+    fb->add(b);
+    FormulaPtr fc = Formula::make();
+    fc->add(c);
+    sf1->add(fa);
+    sf1->add(fb);
+    D1.push_back(sf1);
+    SetOfFormulasPtr sf2 = SetOfFormulas::make();
+    sf2->add(fa);
+    sf2->add(fc);
+    D1.push_back(sf2);
+    SetOfFormulasPtr C1 = Combine::combineByPWU(D1);
+    EXPECT_EQ(C1->size(), 3);
+    EXPECT_TRUE(C1->getAt(0)->getExprs()==std::vector<ExprPtr>({b, a}));
+    EXPECT_TRUE(C1->getAt(1)->getExprs()==std::vector<ExprPtr>({a, c}));
+    EXPECT_TRUE(C1->getAt(2)->getExprs()==std::vector<ExprPtr>({b, c}));
+    
+    // <{{a},{b}}, {{c}}, {{a},{b}}> -> {{b,c,a}}: the union 
+    // {a,c,b} is the same set in another order
+    std::vector<SetOfFormulasPtr> D4;
+    D4.push_back(sf1);
+    SetOfFormulasPtr sf3 = SetOfFormulas::make();
+    sf3->add(fc);
+    D4.push_back(sf3);
+    D4.push_back(sf1);
+    SetOfFormulasPtr C5 = Combine::combineByPWU(D4);
+    EXPECT_EQ(C5->size(), 1);
+    EXPECT_TRUE(C5->getAt(0)->getExprs()==std::vector<ExprPtr>({b, c, a}));
+    
+    // 60 traces with the MCSes {{x},{yi}} (2^60 tuples) -> 
+    // {{y0,...,y58,x},...,{y1,...,y59,x},{y0,...,y59}}
+    ExprPtr x = Expression::mkBoolVar("x");
+    FormulaPtr fx = Formula::make();
+    fx->add(x);
+    std::vector<ExprPtr> y;
+    std::vector<SetOfFormulasPtr> D2;
+    for (int i=0; i<60; i++) {
+        y.push_back(Expression::mkBoolVar("y"+std::to_string(i)));
+        FormulaPtr fy = Formula::make();
+        fy->add(y[i]);
+        SetOfFormulasPtr sf = SetOfFormulas::make();
+        sf->add(fx);
+        sf->add(fy);
+        D2.push_back(sf);
+    }
+    SetOfFormulasPtr C2 = Combine::combineByPWU(D2, 4);
+    EXPECT_EQ(C2->size(), 61);
+    std::vector<ExprPtr> Y0(y.begin(), y.end()-1);
+    Y0.push_back(x);
+    EXPECT_TRUE(C2->getAt(0)->getExprs()==Y0);
+    EXPECT_TRUE(C2->getAt(60)->getExprs()==y);
+    
+    // Same result with several threads: 10 traces 
+    // with the MCSes {{zi},{zi+1},{zi+2}}
+    std::vector<ExprPtr> z;
+    for (int i=0; i<12; i++) {
+        z.push_back(Expression::mkBoolVar("z"+std::to_string(i)));
+    }
+    std::vector<SetOfFormulasPtr> D3;
+    for (int i=0; i<10; i++) {
+        SetOfFormulasPtr sf = SetOfFormulas::make();
+        for (int j=0; j<3; j++) {
+            FormulaPtr f = Formula::make();
+            f->add(z[i+j]);
+            sf->add(f);
+        }
+        D3.push_back(sf);
+    }
+    SetOfFormulasPtr C3 = Combine::combineByPWU(D3, 1);
+    SetOfFormulasPtr C4 = Combine::combineByPWU(D3, 4);
+    EXPECT_TRUE(!C3->empty());
+    EXPECT_EQ(C3->size(), C4->size());
+    for (unsigned k=0; k<C3->size() && k<C4->size(); k++) {
+        EXPECT_TRUE(C3->getAt(k)->getExprs()==C4->getAt(k)->getExprs());
+    }
+
+}
+
 TEST(CombineTest, CombineTestMHS) {
     
     // Empty set of formulas
@@ -182,6 +270,65 @@ TEST(CombineTest, CombineTestFlatten) {
 
 }
 
+TEST(CombineTest, CombineTestMMCS) {
+    
+    // {{1,2},{2,3},{3,4}} -> {{1,3},{2,3},{2,4}}
+    std::vector<std::set<int> > S1;
+    S1.push_back({1, 2});
+    S1.push_back({2, 3});
+    S1.push_back({3, 4});
+    std::vector<std::set<int> > H1;
+    HittingSet<int>::getMinimalHittingSets_MMCS(S1, H1);
+    EXPECT_EQ(H1.size(), 3);
+    EXPECT_TRUE(H1[0]==std::set<int>({1, 3}));
+    EXPECT_TRUE(H1[1]==std::set<int>({2, 3}));
+    EXPECT_TRUE(H1[2]==std::set<int>({2, 4}));
+    
+    // Same minimal hitting sets as the max-sat version
+    std::vector<std::set<int> > S2;
+    for (int i=0; i<70; i++) {
+        S2.push_back({i, (i*7+3)%80, (i*13+5)%80});
+    }
+    std::vector<std::set<int> > H2, H3;
+    HittingSet<int>::getMinimalHittingSets_MMCS(S1, H2);
+    HittingSet<int>::getMinimalHittingSets_LP(S1, H3);
+    std::set<std::set<int> > R2(H2.begin(), H2.end());
+    std::set<std::set<int> > R3(H3.begin(), H3.end());
+    EXPECT_TRUE(R2==R3);
+    std::vector<std::set<int> > S4(S2.begin(), S2.begin()+8);
+    std::vector<std::set<int> > H4, H5;
+    HittingSet<int>::getMinimalHittingSets_MMCS(S4, H4);
+    HittingSet<int>::getMinimalHittingSets_LP(S4, H5);
+    std::set<std::set<int> > R4(H4.begin(), H4.end());
+    std::set<std::set<int> > R5(H5.begin(), H5.end());
+    EXPECT_EQ(H4.size(), H5.size());
+    EXPECT_TRUE(R4==R5);
+    for (unsigned i=1; i<H4.size(); i++) {
+        EXPECT_TRUE(H4[i-1].size()<=H4[i].size());
+    }
+    
+    // More than 64 elements and sets:
+    // {{0,100},...,{69,100}} -> {{100},{0,...,69}}
+    std::vector<std::set<int> > S6;
+    for (int i=0; i<70; i++) {
+        S6.push_back({i, 100});
+    }
+    std::vector<std::set<int> > H6;
+    HittingSet<int>::getMinimalHittingSets_MMCS(S6, H6);
+    EXPECT_EQ(H6.size(), 2);
+    EXPECT_TRUE(H6[0]==std::set<int>({100}));
+    EXPECT_EQ(H6[1].size(), 70);
+    
+    // Empty input sets are ignored
+    std::vector<std::set<int> > S7;
+    S7.push_back({});
+    S7.push_back({5});
+    std::vector<std::set<int> > H7;
+    HittingSet<int>::getMinimalHittingSets_MMCS(S7, H7);
+    EXPECT_EQ(H7.size(), 1);
+    
+}
+
 GTEST_API_ int main(int argc, char **argv) {
     printf("Running main() from gtest_main.cc\n");
     testing::InitGoogleTest(&argc, argv);
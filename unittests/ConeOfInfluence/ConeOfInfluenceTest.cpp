@@ -0,0 +1,132 @@
+/**
+ * \file ConeOfInfluenceTest.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#include <stdio.h>
+
+#include "Logic/ConeOfInfluence.h"
+#include "gtest/gtest.h"
+
+
+TEST(ConeOfInfluenceTest, ConeOfInfluenceReduce) {
+    
+    // x = a + b  (not used)
+    // y = c + 1
+    // z = (ite p y d)
+    // p = (> d 0)
+    // (> z 0)      (post-condition)
+    IntVarExprPtr  a = Expression::mkIntVar("coi_a");
+    IntVarExprPtr  b = Expression::mkIntVar("coi_b");
+    IntVarExprPtr  c = Expression::mkIntVar("coi_c");
+    IntVarExprPtr  d = Expression::mkIntVar("coi_d");
+    IntVarExprPtr  x = Expression::mkIntVar("coi_x");
+    IntVarExprPtr  y = Expression::mkIntVar("coi_y");
+    IntVarExprPtr  z = Expression::mkIntVar("coi_z");
+    BoolVarExprPtr p = Expression::mkBoolVar("coi_p");
+    ExprPtr one  = Expression::mkSInt32Num(1);
+    ExprPtr zero = Expression::mkSInt32Num(0);
+    ExprPtr e1 = Expression::mkEq(x, Expression::mkSum(a, b));
+    ExprPtr e2 = Expression::mkEq(y, Expression::mkSum(c, one));
+    ExprPtr e3 = Expression::mkEq(z, Expression::mkIte(p, y, d));
+    ExprPtr e4 = Expression::mkEq(p, Expression::mkGt(d, zero));
+    e1->setSoft();
+    e2->setSoft();
+    e3->setHard();
+    e4->setSoft();
+    ExprPtr post = Expression::mkGt(z, zero);
+    post->setHard();
+    Formula *f = new Formula();
+    f->add(e1);
+    f->add(e2);
+    f->add(e3);
+    f->add(e4);
+    f->add(post);
+    
+    // Only the definition of x is out of the cone
+    std::set<unsigned> vars;
+    unsigned nbHard = 0, nbSoft = 0;
+    ConeOfInfluence::reduce(f, vars, nbHard, nbSoft);
+    EXPECT_EQ(nbHard, 0);
+    EXPECT_EQ(nbSoft, 1);
+    EXPECT_EQ(f->size(), 4);
+    
+    // The post-condition is (not p): z and y are out of the cone
+    f->remove(post);
+    ExprPtr notp = Expression::mkNot(p);
+    notp->setHard();
+    f->add(notp);
+    ConeOfInfluence::reduce(f, vars, nbHard, nbSoft);
+    EXPECT_EQ(nbHard, 1);
+    EXPECT_EQ(nbSoft, 1);
+    EXPECT_EQ(f->size(), 2);
+    
+    delete f;
+}
+
+TEST(ConeOfInfluenceTest, ConeOfInfluenceRoots) {
+    
+    // x = a, x = b (defined twice), y = x + 1, w = a
+    IntVarExprPtr a = Expression::mkIntVar("coi_a");
+    IntVarExprPtr b = Expression::mkIntVar("coi_b");
+    IntVarExprPtr x = Expression::mkIntVar("coi_x");
+    IntVarExprPtr y = Expression::mkIntVar("coi_y");
+    IntVarExprPtr w = Expression::mkIntVar("coi_w");
+    ExprPtr e1 = Expression::mkEq(x, a);
+    ExprPtr e2 = Expression::mkEq(x, b);
+    ExprPtr one = Expression::mkSInt32Num(1);
+    ExprPtr e3 = Expression::mkEq(y, Expression::mkSum(x, one));
+    ExprPtr e4 = Expression::mkEq(w, a);
+    e1->setHard();
+    e2->setHard();
+    e3->setHard();
+    e4->setHard();
+    Formula *f = new Formula();
+    f->add(e1);
+    f->add(e2);
+    f->add(e3);
+    f->add(e4);
+    
+    // The definitions of x are kept, and w is a variable 
+    // of a constraint added later (e.g. the golden output)
+    std::set<unsigned> vars;
+    ConeOfInfluence::getVariables(w, vars);
+    unsigned nbHard = 0, nbSoft = 0;
+    ConeOfInfluence::reduce(f, vars, nbHard, nbSoft);
+    EXPECT_EQ(nbHard, 1);
+    EXPECT_EQ(nbSoft, 0);
+    std::vector<ExprPtr> exprs = f->getExprs();
+    EXPECT_EQ(exprs.size(), 3);
+    EXPECT_TRUE(std::find(exprs.begin(), exprs.end(), e3)==exprs.end());
+    
+    delete f;
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+    printf("Running main() from gtest_main.cc\n");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+/**
+ * \file DiagnosisReporterTest.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#include "Logic/DiagnosisReporter.h"
+#include "gtest/gtest.h"
+
+
+TEST(DiagnosisReporterTest, DiagnosisReporterLines) {
+    
+    // Sorted and unique line numbers, the expressions 
+    // without line number are ignored
+    std::vector<ExprPtr> es;
+    for (unsigned l : {34, 21, 0, 34}) {
+        ExprPtr a = Expression::mkBoolVar("a");
+        a->setLine(l);
+        es.push_back(a);
+    }
+    EXPECT_EQ(DiagnosisReporter::linesToJSON(es), "[21, 34]");
+    EXPECT_EQ(DiagnosisReporter::linesToJSON(std::vector<ExprPtr>()), "[]");
+}
+
+TEST(DiagnosisReporterTest, DiagnosisReporterStream) {
+    
+    // Disabled: nothing is written
+    EXPECT_TRUE(DiagnosisReporter::open(""));
+    EXPECT_FALSE(DiagnosisReporter::isEnabled());
+    
+    char filename[] = "/tmp/sniper_stream_XXXXXX";
+    int tmp = mkstemp(filename);
+    ASSERT_GE(tmp, 0);
+    close(tmp);
+    EXPECT_TRUE(DiagnosisReporter::open(filename));
+    EXPECT_TRUE(DiagnosisReporter::isEnabled());
+    
+    // One MCS {21} for the trace 3, then the combined diagnoses
+    ExprPtr a = Expression::mkBoolVar("a");
+    a->setLine(21);
+    std::vector<ExprPtr> mcs(1, a);
+    DiagnosisReporter::setTraceID(3);
+    DiagnosisReporter::reportMCS(mcs);
+    DiagnosisReporter::reportTrace(3, 1, true, false);
+    DiagnosisReporter::reportMUS(3, mcs, true);
+    SetOfFormulasPtr D = SetOfFormulas::make();
+    D->add(std::make_shared<Formula>(mcs));
+    DiagnosisReporter::reportDiagnoses("PWU", D);
+    DiagnosisReporter::reportDone(1, 1, 1);
+    DiagnosisReporter::close();
+    EXPECT_FALSE(DiagnosisReporter::isEnabled());
+    
+    std::ifstream in(filename);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    unlink(filename);
+    ASSERT_EQ(lines.size(), 5);
+    EXPECT_EQ(lines[0].find("{\"event\": \"mcs\", \"trace\": 3, \"lines\": [21]"), 0);
+    EXPECT_EQ(lines[1].find("{\"event\": \"trace\", \"trace\": 3, \"mcses\": 1, \"complete\": true"), 0);
+    EXPECT_EQ(lines[2].find("{\"event\": \"mus\", \"trace\": 3, \"lines\": [21], \"minimal\": true"), 0);
+    EXPECT_EQ(lines[3].find("{\"event\": \"diagnosis\", \"method\": \"PWU\", \"lines\": [21]"), 0);
+    EXPECT_EQ(lines[4].find("{\"event\": \"done\", \"traces\": 1, \"mcses\": 1, \"diagnoses\": 1"), 0);
+    for (std::string &l : lines) {
+        EXPECT_NE(l.find("\"elapsed_ms\": "), std::string::npos);
+        EXPECT_EQ(l[l.size()-1], '}');
+    }
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+    printf("Running main() from gtest_main.cc\n");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
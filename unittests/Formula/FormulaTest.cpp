@@ -206,6 +206,17 @@ TEST(FormulaTest, FormulaBase) {
     f6->add(E4);
     EXPECT_EQ(f6->size(), 3);
     
+    // Inclusion does not depend on the order of the expressions
+    // -> {a,c} and {c,a} are subsets of {a,b,c}, {a,d} is not
+    FormulaPtr f7 = std::make_shared<Formula>(f6);
+    FormulaPtr f8 = Formula::make();
+    f8->add(e3);
+    f8->add(e1);
+    EXPECT_TRUE(f7->contains(f8));
+    EXPECT_FALSE(f8->contains(f7));
+    f8->add(Expression::mkBoolVar("d"));
+    EXPECT_FALSE(f7->contains(f8));
+    
     delete f;
     delete f2;
     delete f4;
@@ -354,6 +365,73 @@ TEST(FormulaTest, SetOfFormulasBase) {
     //delete se0;
 }
 
+TEST(FormulaTest, SetOfFormulasSort) {
+    
+    // Soft expressions
+    ExprPtr a = Expression::mkBoolVar("a");
+    ExprPtr b = Expression::mkBoolVar("b");
+    ExprPtr c = Expression::mkBoolVar("c");
+    ExprPtr d = Expression::mkBoolVar("d");
+    ExprPtr e = Expression::mkBoolVar("e");
+    std::vector<ExprPtr> order = {a, b, c, d, e};
+    
+    // MCSes of a trace without reuse: {c}, {b,a}, {e,d}
+    SetOfFormulasPtr M1 = SetOfFormulas::make();
+    M1->add(std::make_shared<Formula>(std::vector<ExprPtr>({c})));
+    M1->add(std::make_shared<Formula>(std::vector<ExprPtr>({b, a})));
+    M1->add(std::make_shared<Formula>(std::vector<ExprPtr>({e, d})));
+    
+    // Same MCSes with reuse: the reused {d,e} and {c} 
+    // first, then the enumerated {a,b}
+    SetOfFormulasPtr M2 = SetOfFormulas::make();
+    M2->add(std::make_shared<Formula>(std::vector<ExprPtr>({d, e})));
+    M2->add(std::make_shared<Formula>(std::vector<ExprPtr>({c})));
+    M2->add(std::make_shared<Formula>(std::vector<ExprPtr>({a, b})));
+    
+    // Same order once sorted: {c}, {a,b}, {d,e}
+    M1->sort(order);
+    M2->sort(order);
+    ASSERT_EQ(M1->size(), 3);
+    ASSERT_EQ(M2->size(), 3);
+    for (unsigned i=0; i<3; i++) {
+        EXPECT_TRUE(M1->getAt(i)->getExprs()==M2->getAt(i)->getExprs());
+    }
+    EXPECT_TRUE(M1->getAt(0)->getExprs()==std::vector<ExprPtr>({c}));
+    EXPECT_TRUE(M1->getAt(1)->getExprs()==std::vector<ExprPtr>({a, b}));
+    EXPECT_TRUE(M1->getAt(2)->getExprs()==std::vector<ExprPtr>({d, e}));
+    
+    // With weights, the strata come first: {a,b} (weight 1) 
+    // before {c} (weight 2) and {d,e} (weight 3)
+    c->setWeight(2);
+    e->setWeight(3);
+    M1->sort(order);
+    EXPECT_TRUE(M1->getAt(0)->getExprs()==std::vector<ExprPtr>({a, b}));
+    EXPECT_TRUE(M1->getAt(1)->getExprs()==std::vector<ExprPtr>({c}));
+    EXPECT_TRUE(M1->getAt(2)->getExprs()==std::vector<ExprPtr>({d, e}));
+    
+}
+
+TEST(FormulaTest, SetOfFormulasAddMinimal) {
+    
+    ExprPtr a = Expression::mkBoolVar("a");
+    ExprPtr b = Expression::mkBoolVar("b");
+    ExprPtr c = Expression::mkBoolVar("c");
+    ExprPtr d = Expression::mkBoolVar("d");
+    std::vector<ExprPtr> order = {a, b, c, d};
+    
+    // Only the minimal sets are kept, whatever the order
+    SetOfFormulasPtr M3 = SetOfFormulas::make();
+    M3->addMinimal(std::make_shared<Formula>(std::vector<ExprPtr>({a, b})));
+    M3->addMinimal(std::make_shared<Formula>(std::vector<ExprPtr>({a})));
+    M3->addMinimal(std::make_shared<Formula>(std::vector<ExprPtr>({c, a})));
+    M3->addMinimal(std::make_shared<Formula>(std::vector<ExprPtr>({d, c})));
+    M3->addMinimal(std::make_shared<Formula>(std::vector<ExprPtr>({c, d})));
+    M3->sort(order);
+    ASSERT_EQ(M3->size(), 2);
+    EXPECT_TRUE(M3->getAt(0)->getExprs()==std::vector<ExprPtr>({a}));
+    EXPECT_TRUE(M3->getAt(1)->getExprs()==std::vector<ExprPtr>({c, d}));
+    
+}
 
 GTEST_API_ int main(int argc, char **argv) {
     printf("Running main() from gtest_main.cc\n");
@@ -0,0 +1,129 @@
+/**
+ * \file PreprocessorTest.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+
+#include <stdio.h>
+
+#include "Logic/Preprocessor.h"
+#include "gtest/gtest.h"
+
+
+TEST(PreprocessorTest, PreprocessorSimplify) {
+    
+    // (and true (> (+ 1 2) a)) -> (> 3 a)
+    IntVarExprPtr a = Expression::mkIntVar("pp_a");
+    ExprPtr one  = Expression::mkSInt32Num(1);
+    ExprPtr two  = Expression::mkSInt32Num(2);
+    ExprPtr e1 = Expression::mkAnd(Expression::mkTrue(), 
+                                   Expression::mkGt(Expression::mkSum(one, two), a));
+    std::map<unsigned, ExprPtr> subst;
+    ExprPtr r1 = Preprocessor::simplify(e1, subst);
+    ASSERT_TRUE(r1->getOpCode()==Expression::Gt);
+    GtExprPtr gt = std::static_pointer_cast<GtExpression>(r1);
+    ASSERT_TRUE(gt->getExpr1()->getOpCode()==Expression::SInt32Num);
+    SInt32NumExprPtr n = std::static_pointer_cast<SInt32NumExpression>(gt->getExpr1());
+    EXPECT_EQ(n->getValue(), 3);
+    
+    // a = 3: (> 3 a) -> false, (ite (= a 3) a 0) -> 3
+    subst[a->getNameID()] = Expression::mkSInt32Num(3);
+    EXPECT_TRUE(Preprocessor::simplify(r1, subst)->getOpCode()==Expression::False);
+    ExprPtr e2 = Expression::mkIte(Expression::mkEq(a, Expression::mkSInt32Num(3)), 
+                                   a, Expression::mkSInt32Num(0));
+    ExprPtr r2 = Preprocessor::simplify(e2, subst);
+    ASSERT_TRUE(r2->getOpCode()==Expression::SInt32Num);
+    EXPECT_EQ(std::static_pointer_cast<SInt32NumExpression>(r2)->getValue(), 3);
+    
+    // Unchanged expression
+    subst.clear();
+    ExprPtr e3 = Expression::mkLt(a, one);
+    EXPECT_EQ(Preprocessor::simplify(e3, subst).get(), e3.get());
+}
+
+TEST(PreprocessorTest, PreprocessorRun) {
+    
+    // x = a + b   (hard)
+    // y = x       (hard)
+    // z = y * 2   (soft, line 7)
+    // (> z c)     (hard, post-condition)
+    // w = b       (hard, w is frozen)
+    IntVarExprPtr a = Expression::mkIntVar("pp_a");
+    IntVarExprPtr b = Expression::mkIntVar("pp_b");
+    IntVarExprPtr c = Expression::mkIntVar("pp_c");
+    IntVarExprPtr w = Expression::mkIntVar("pp_w");
+    IntVarExprPtr x = Expression::mkIntVar("pp_x");
+    IntVarExprPtr y = Expression::mkIntVar("pp_y");
+    IntVarExprPtr z = Expression::mkIntVar("pp_z");
+    ExprPtr e1 = Expression::mkEq(x, Expression::mkSum(a, b));
+    ExprPtr e2 = Expression::mkEq(y, x);
+    ExprPtr e3 = Expression::mkEq(z, Expression::mkMul(y, Expression::mkSInt32Num(2)));
+    ExprPtr e4 = Expression::mkGt(z, c);
+    ExprPtr e5 = Expression::mkEq(w, b);
+    e1->setHard();
+    e2->setHard();
+    e3->setSoft();
+    e3->setLine(7);
+    e3->setWeight(2);
+    e4->setHard();
+    e5->setHard();
+    Formula *f = new Formula();
+    f->add(e1);
+    f->add(e2);
+    f->add(e3);
+    f->add(e4);
+    f->add(e5);
+    
+    // x and y are substituted away, a = 1 and b = 2 are propagated:
+    // z = 6 (soft, line 7), (> z c), w = 2
+    std::set<unsigned> frozen;
+    frozen.insert(w->getNameID());
+    std::map<unsigned, int> constants;
+    constants[a->getNameID()] = 1;
+    constants[b->getNameID()] = 2;
+    unsigned nbHard = 0, nbSoft = 0;
+    Preprocessor::run(f, frozen, constants, nbHard, nbSoft);
+    EXPECT_EQ(nbHard, 2);
+    EXPECT_EQ(nbSoft, 0);
+    std::vector<ExprPtr> exprs = f->getExprs();
+    ASSERT_EQ(exprs.size(), 3);
+    EXPECT_TRUE(exprs[0]->isSoft());
+    EXPECT_EQ(exprs[0]->getLine(), 7);
+    EXPECT_EQ(exprs[0]->getWeight(), 2);
+    ASSERT_TRUE(exprs[0]->getOpCode()==Expression::Eq);
+    EqExprPtr eq = std::static_pointer_cast<EqExpression>(exprs[0]);
+    ASSERT_TRUE(eq->getExpr2()->getOpCode()==Expression::SInt32Num);
+    EXPECT_EQ(std::static_pointer_cast<SInt32NumExpression>(eq->getExpr2())->getValue(), 6);
+    EXPECT_EQ(exprs[1].get(), e4.get());
+    EXPECT_TRUE(exprs[2]->isHard());
+    
+    delete f;
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+    printf("Running main() from gtest_main.cc\n");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
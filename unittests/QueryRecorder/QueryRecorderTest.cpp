@@ -0,0 +1,111 @@
+/**
+ * \file QueryRecorderTest.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+
+#include "Logic/QueryRecorder.h"
+#include "Logic/SolverStats.h"
+#include "gtest/gtest.h"
+
+
+TEST(QueryRecorderTest, QueryRecorderWrite) {
+    
+    // (x > -3) as hard, (not p) as soft
+    IntVarExprPtr x = Expression::mkIntVar("x");
+    BoolVarExprPtr p = Expression::mkBoolVar("p");
+    ExprPtr e1 = Expression::mkGt(x, Expression::mkSInt32Num(-3));
+    ExprPtr e2 = Expression::mkNot(p);
+    EXPECT_EQ(QueryRecorder::toSMTLIB2(e1), "(> x (- 3))");
+    EXPECT_EQ(QueryRecorder::toSMTLIB2(Expression::mkBoolVar("a:1")), "|a:1|");
+    
+    std::vector<ExprPtr> hard(1, e1), soft(1, e2);
+    std::ostringstream oss;
+    QueryRecorder::write(oss, true, hard, soft, "mcs", 2);
+    std::string s = oss.str();
+    EXPECT_EQ(s.find("; query: maxsat\n; phase: mcs\n; trace: 2\n"), 0);
+    EXPECT_NE(s.find("(declare-fun x () Int)"), std::string::npos);
+    EXPECT_NE(s.find("(declare-fun p () Bool)"), std::string::npos);
+    EXPECT_NE(s.find("(assert (> x (- 3)))"), std::string::npos);
+    EXPECT_NE(s.find("(assert-soft (not p) :weight 1)"), std::string::npos);
+    EXPECT_NE(s.find("(check-sat)"), std::string::npos);
+}
+
+TEST(QueryRecorderTest, QueryRecorderRecordLoad) {
+    
+    // Record a query
+    EXPECT_TRUE(QueryRecorder::setDirectory("queryrecorder_test"));
+    EXPECT_TRUE(QueryRecorder::isEnabled());
+    SolverStats::setPhase(SolverStats::MCS);
+    QueryRecorder::setTraceID(0);
+    IntVarExprPtr x = Expression::mkIntVar("x");
+    IntToIntVarExprPtr m = Expression::mkIntToIntVar("m");
+    BoolVarExprPtr p = Expression::mkBoolVar("p");
+    ExprPtr upd = Expression::mkFunctionUpdate(m, x, Expression::mkSInt32Num(1));
+    ExprPtr e1 = Expression::mkEq(Expression::mkApp(upd, x),
+                                  Expression::mkSum(x, Expression::mkSInt32Num(-2)));
+    ExprPtr e2 = Expression::mkOr(p, Expression::mkLe(x, Expression::mkSInt32Num(0)));
+    ExprPtr e3 = Expression::mkNot(p);
+    e3->setWeight(3);
+    std::vector<ExprPtr> hard, soft;
+    hard.push_back(e1);
+    soft.push_back(e2);
+    soft.push_back(e3);
+    std::string f = QueryRecorder::record(true, hard, soft);
+    EXPECT_EQ(f, "queryrecorder_test/q000000_mcs_t0_maxsat.smt2");
+    EXPECT_EQ(QueryRecorder::getNbQueries(), 1);
+    
+    // Load it back
+    std::vector<ExprPtr> hard2, soft2;
+    bool isMaxSat = false;
+    EXPECT_TRUE(QueryRecorder::load(f, hard2, soft2, isMaxSat));
+    EXPECT_TRUE(isMaxSat);
+    // Hard: the 32-bit range of x and e1
+    ASSERT_EQ(hard2.size(), 2);
+    ASSERT_EQ(soft2.size(), 2);
+    EXPECT_TRUE(hard2[1]->isHard());
+    EXPECT_TRUE(soft2[0]->isSoft());
+    EXPECT_EQ(QueryRecorder::toSMTLIB2(hard2[1]), QueryRecorder::toSMTLIB2(e1));
+    EXPECT_EQ(QueryRecorder::toSMTLIB2(soft2[0]), QueryRecorder::toSMTLIB2(e2));
+    EXPECT_EQ(QueryRecorder::toSMTLIB2(soft2[1]), QueryRecorder::toSMTLIB2(e3));
+    EXPECT_EQ(soft2[0]->getWeight(), 1);
+    EXPECT_EQ(soft2[1]->getWeight(), 3);
+    
+    remove(f.c_str());
+    rmdir("queryrecorder_test");
+    QueryRecorder::setDirectory("");
+    QueryRecorder::setTraceID(-1);
+    SolverStats::reset();
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+    printf("Running main() from gtest_main.cc\n");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,270 @@
+/**
+ * \file SATSolverTest.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+#include <stdio.h>
+#include <sstream>
+#include <algorithm>
+
+#include "Logic/SATSolver.h"
+#include "gtest/gtest.h"
+
+
+TEST(SATSolverTest, SATSolverCheck) {
+    
+    // Create a solver
+    SATSolver *solver = new SATSolver();
+    solver->init();
+    
+    // Check (a and (a -> b)) -> SAT with b true
+    BoolVarExprPtr a = Expression::mkBoolVar("a");
+    BoolVarExprPtr b = Expression::mkBoolVar("b");
+    ExprPtr e1 = Expression::mkOr(Expression::mkNot(a), b);
+    solver->addToContext(a);
+    solver->addToContext(e1);
+    EXPECT_EQ(solver->check(), SolverBackend::True);
+    EXPECT_EQ(solver->getBoolValue(a->getNameID()), SolverBackend::True);
+    EXPECT_EQ(solver->getBoolValue("b"), SolverBackend::True);
+    
+    // Check (a and (a -> b) and (not b)) -> UNSAT
+    solver->addToContext(Expression::mkNot(b));
+    EXPECT_EQ(solver->check(), SolverBackend::False);
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(SATSolverTest, SATSolverPigeonHole) {
+    
+    // Create a solver
+    SATSolver *solver = new SATSolver();
+    solver->init();
+    
+    // 5 pigeons in 4 holes -> UNSAT
+    const unsigned P = 5, H = 4;
+    std::vector<std::vector<ExprPtr> > x(P);
+    for (unsigned i=0; i<P; i++) {
+        for (unsigned j=0; j<H; j++) {
+            std::ostringstream oss;
+            oss << "p" << i << "h" << j;
+            x[i].push_back(Expression::mkBoolVar(oss.str()));
+        }
+        solver->addToContext(Expression::mkOr(x[i]));
+    }
+    for (unsigned j=0; j<H; j++) {
+        for (unsigned i1=0; i1<P; i1++) {
+            for (unsigned i2=i1+1; i2<P; i2++) {
+                ExprPtr e = Expression::mkOr(Expression::mkNot(x[i1][j]),
+                                             Expression::mkNot(x[i2][j]));
+                solver->addToContext(e);
+            }
+        }
+    }
+    EXPECT_EQ(solver->check(), SolverBackend::False);
+    EXPECT_GT(solver->getNbConflicts(), 0);
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(SATSolverTest, SATSolverMaxsat) {
+    
+    // Create a solver
+    SATSolver *solver = new SATSolver();
+    solver->init();
+    
+    // MaxSAT a, b, (not a), (not b) as soft and (a xor b) as hard
+    // -> SAT with a cost of 2
+    ExprPtr a = Expression::mkBoolVar("a");
+    ExprPtr b = Expression::mkBoolVar("b");
+    ExprPtr e1 = Expression::mkNot(a);
+    ExprPtr e2 = Expression::mkNot(b);
+    ExprPtr e3 = Expression::mkXor(a, b);
+    a->setSoft();
+    b->setSoft();
+    e1->setSoft();
+    e2->setSoft();
+    e3->setHard();
+    solver->addToContext(a);
+    solver->addToContext(b);
+    solver->addToContext(e1);
+    solver->addToContext(e2);
+    solver->addToContext(e3);
+    EXPECT_EQ(solver->maxSat(), SolverBackend::True);
+    EXPECT_EQ(solver->getCostAsDouble(), 2.0);
+    EXPECT_EQ(solver->getUnsatExpressions().size(), 2);
+    EXPECT_EQ(solver->getSatExpressions().size(), 2);
+    
+    // The hard part is unsatisfiable -> UNSAT
+    ExprPtr e4 = Expression::mkAnd(a, b);
+    e4->setHard();
+    solver->addToContext(e4);
+    EXPECT_EQ(solver->maxSat(), SolverBackend::False);
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(SATSolverTest, SATSolverMaxsatRepeated) {
+
+    // Create a solver
+    SATSolver *solver = new SATSolver();
+    solver->init();
+
+    // Same problem as SATSolverMaxsat, solved several times:
+    // the clauses of the relaxations are not accumulated
+    ExprPtr a = Expression::mkBoolVar("a");
+    ExprPtr b = Expression::mkBoolVar("b");
+    ExprPtr e1 = Expression::mkNot(a);
+    ExprPtr e2 = Expression::mkNot(b);
+    ExprPtr e3 = Expression::mkXor(a, b);
+    a->setSoft();
+    b->setSoft();
+    e1->setSoft();
+    e2->setSoft();
+    e3->setHard();
+    solver->addToContext(a);
+    solver->addToContext(b);
+    solver->addToContext(e1);
+    solver->addToContext(e2);
+    solver->addToContext(e3);
+    EXPECT_EQ(solver->maxSat(), SolverBackend::True);
+    EXPECT_EQ(solver->getCostAsDouble(), 2.0);
+    const unsigned nbClauses = solver->getNbClauses();
+    for (unsigned i=0; i<10; i++) {
+        EXPECT_EQ(solver->maxSat(), SolverBackend::True);
+        EXPECT_EQ(solver->getCostAsDouble(), 2.0);
+    }
+    EXPECT_LE(solver->getNbClauses(), nbClauses);
+
+    // A new soft expression is taken into account: (a or b) and
+    // (not a) and (not b) cannot be satisfied together
+    ExprPtr e4 = Expression::mkOr(a, b);
+    e4->setSoft();
+    solver->addToContext(e4);
+    EXPECT_EQ(solver->maxSat(), SolverBackend::True);
+    EXPECT_EQ(solver->getCostAsDouble(), 2.0);
+    EXPECT_EQ(solver->getUnsatExpressions().size(), 2);
+
+    solver->clean();
+    delete solver;
+}
+
+TEST(SATSolverTest, SATSolverPushPop) {
+    
+    // Create a solver
+    SATSolver *solver = new SATSolver();
+    solver->init();
+    
+    // a or b
+    ExprPtr a = Expression::mkBoolVar("a");
+    ExprPtr b = Expression::mkBoolVar("b");
+    ExprPtr e1 = Expression::mkOr(a, b);
+    e1->setHard();
+    solver->addToContext(e1);
+    EXPECT_EQ(solver->check(), SolverBackend::True);
+    
+    // (a or b) and (not a) and (not b) -> UNSAT
+    solver->push();
+    ExprPtr e2 = Expression::mkNot(a);
+    ExprPtr e3 = Expression::mkNot(b);
+    e2->setHard();
+    e3->setHard();
+    solver->addToContext(e2);
+    solver->addToContext(e3);
+    EXPECT_EQ(solver->check(), SolverBackend::False);
+    solver->pop();
+    
+    // Back to (a or b)
+    EXPECT_EQ(solver->check(), SolverBackend::True);
+    
+    // Soft expressions added after a push are removed by pop
+    solver->push();
+    ExprPtr na = Expression::mkNot(a);
+    na->setSoft();
+    solver->addToContext(na);
+    EXPECT_EQ(solver->maxSat(), SolverBackend::True);
+    EXPECT_EQ(solver->getSatExpressions().size(), 1);
+    solver->pop();
+    EXPECT_EQ(solver->maxSat(), SolverBackend::True);
+    EXPECT_EQ(solver->getSatExpressions().size(), 0);
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(SATSolverTest, SATSolverRetract) {
+
+    // Create a solver
+    SATSolver *solver = new SATSolver();
+    solver->init();
+
+    // (a or b) and retractable (not a), (not b), c
+    ExprPtr a = Expression::mkBoolVar("a");
+    ExprPtr b = Expression::mkBoolVar("b");
+    ExprPtr c = Expression::mkBoolVar("c");
+    ExprPtr e1 = Expression::mkOr(a, b);
+    e1->setHard();
+    solver->addToContext(e1);
+    SolverBackend::AssertionID i1 =
+        solver->addRetractable(Expression::mkNot(a));
+    SolverBackend::AssertionID i2 =
+        solver->addRetractable(Expression::mkNot(b));
+    SolverBackend::AssertionID i3 = solver->addRetractable(c);
+
+    // UNSAT with the core {(not a), (not b)}
+    EXPECT_EQ(solver->check(), SolverBackend::False);
+    std::vector<SolverBackend::AssertionID> core = solver->getUnsatCore();
+    EXPECT_EQ(core.size(), 2);
+    EXPECT_TRUE(std::find(core.begin(), core.end(), i1)!=core.end());
+    EXPECT_TRUE(std::find(core.begin(), core.end(), i2)!=core.end());
+    EXPECT_TRUE(std::find(core.begin(), core.end(), i3)==core.end());
+
+    // Retracting (not b) -> SAT with b and c true
+    solver->retract(i2);
+    EXPECT_EQ(solver->check(), SolverBackend::True);
+    EXPECT_EQ(solver->evaluate(b), SolverBackend::True);
+    EXPECT_EQ(solver->evaluate(Expression::mkAnd(b, c)), SolverBackend::True);
+    EXPECT_EQ(solver->evaluate(Expression::mkXor(a, b)), SolverBackend::True);
+    EXPECT_EQ(solver->evaluate(Expression::mkBoolVar("d")),
+              SolverBackend::Undef);
+
+    // Retractable assertions made after a push are removed by pop
+    solver->push();
+    solver->addRetractable(Expression::mkNot(c));
+    EXPECT_EQ(solver->check(), SolverBackend::False);
+    solver->pop();
+    EXPECT_EQ(solver->check(), SolverBackend::True);
+    
+    solver->clean();
+    delete solver;
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+    printf("Running main() from gtest_main.cc\n");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,131 @@
+/**
+ * \file SolverStatsTest.cpp
+ *
+ * ----------------------------------------------------------------------
+ *                SNIPER : Automatic Fault Localization 
+ *
+ * Copyright (C) 2016 Si-Mohamed LAMRAOUI
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program (see LICENSE.TXT).  
+ * If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------------------
+ *
+ * \author Si-Mohamed Lamraoui
+ * \date   18 October 2016
+ */
+
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+
+#include "Logic/SATSolver.h"
+#include "Logic/SolverStats.h"
+#include "gtest/gtest.h"
+
+
+TEST(SolverStatsTest, SolverStatsRecord) {
+    
+    SolverStats::reset();
+    
+    // Queries are recorded in the current phase
+    SolverStats::record(false, 0.5, 10, 0, 4, SolverBackend::True);
+    EXPECT_EQ(SolverStats::getNbQueries(SolverStats::OTHER), 1);
+    unsigned old = SolverStats::setPhase(SolverStats::MCS);
+    EXPECT_EQ(old, SolverStats::OTHER);
+    SolverStats::record(true, 2.0, 10, 5, 4, SolverBackend::True);
+    SolverStats::record(true, 20.0, 11, 5, 4, SolverBackend::False);
+    EXPECT_EQ(SolverStats::getNbQueries(SolverStats::MCS), 2);
+    EXPECT_EQ(SolverStats::getNbResults(SolverStats::MCS,
+                                        SolverBackend::True), 1);
+    EXPECT_EQ(SolverStats::getNbResults(SolverStats::MCS,
+                                        SolverBackend::False), 1);
+    EXPECT_EQ(SolverStats::getNbResults(SolverStats::MCS,
+                                        SolverBackend::Undef), 0);
+    EXPECT_EQ(SolverStats::getNbQueries(SolverStats::BMC), 0);
+    
+    // Report and export
+    std::ostringstream oss;
+    SolverStats::printReport(oss);
+    EXPECT_NE(oss.str().find("[mcs] max-sat"), std::string::npos);
+    EXPECT_EQ(oss.str().find("[bmc]"), std::string::npos);
+    EXPECT_TRUE(SolverStats::exportJSON("solverstats_test.json"));
+    std::ifstream in("solverstats_test.json");
+    std::string json((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    EXPECT_NE(json.find("\"phase\": \"mcs\""), std::string::npos);
+    remove("solverstats_test.json");
+    
+    SolverStats::reset();
+    EXPECT_EQ(SolverStats::getNbQueries(SolverStats::MCS), 0);
+    EXPECT_EQ(SolverStats::getPhase(), SolverStats::OTHER);
+}
+
+TEST(SolverStatsTest, SolverStatsSATSolver) {
+    
+    SolverStats::reset();
+    SolverStats::setPhase(SolverStats::HITTINGSET);
+    
+    // Create a solver
+    SATSolver *solver = new SATSolver();
+    solver->init();
+    
+    // a and (not a) as soft: one check and one max-sat query
+    ExprPtr a = Expression::mkBoolVar("a");
+    ExprPtr e1 = Expression::mkNot(a);
+    a->setSoft();
+    e1->setSoft();
+    solver->addToContext(a);
+    solver->addToContext(e1);
+    EXPECT_EQ(solver->check(), SolverBackend::False);
+    EXPECT_EQ(solver->maxSat(), SolverBackend::True);
+    EXPECT_EQ(SolverStats::getNbQueries(SolverStats::HITTINGSET), 2);
+    EXPECT_EQ(SolverStats::getNbResults(SolverStats::HITTINGSET,
+                                        SolverBackend::False), 1);
+    
+    solver->clean();
+    delete solver;
+    SolverStats::reset();
+}
+
+TEST(SolverStatsTest, SolverStatsMerge) {
+    
+    SolverStats::reset();
+    SolverStats::setPhase(SolverStats::MCS);
+    SolverStats::record(true, 2.0, 10, 5, 4, SolverBackend::True);
+    SolverStats::record(true, 8.0, 12, 5, 4, SolverBackend::False);
+    
+    // Statistics of a worker merged twice into the parent
+    std::string buf;
+    SolverStats::save(buf);
+    SolverStats::reset();
+    SolverStats::record(false, 1.0, 3, 0, 2, SolverBackend::True);
+    size_t pos = 0;
+    EXPECT_TRUE(SolverStats::merge(buf, pos));
+    EXPECT_EQ(pos, buf.size());
+    pos = 0;
+    EXPECT_TRUE(SolverStats::merge(buf, pos));
+    EXPECT_FALSE(SolverStats::merge(buf, pos));
+    EXPECT_EQ(SolverStats::getNbQueries(SolverStats::MCS), 4);
+    EXPECT_EQ(SolverStats::getNbResults(SolverStats::MCS,
+                                        SolverBackend::False), 2);
+    EXPECT_EQ(SolverStats::getNbQueries(SolverStats::OTHER), 1);
+    
+    SolverStats::reset();
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+    printf("Running main() from gtest_main.cc\n");
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -26,6 +26,7 @@
  */
 
 #include <stdio.h>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -33,6 +34,7 @@
 #include "yices_c.h"
 
 #include "Logic/YicesSolver.h"
+#include "Logic/PortfolioSolver.h"
 #include "Logic/Expression.h"
 #include "gtest/gtest.h"
 
@@ -121,6 +123,342 @@ TEST(YicesSolverTest, YicesSolverMaxsat) {
     delete solver;
 }
 
+TEST(YicesSolverTest, YicesSolverTranslationCache) {
+    
+    // Create a solver
+    YicesSolver *solver = new YicesSolver();
+    solver->init();
+    
+    // (a or b) shared by two clauses: translated only once
+    ExprPtr a = Expression::mkBoolVar("a");
+    ExprPtr b = Expression::mkBoolVar("b");
+    ExprPtr c = Expression::mkBoolVar("c");
+    ExprPtr ab = Expression::mkOr(a, b);
+    ExprPtr e1 = Expression::mkAnd(ab, c);
+    ExprPtr e2 = Expression::mkNot(ab);
+    e1->setHard();
+    e2->setHard();
+    solver->addToContext(e1);
+    const unsigned misses1 = solver->getNbCacheMisses();
+    EXPECT_EQ(misses1, 5);
+    solver->addToContext(e2);
+    EXPECT_EQ(solver->getNbCacheHits(), 1);
+    EXPECT_EQ(solver->getNbCacheMisses(), misses1+1);
+    EXPECT_EQ(solver->check(), l_false);
+    
+    // Translations made after a push are forgotten on pop
+    solver->clean();
+    solver->init();
+    solver->push();
+    solver->addToContext(e1);
+    solver->pop();
+    const unsigned misses2 = solver->getNbCacheMisses();
+    solver->addToContext(e1);
+    EXPECT_EQ(solver->getNbCacheMisses(), misses2+5);
+    EXPECT_EQ(solver->check(), l_true);
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(YicesSolverTest, YicesSolverVarDeclTable) {
+    
+    // Create a solver
+    YicesSolver *solver = new YicesSolver();
+    solver->init();
+    
+    // x = 3 and p
+    IntVarExprPtr x = Expression::mkIntVar("x");
+    BoolVarExprPtr p = Expression::mkBoolVar("p");
+    ExprPtr e1 = Expression::mkEq(x, Expression::mkSInt32Num(3));
+    ExprPtr e2 = Expression::mkAnd(e1, p);
+    e2->setHard();
+    solver->addToContext(e2);
+    EXPECT_EQ(solver->check(), l_true);
+    
+    // Same values by name and by name ID
+    bool error = true;
+    EXPECT_EQ(solver->getValue(x->getNameID(), error), 3);
+    EXPECT_FALSE(error);
+    EXPECT_EQ(solver->getValue("x", error), 3);
+    EXPECT_FALSE(error);
+    EXPECT_EQ(solver->getBoolValue(p->getNameID()), l_true);
+    EXPECT_EQ(solver->getBoolValue("p"), l_true);
+    
+    // Variables with the same name share the same name ID
+    EXPECT_EQ(Expression::mkIntVar("x")->getNameID(), x->getNameID());
+    
+    // Undeclared variable
+    unsigned q = Expression::internName("q");
+    EXPECT_EQ(solver->getValueOrZero(q), 0);
+    solver->getValue(q, error);
+    EXPECT_TRUE(error);
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(YicesSolverTest, YicesSolverEvaluate) {
+    
+    // Create a solver
+    YicesSolver *solver = new YicesSolver();
+    solver->init();
+    
+    // a and (not b)
+    BoolVarExprPtr a = Expression::mkBoolVar("a");
+    BoolVarExprPtr b = Expression::mkBoolVar("b");
+    ExprPtr e1 = Expression::mkAnd(a, Expression::mkNot(b));
+    e1->setHard();
+    solver->addToContext(e1);
+    EXPECT_EQ(solver->check(), l_true);
+    EXPECT_EQ(solver->evaluate(Expression::mkOr(a, b)), l_true);
+    EXPECT_EQ(solver->evaluate(b), l_false);
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(YicesSolverTest, YicesSolverRetractable) {
+    
+    // Create a solver
+    YicesSolver *solver = new YicesSolver();
+    solver->init();
+    
+    // (not s or a) and (not a)
+    BoolVarExprPtr s = Expression::mkBoolVar("s");
+    BoolVarExprPtr a = Expression::mkBoolVar("a");
+    ExprPtr e1 = Expression::mkOr(Expression::mkNot(s), a);
+    ExprPtr e2 = Expression::mkNot(a);
+    e1->setHard();
+    e2->setHard();
+    solver->addToContext(e1);
+    solver->addToContext(e2);
+    EXPECT_EQ(solver->check(), l_true);
+    
+    // Enabling the selector s makes the context unsatisfiable
+    assertion_id i = solver->addRetractable(s);
+    EXPECT_EQ(solver->check(), l_false);
+    
+    // Disabling it restores satisfiability
+    solver->retract(i);
+    EXPECT_EQ(solver->check(), l_true);
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(YicesSolverTest, YicesSolverUnsatCore) {
+    
+    // Create a solver
+    YicesSolver *solver = new YicesSolver();
+    solver->init();
+    
+    // (not a or b) with a, c and (not b) as assumptions
+    BoolVarExprPtr a = Expression::mkBoolVar("a");
+    BoolVarExprPtr b = Expression::mkBoolVar("b");
+    BoolVarExprPtr c = Expression::mkBoolVar("c");
+    ExprPtr e1 = Expression::mkOr(Expression::mkNot(a), b);
+    e1->setHard();
+    solver->addToContext(e1);
+    assertion_id i1 = solver->addRetractable(a);
+    assertion_id i2 = solver->addRetractable(c);
+    assertion_id i3 = solver->addRetractable(Expression::mkNot(b));
+    EXPECT_EQ(solver->check(), l_false);
+    
+    // The core contains a and (not b), but not c
+    std::vector<assertion_id> core = solver->getUnsatCore();
+    EXPECT_NE(std::find(core.begin(), core.end(), i1), core.end());
+    EXPECT_EQ(std::find(core.begin(), core.end(), i2), core.end());
+    EXPECT_NE(std::find(core.begin(), core.end(), i3), core.end());
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(YicesSolverTest, YicesSolverCardinalityBound) {
+    
+    // Create a solver
+    YicesSolver *solver = new YicesSolver();
+    solver->init();
+    
+    // (a or b or c) with (<= (+ (ite a 1 0) (ite b 1 0) (ite c 1 0)) k)
+    std::vector<ExprPtr> vars, terms;
+    vars.push_back(Expression::mkBoolVar("a"));
+    vars.push_back(Expression::mkBoolVar("b"));
+    vars.push_back(Expression::mkBoolVar("c"));
+    for (ExprPtr v : vars) {
+        terms.push_back(Expression::mkIte(v, Expression::mkSInt32Num(1),
+                                          Expression::mkSInt32Num(0)));
+    }
+    ExprPtr e1 = Expression::mkOr(vars);
+    e1->setHard();
+    solver->addToContext(e1);
+    ExprPtr sum = Expression::mkSum(terms);
+    
+    // k=0 -> UNSAT
+    ExprPtr b0 = Expression::mkLe(sum, Expression::mkSInt32Num(0));
+    b0->setHard();
+    assertion_id i = solver->addRetractable(b0);
+    EXPECT_EQ(solver->check(), l_false);
+    solver->retract(i);
+    
+    // k=1 and (a and b) -> UNSAT, k=1 and a -> SAT with b false
+    ExprPtr b1 = Expression::mkLe(sum, Expression::mkSInt32Num(1));
+    b1->setHard();
+    i = solver->addRetractable(b1);
+    assertion_id j = solver->addRetractable(Expression::mkAnd(vars[0], vars[1]));
+    EXPECT_EQ(solver->check(), l_false);
+    solver->retract(j);
+    j = solver->addRetractable(vars[0]);
+    EXPECT_EQ(solver->check(), l_true);
+    EXPECT_EQ(solver->evaluate(vars[1]), l_false);
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(YicesSolverTest, YicesSolverCoreGuidedMaxsat) {
+    
+    // Create a solver using the core-guided max-sat
+    YicesSolver *solver = new YicesSolver();
+    solver->setMaxSatAlgorithm(YicesSolver::CORE);
+    solver->init();
+    
+    // MaxSAT (a and b and (not a)) -> SAT with a cost of 1
+    ExprPtr e1 = Expression::mkBoolVar("a");
+    ExprPtr e2 = Expression::mkBoolVar("b");
+    ExprPtr e3 = Expression::mkNot(e1);
+    e1->setSoft();
+    e2->setSoft();
+    e3->setSoft();
+    solver->addToContext(e1);
+    solver->addToContext(e2);
+    solver->addToContext(e3);
+    EXPECT_EQ(solver->maxSat(), l_true);
+    EXPECT_EQ(solver->getCostAsDouble(), 1.0);
+    EXPECT_EQ(solver->getUnsatExpressions().size(), 1);
+    EXPECT_EQ(solver->getSatExpressions().size(), 2);
+    
+    // Soft expressions are enforced by check
+    EXPECT_EQ(solver->check(), l_false);
+    
+    // Soft expressions added after a push are removed by pop
+    solver->push();
+    ExprPtr e4 = Expression::mkNot(e2);
+    e4->setSoft();
+    solver->addToContext(e4);
+    EXPECT_EQ(solver->maxSat(), l_true);
+    EXPECT_EQ(solver->getCostAsDouble(), 2.0);
+    solver->pop();
+    EXPECT_EQ(solver->maxSat(), l_true);
+    EXPECT_EQ(solver->getCostAsDouble(), 1.0);
+    
+    // MaxSAT with (a and (not a)) as hard -> UNSAT
+    solver->clean();
+    solver->init();
+    e1->setHard();
+    e3->setHard();
+    solver->addToContext(e1);
+    solver->addToContext(e2);
+    solver->addToContext(e3);
+    EXPECT_EQ(solver->maxSat(), l_false);
+    
+    solver->clean();
+    delete solver;
+}
+
+TEST(YicesSolverTest, YicesSolverPortfolio) {
+    
+    // Create a solver
+    YicesSolver *solver = new YicesSolver();
+    solver->init();
+    
+    // MaxSAT (a and b and (not a)) -> SAT with a cost of 1
+    ExprPtr e1 = Expression::mkBoolVar("a");
+    ExprPtr e2 = Expression::mkBoolVar("b");
+    ExprPtr e3 = Expression::mkNot(e1);
+    e1->setSoft();
+    e2->setSoft();
+    e3->setSoft();
+    solver->addToContext(e1);
+    solver->addToContext(e2);
+    solver->addToContext(e3);
+    
+    // Both configurations give the same cost
+    PortfolioSolver *portfolio = new PortfolioSolver(2);
+    EXPECT_EQ(portfolio->getNbWorkers(), 2);
+    EXPECT_EQ(portfolio->maxSat(solver), l_true);
+    EXPECT_EQ(portfolio->getCostAsDouble(), 1.0);
+    std::vector<ExprPtr> U = portfolio->getUnsatExpressions();
+    ASSERT_EQ(U.size(), 1);
+    EXPECT_TRUE(U[0]==e1 || U[0]==e3);
+    EXPECT_EQ(portfolio->getNbWins(PortfolioSolver::YICES_MAXSAT)
+              +portfolio->getNbWins(PortfolioSolver::CORE_MAXSAT), 1);
+    
+    // The context of the current process is unchanged
+    EXPECT_EQ(solver->getMaxSatAlgorithm(), YicesSolver::NATIVE);
+    EXPECT_EQ(solver->maxSat(), l_true);
+    EXPECT_EQ(solver->getCostAsDouble(), 1.0);
+    
+    // Switching the algorithm keeps the soft expressions
+    solver->convertMaxSatAlgorithm(YicesSolver::CORE);
+    EXPECT_EQ(solver->getSoftExpressions().size(), 3);
+    EXPECT_EQ(solver->maxSat(), l_true);
+    EXPECT_EQ(solver->getCostAsDouble(), 1.0);
+    
+    delete portfolio;
+    solver->clean();
+    delete solver;
+}
+
+TEST(YicesSolverTest, YicesSolverPortfolioBudget) {
+    
+    // Create a solver
+    YicesSolver *solver = new YicesSolver();
+    solver->init();
+    
+    // 12 pigeons in 11 holes (hard) and a soft expression
+    const unsigned P = 12, H = 11;
+    std::vector<std::vector<ExprPtr> > x(P);
+    for (unsigned i=0; i<P; i++) {
+        for (unsigned j=0; j<H; j++) {
+            std::ostringstream oss;
+            oss << "p" << i << "h" << j;
+            x[i].push_back(Expression::mkBoolVar(oss.str()));
+        }
+        ExprPtr e = Expression::mkOr(x[i]);
+        e->setHard();
+        solver->addToContext(e);
+    }
+    for (unsigned j=0; j<H; j++) {
+        for (unsigned i1=0; i1<P; i1++) {
+            for (unsigned i2=i1+1; i2<P; i2++) {
+                ExprPtr e = Expression::mkOr(Expression::mkNot(x[i1][j]),
+                                             Expression::mkNot(x[i2][j]));
+                e->setHard();
+                solver->addToContext(e);
+            }
+        }
+    }
+    ExprPtr a = Expression::mkBoolVar("a");
+    a->setSoft();
+    solver->addToContext(a);
+    
+    // The budget runs out -> UNDEF, the worker is killed
+    PortfolioSolver *portfolio = new PortfolioSolver(1);
+    portfolio->setTimeout(100);
+    EXPECT_TRUE(portfolio->hasBudget());
+    EXPECT_EQ(portfolio->maxSat(solver), l_undef);
+    EXPECT_EQ(portfolio->getNbTimeouts(), 1);
+    
+    // The context of the current process is unchanged
+    EXPECT_EQ(solver->getSoftExpressions().size(), 1);
+    
+    delete portfolio;
+    solver->clean();
+    delete solver;
+}
+
 // Testing makeYicesExpression()
 /*TEST(YicesSolverTest, YicesSolverMkExpr) {
     